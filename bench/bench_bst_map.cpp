@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "timer.hpp"
+#include "bst_map.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+
+
+//Puts keys (in order) into an empty map, then looks each one up; returns the seconds taken
+template<class Map>
+double insert_lookup(const std::vector<int>& keys, long long& sum) {
+  double start = now();
+  Map m;
+  for (int k : keys)
+    m.put(k, k);
+  for (int k : keys)
+    sum += m[k];
+  return now()-start;
+}
+
+
+template<bool balanced>
+void run(const char* label, const std::vector<int>& keys, long long& sum) {
+  std::printf("%-10s %7zu keys: %.4fs\n", label, keys.size(),
+              insert_lookup<ics::BSTMap<int,int,lt_int,balanced>>(keys,sum));
+}
+
+
+//Sorted, reverse-sorted, zig-zag (1,N,2,N-1,...) and random puts followed by a lookup of each
+//  key, in AVL-balanced mode for N keys (default 1M) and in unbalanced mode for at most 20,000
+//  keys: adversarial input makes the unbalanced tree a list, so its time grows as N^2
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  long long sum = 0;
+  Random r;
+  for (int size : {std::min(n,20000), n}) {
+    std::vector<int> ascending(size), descending(size), zigzag(size), random(size);
+    for (int i = 0; i < size; ++i) {
+      ascending[i]  = i;
+      descending[i] = size-1-i;
+      zigzag[i]     = i%2 == 0 ? i/2 : size-1-i/2;
+      random[i]     = r.next(1000000000);
+    }
+    std::printf("AVL-balanced:\n");
+    run<true>("ascending",  ascending,  sum);
+    run<true>("descending", descending, sum);
+    run<true>("zig-zag",    zigzag,     sum);
+    run<true>("random",     random,     sum);
+    if (size <= 20000) {
+      std::printf("unbalanced:\n");
+      run<false>("ascending",  ascending,  sum);
+      run<false>("descending", descending, sum);
+      run<false>("zig-zag",    zigzag,     sum);
+      run<false>("random",     random,     sum);
+    }
+  }
+  std::printf("(%lld)\n", sum%3);
+}
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "timer.hpp"
+#include "bst_map.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+
+
+template<class Map>
+double put_each(Map& m, const std::vector<typename Map::Entry>& entries, long long& sum) {
+  double start = now();
+  for (const typename Map::Entry& e : entries)
+    m.put(e.first, e.second);
+  sum += m.size();
+  return now()-start;
+}
+
+
+template<class Map>
+double from_sorted(Map& m, const std::vector<typename Map::Entry>& entries, long long& sum) {
+  double start = now();
+  m = Map::from_sorted(entries);
+  sum += m.size();
+  return now()-start;
+}
+
+
+template<class Map>
+double put_all_sorted(Map& m, const std::vector<typename Map::Entry>& entries, long long& sum) {
+  double start = now();
+  sum += m.put_all_sorted(entries) + m.size();
+  return now()-start;
+}
+
+
+template<bool balanced, bool ranked>
+void compare(const char* label, int n, long long& sum) {
+  typedef ics::BSTMap<int,int,lt_int,balanced,ranked> Map;
+  std::vector<typename Map::Entry> evens, odds;
+  for (int i = 0; i < n; ++i) {
+    evens.push_back(typename Map::Entry(2*i,i));
+    odds.push_back(typename Map::Entry(2*i+1,i));
+  }
+  Map put_built, sorted_built;
+  double build_put    = put_each(put_built,evens,sum);
+  double build_sorted = from_sorted(sorted_built,evens,sum);
+  double merge_put    = put_each(put_built,odds,sum);
+  double merge_sorted = put_all_sorted(sorted_built,odds,sum);
+  std::printf("%-20s %7d: build put %.4fs  from_sorted %.4fs   merge %d put %.4fs  put_all_sorted %.4fs\n",
+              label, n, build_put, build_sorted, n, merge_put, merge_sorted);
+}
+
+
+//Builds a map from N sorted entries, and merges N sorted entries into a map of N other keys,
+//  with put_all_sorted against one put per entry; balanced (AVL) and ranked maps for N
+//  (default 1M), and unbalanced maps, where sorted puts make a chain, for at most 20,000
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  long long sum = 0;
+  for (int run = 0; run < 2; ++run) {
+    compare<false,false>("unbalanced",         std::min(n,20000), sum);
+    compare<true,false> ("balanced",           std::min(n,20000), sum);
+    compare<true,false> ("balanced",           n, sum);
+    compare<true,true>  ("balanced and ranked",n, sum);
+  }
+  std::printf("(%lld)\n", sum%3);
+}
@@ -0,0 +1,51 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "timer.hpp"
+#include "bst_map.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+typedef ics::BSTMap<int,int,lt_int> IntMap;
+
+
+//Times each whole-tree walk on m: copy, ==, has_value (a miss), str, and the destructor
+void walks(const char* label, const IntMap& m, long long& sum) {
+  double start = now();
+  IntMap* copy = new IntMap(m);
+  double copied = now();
+  sum += *copy == m;
+  double compared = now();
+  sum += copy->has_value(-1);
+  double searched = now();
+  sum += copy->str().size();
+  double printed = now();
+  delete copy;
+  double deleted = now();
+  std::printf("%-10s %7d keys: copy %.4fs  == %.4fs  has_value %.4fs  str %.4fs  destructor %.4fs\n",
+              label, m.size(), copied-start, compared-copied, searched-compared, printed-searched, deleted-printed);
+}
+
+
+//The whole-tree walks on an unbalanced map of N random keys (default 1M), and on one made a
+//  chain by N sorted keys (at most 40,000, as building the chain with put is O(N^2)): all of
+//  them are iterative, so a chain costs the same O(N) and cannot overflow the call stack
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  long long sum = 0;
+  Random r;
+  IntMap random, chain;
+  for (int i = 0; i < n; ++i)
+    random.put(r.next(1000000000), i);
+  for (int i = 0; i < std::min(n,40000); ++i)
+    chain.put(i, i);
+  IntMap small_random;
+  for (int i = 0; small_random.size() < chain.size(); ++i)
+    small_random.put(r.next(1000000000), i);
+  for (int run = 0; run < 2; ++run) {
+    walks("random", random, sum);
+    walks("random", small_random, sum);
+    walks("chain",  chain,  sum);
+  }
+  std::printf("(%lld)\n", sum%3);
+}
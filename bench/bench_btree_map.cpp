@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "timer.hpp"
+#include "bst_map.hpp"
+#include "btree_map.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+bool lt_string(const std::string& a, const std::string& b) {return a < b;}
+
+
+template<class Map, class KEY>
+void compare(const char* label, const std::vector<KEY>& keys, long long& sum) {
+  double start = now();
+  Map m;
+  for (int i = 0; i < (int)keys.size(); ++i)
+    m.put(keys[i], i);
+  double inserted = now();
+  for (const KEY& k : keys)
+    sum += m[k];
+  double found = now();
+  for (const typename Map::Entry& e : m)
+    sum += e.second;
+  double scanned = now();
+  for (int i = 0; i < (int)keys.size(); i += 2)
+    sum += m.has_key(keys[i]+keys[i]);         //Mostly misses
+  double missed = now();
+  std::printf("%-20s insert %.3fs  lookup %.3fs  scan %.4fs  miss %.3fs\n",
+              label, inserted-start, found-inserted, scanned-found, missed-scanned);
+}
+
+
+//A BTreeMap against the unbalanced and AVL-balanced BSTMap: N (default 1M) random int and
+//  string keys are put, each looked up, all scanned in order, and N/2 absent keys searched for
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  long long sum = 0;
+  Random r;
+  std::vector<int> ints(n);
+  std::vector<std::string> strings(n);
+  for (int i = 0; i < n; ++i) {
+    ints[i]    = r.next(1000000000);
+    strings[i] = "key " + std::to_string(ints[i]);
+  }
+  for (int run = 0; run < 2; ++run) {
+    std::printf("%d int keys:\n", n);
+    compare<ics::BSTMap<int,int,lt_int>>            ("BSTMap",          ints, sum);
+    compare<ics::BSTMap<int,int,lt_int,true>>       ("BSTMap balanced", ints, sum);
+    compare<ics::BTreeMap<int,int,lt_int>>          ("BTreeMap",        ints, sum);
+    std::printf("%d string keys:\n", n);
+    compare<ics::BSTMap<std::string,int,lt_string>>      ("BSTMap",          strings, sum);
+    compare<ics::BSTMap<std::string,int,lt_string,true>> ("BSTMap balanced", strings, sum);
+    compare<ics::BTreeMap<std::string,int,lt_string>>    ("BTreeMap",        strings, sum);
+  }
+  std::printf("(%lld)\n", sum%3);
+}
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "timer.hpp"
+#include "hash_map.hpp"
+#include "open_hash_map.hpp"
+#include "bst_map.hpp"
+#include "btree_map.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+bool lt_int(const int& a, const int& b) {return a < b;}
+int  hash_int(const int& a) {return a;}
+struct HashInt {int operator () (const int& a) const {return a;}};
+
+
+template<class PQ>
+double enqueue_drain(PQ pq, const std::vector<int>& v) {
+  double start = now();
+  for (int x : v)
+    pq.enqueue(x);
+  long long sum = 0;
+  while (!pq.empty())
+    sum += pq.dequeue();
+  return now()-start + (sum == 42 ? 1 : 0);       //Use sum, so the drain is not optimized away
+}
+
+
+template<class Map>
+double put_lookup(Map m, const std::vector<int>& v) {
+  double start = now();
+  for (int x : v)
+    m.put(x,x);
+  long long sum = 0;
+  for (int x : v)
+    sum += m[x];
+  return now()-start + (sum == 42 ? 1 : 0);
+}
+
+
+//The same container three ways: comparator/hasher supplied at run time (called through
+//  the stored pointer), as a function-pointer template argument, and as a functor type
+int main() {
+  Random r(1);
+  std::vector<int> v(1000000);
+  for (int& x : v)
+    x = r.next(100000000);
+
+  for (int run = 0; run < 2; ++run) {
+    std::printf("HeapPriorityQueue enqueue+drain 1M: runtime %.3fs  template %.3fs  functor %.3fs\n",
+                enqueue_drain(ics::HeapPriorityQueue<int>(gt_int),v),
+                enqueue_drain(ics::HeapPriorityQueue<int,gt_int>(),v),
+                enqueue_drain(ics::HeapPriorityQueue<int,ics::undefinedgt<int>,std::greater<int>>(),v));
+    std::printf("BSTMap (AVL) put+lookup 1M:         runtime %.3fs  template %.3fs  functor %.3fs\n",
+                put_lookup(ics::BSTMap<int,int,ics::undefinedlt<int>,true>(lt_int),v),
+                put_lookup(ics::BSTMap<int,int,lt_int,true>(),v),
+                put_lookup(ics::BSTMap<int,int,ics::undefinedlt<int>,true,false,std::less<int>>(),v));
+    std::printf("BTreeMap put+lookup 1M:             runtime %.3fs  template %.3fs  functor %.3fs\n",
+                put_lookup(ics::BTreeMap<int,int>(lt_int),v),
+                put_lookup(ics::BTreeMap<int,int,lt_int>(),v),
+                put_lookup(ics::BTreeMap<int,int,ics::undefinedlt<int>,std::less<int>>(),v));
+    std::printf("HashMap put+lookup 1M:              runtime %.3fs  template %.3fs  functor %.3fs\n",
+                put_lookup(ics::HashMap<int,int>(1.0,hash_int),v),
+                put_lookup(ics::HashMap<int,int,hash_int>(),v),
+                put_lookup(ics::HashMap<int,int,ics::undefinedhash<int>,HashInt>(),v));
+    std::printf("OpenHashMap put+lookup 1M:          runtime %.3fs  template %.3fs  functor %.3fs\n",
+                put_lookup(ics::OpenHashMap<int,int>(0.875,hash_int),v),
+                put_lookup(ics::OpenHashMap<int,int,hash_int>(),v),
+                put_lookup(ics::OpenHashMap<int,int,ics::undefinedhash<int>,HashInt>(),v));
+  }
+}
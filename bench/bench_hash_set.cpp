@@ -0,0 +1,29 @@
+#include <iostream>
+#include "timer.hpp"
+#include "hash_set.hpp"
+
+
+int hash_int(const int& i) {return i;}
+
+
+//insert/contains/erase are single-bin operations: ns per call should stay flat as N grows
+//  (apart from cache misses once the table outgrows the caches)
+int main() {
+  for (int n : {100000, 1000000, 10000000}) {
+    ics::HashSet<int,hash_int> s;
+    double start = now();
+    for (int i = 0; i < n; ++i)
+      s.insert(3*i);
+    double inserted = now();
+    int hits = 0;
+    for (int i = 0; i < n; ++i)
+      hits += s.contains(i);
+    double searched = now();
+    for (int i = 0; i < n; ++i)
+      s.erase(3*i);
+    double erased = now();
+    std::cout << "N=" << n << ": ns per insert " << (inserted-start)/n*1e9
+              << ", contains " << (searched-inserted)/n*1e9 << " (" << hits << " hits)"
+              << ", erase " << (erased-searched)/n*1e9 << std::endl;
+  }
+}
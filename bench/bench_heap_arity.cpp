@@ -0,0 +1,39 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+
+
+template<int arity>
+void enqueue_dequeue(const std::vector<int>& v, int n) {
+  ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,arity> pq;
+  double start = now();
+  for (int i = 0; i < n; ++i)
+    pq.enqueue(v[i]);
+  double enqueued = now();
+  long long sum = 0;
+  while (!pq.empty())
+    sum += pq.dequeue();
+  double dequeued = now();
+  std::printf("  arity %d: enqueue %.3fs  dequeue %.3fs  (%lld)\n", arity, enqueued-start, dequeued-enqueued, sum%7);
+}
+
+
+//Enqueue N random ints then dequeue them all, at N = 1M, 10M, ... up to the argument (default 10M)
+int main(int argc, char** argv) {
+  int max_n = argc > 1 ? std::atoi(argv[1]) : 10000000;
+  Random r(3);
+  std::vector<int> v(max_n);
+  for (int& x : v)
+    x = r.next(1 << 30);
+  for (int n = 1000000; n <= max_n; n *= 10) {
+    std::printf("N=%d\n", n);
+    enqueue_dequeue<2>(v,n);
+    enqueue_dequeue<4>(v,n);
+    enqueue_dequeue<8>(v,n);
+  }
+}
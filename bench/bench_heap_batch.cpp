@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <iterator>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+typedef ics::HeapPriorityQueue<int,gt_int> IntPQ;
+
+
+//dequeue_batch, top_k, merge and enqueue_all against the loops they replace, on 1M queued ints
+int main() {
+  const int n = 1000000;
+  Random r(3);
+  std::vector<int> v(n);
+  for (int& x : v)
+    x = r.next(1 << 30);
+  IntPQ base(v);
+
+  for (int k : {64, n/100, n/10, n/2, n}) {
+    IntPQ a(base), b(base);
+    std::vector<int> out;
+    out.reserve(n);
+    double start = now();
+    for (int j = 0; j < k; ++j)
+      out.push_back(a.dequeue());
+    double looped = now();
+    out.clear();
+    b.dequeue_batch(k, std::back_inserter(out));
+    double batched = now();
+    std::printf("dequeue %d of %d: loop %.4fs  dequeue_batch %.4fs\n", k, n, looped-start, batched-looped);
+  }
+
+  for (int k : {64, 1000, n/10}) {
+    double start = now();
+    std::vector<int> out;
+    {
+      IntPQ copy(base);
+      for (int j = 0; j < k; ++j)
+        out.push_back(copy.dequeue());
+    }
+    double copied = now();
+    std::vector<int> top = base.top_k(k);
+    double topped = now();
+    std::printf("top %d: copy+dequeue %.5fs  top_k %.5fs\n", k, copied-start, topped-copied);
+  }
+
+  for (bool all_higher : {false, true}) {
+    std::vector<int> w(n);
+    for (int& x : w)
+      x = all_higher ? (1 << 30) + r.next(1 << 29) : r.next(1 << 30);
+    IntPQ other(w), looped(base), merged(base);
+    double start = now();
+    for (auto i = other.unordered_begin(); i != other.unordered_end(); ++i)
+      looped.enqueue(*i);
+    double enqueued = now();
+    merged.merge(other);
+    double done = now();
+    std::printf("merge %d into %d (%s): enqueue loop %.4fs  merge %.4fs\n",
+                n, n, all_higher ? "all higher" : "random", enqueued-start, done-enqueued);
+  }
+
+  for (int m : {125000, 4000000}) {
+    std::vector<int> ascending(m);
+    for (int i = 0; i < m; ++i)
+      ascending[i] = i;
+    IntPQ looped, all;
+    double start = now();
+    for (int x : ascending)
+      looped.enqueue(x);
+    double enqueued = now();
+    all.enqueue_all(ascending);
+    double done = now();
+    std::printf("enqueue %d ascending: loop %.4fs  enqueue_all %.4fs\n", m, enqueued-start, done-enqueued);
+  }
+}
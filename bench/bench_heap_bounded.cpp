@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+
+typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,2,false,false,true> Bounded;
+typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,2,false,true,true>  BoundedStable;
+
+
+template<class PQ>
+double best_bounded(long long n, int k, std::vector<int>& best) {
+  Random r;
+  double start = now();
+  PQ pq(k);
+  for (long long i = 0; i < n; ++i)
+    pq.enqueue(r.next(1000000000));
+  best = pq.drain_sorted();
+  return now()-start;
+}
+
+
+double best_full(long long n, int k, std::vector<int>& best) {
+  Random r;
+  double start = now();
+  ics::HeapPriorityQueue<int,gt_int> pq;
+  for (long long i = 0; i < n; ++i)
+    pq.enqueue(r.next(1000000000));
+  best.clear();
+  pq.dequeue_batch(k,std::back_inserter(best));
+  return now()-start;
+}
+
+
+//The best K (default 1000) of a stream of N keys: a bounded queue against a full heap plus
+//  dequeue_batch (skipped above 20M keys, where the full heap's memory dominates)
+int main(int argc, char** argv) {
+  int k = argc > 1 ? std::atoi(argv[1]) : 1000;
+  for (long long n : {10000000LL, 20000000LL, 100000000LL}) {
+    Random r;
+    double start = now();
+    long long sum = 0;
+    for (long long i = 0; i < n; ++i)
+      sum += r.next(1000000000);
+    double generate = now()-start;
+
+    std::vector<int> bounded, stable, full;
+    double tb = best_bounded<Bounded>(n,k,bounded);
+    double ts = best_bounded<BoundedStable>(n,k,stable);
+    double tf = -1;
+    if (n <= 20000000)
+      tf = best_full(n,k,full);
+    if (bounded != stable || (tf >= 0 && bounded != full))
+      std::printf("MISMATCH\n");
+    std::printf("best %d of %lld: bounded %.3fs  bounded stable %.3fs  full heap+dequeue_batch %.3fs  (generate only %.3fs) (%lld)\n",
+                k, n, tb, ts, tf, generate, sum%3);
+  }
+}
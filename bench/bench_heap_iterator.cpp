@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int   (const int& a, const int& b)                 {return a > b;}
+bool gt_string(const std::string& a, const std::string& b) {return a > b;}
+
+
+long long weight(int x)                {return x;}
+long long weight(const std::string& s) {return s.size();}
+
+
+//Walk the whole queue in priority order (or only its first k values)
+template<class PQ>
+double traverse(const PQ& pq, int k, long long& sum) {
+  double start = now();
+  int count = 0;
+  for (auto i = pq.begin(); count < k && i != pq.end(); ++i, ++count)
+    sum += weight(*i);
+  return now()-start;
+}
+
+
+template<class PQ>
+double traverse_unordered(const PQ& pq, long long& sum) {
+  double start = now();
+  for (auto i = pq.unordered_begin(); i != pq.unordered_end(); ++i)
+    sum += weight(*i);
+  return now()-start;
+}
+
+
+//One pass in priority order, erasing every other value
+double erase_alternate(int n, long long& sum) {
+  Random r(n);
+  ics::HeapPriorityQueue<int,gt_int> pq;
+  for (int j = 0; j < n; ++j)
+    pq.enqueue(r.next(1000000000));
+  double start = now();
+  bool erase = false;
+  for (auto i = pq.begin(); i != pq.end(); ++i, erase = !erase)
+    if (erase)
+      sum += i.erase();
+  return now()-start;
+}
+
+
+//The priority-order Iterator over N (default 1M) ints and strings, against the UnorderedIterator,
+//  and erasing every other value during one pass for growing N
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  long long sum = 0;
+  Random r;
+  ics::HeapPriorityQueue<int,gt_int> ints;
+  ics::HeapPriorityQueue<std::string,gt_string> strings;
+  for (int j = 0; j < n; ++j) {
+    int x = r.next(1000000000);
+    ints.enqueue(x);
+    strings.enqueue("value " + std::to_string(x));
+  }
+  for (int run = 0; run < 2; ++run) {
+    std::printf("N=%d ints:    first 1000 %.4fs  all %.3fs  unordered %.4fs\n",
+                n, traverse(ints,1000,sum), traverse(ints,n,sum), traverse_unordered(ints,sum));
+    std::printf("N=%d strings: first 1000 %.4fs  all %.3fs  unordered %.4fs\n",
+                n, traverse(strings,1000,sum), traverse(strings,n,sum), traverse_unordered(strings,sum));
+  }
+
+  for (int m : {10000, 20000, 40000, 80000, 1000000})
+    std::printf("erase every other value of %d: %.3fs\n", m, erase_alternate(m,sum));
+  std::printf("(%lld)\n", sum%3);
+}
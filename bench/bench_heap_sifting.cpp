@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+
+
+static long long comparisons = 0;
+bool counted_gt(const int& a, const int& b) {++comparisons; return a > b;}
+bool gt_int(const int& a, const int& b) {return a > b;}
+bool gt_string(const std::string& a, const std::string& b) {return a > b;}
+
+
+template<class T, bool (*gt)(const T& a, const T& b)>
+void time_heap(const char* name, const std::vector<T>& v) {
+  ics::HeapPriorityQueue<T,gt> pq;
+  double start = now();
+  for (const T& x : v)
+    pq.enqueue(x);
+  double enqueued = now();
+  std::size_t dequeued_count = 0;
+  while (!pq.empty()) {
+    pq.dequeue();
+    ++dequeued_count;
+  }
+  double dequeued = now();
+  ics::HeapPriorityQueue<T,gt> heapified(v);
+  double built = now();
+  std::printf("%s N=%zu: enqueue %.3fs  dequeue %.3fs  heapify %.3fs  (%zu dequeued)\n",
+              name, v.size(), enqueued-start, dequeued-enqueued, built-dequeued, dequeued_count);
+}
+
+
+//Hole-based sifting and Floyd's bounce dequeue: comparisons per operation, then timings
+//  for cheap (int) and expensive (30-char string) comparisons
+int main() {
+  Random r(3);
+  const int n = 1000000;
+  ics::HeapPriorityQueue<int,counted_gt> counted;
+  for (int i = 0; i < n; ++i)
+    counted.enqueue(r.next(1 << 30));
+  long long enqueue_comparisons = comparisons;
+  comparisons = 0;
+  while (!counted.empty())
+    counted.dequeue();
+  std::printf("N=%d comparisons per op: enqueue %.2f  dequeue %.2f\n", n, (double)enqueue_comparisons/n, (double)comparisons/n);
+
+  std::vector<int> ints(10000000);
+  for (int& x : ints)
+    x = r.next(1 << 30);
+  time_heap<int,gt_int>("int", ints);
+
+  std::vector<std::string> strings(2500000);
+  for (std::string& s : strings)
+    for (int i = 0; i < 30; ++i)
+      s += char('a' + r.next(26));
+  time_heap<std::string,gt_string>("string", strings);
+}
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+
+//The hand-rolled alternative to stable mode: (priority, sequence) pairs in the array
+typedef std::pair<int,unsigned long long> Sequenced;
+bool gt_sequenced(const Sequenced& a, const Sequenced& b) {return a.first > b.first || (a.first == b.first && a.second < b.second);}
+
+
+template<class PQ>
+double enqueue_drain(const std::vector<int>& v, long long& sum) {
+  double start = now();
+  PQ pq;
+  for (int x : v)
+    pq.enqueue(x);
+  while (!pq.empty())
+    sum += pq.dequeue();
+  return now()-start;
+}
+
+
+double enqueue_drain_sequenced(const std::vector<int>& v, long long& sum) {
+  double start = now();
+  ics::HeapPriorityQueue<Sequenced,gt_sequenced> pq;
+  for (std::size_t i = 0; i < v.size(); ++i)
+    pq.enqueue(Sequenced(v[i],i));
+  while (!pq.empty())
+    sum += pq.dequeue().first;
+  return now()-start;
+}
+
+
+//Stable mode against a plain queue and against the (priority, sequence) pair, with few
+//  (100) and many (1e9) distinct priorities; N defaults to 1M
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  long long sum = 0;
+  for (int range : {100, 1000000000}) {
+    Random r(range);
+    std::vector<int> v(n);
+    for (int& x : v)
+      x = r.next(range);
+    for (int run = 0; run < 2; ++run) {
+      double plain   = enqueue_drain<ics::HeapPriorityQueue<int,gt_int>>(v,sum);
+      double stable  = enqueue_drain<ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,2,false,true>>(v,sum);
+      double paired  = enqueue_drain_sequenced(v,sum);
+      double plain4  = enqueue_drain<ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,4>>(v,sum);
+      double stable4 = enqueue_drain<ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,4,false,true>>(v,sum);
+      std::printf("N=%d priorities in [0,%d): plain %.3fs  stable %.3fs  pair<int,u64> %.3fs | arity 4: plain %.3fs  stable %.3fs\n",
+                  n, range, plain, stable, paired, plain4, stable4);
+    }
+  }
+  std::printf("(%lld)\n", sum%3);
+}
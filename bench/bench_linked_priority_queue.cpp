@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "timer.hpp"
+#include "linked_priority_queue.hpp"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+
+
+//Skip-list LinkedPriorityQueue against HeapPriorityQueue: load N random ints, then drain
+//  them, for N = 20K ... 1M (or up to the argument)
+int main(int argc, char** argv) {
+  int max_n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  Random r(1);
+  long long sum = 0;
+  for (int n : {20000, 50000, 200000, 1000000}) {
+    if (n > max_n)
+      break;
+    std::vector<int> v(n);
+    for (int& x : v)
+      x = r.next(1 << 30);
+
+    double start = now();
+    ics::LinkedPriorityQueue<int,gt_int> linked;
+    for (int x : v)
+      linked.enqueue(x);
+    double linked_loaded = now();
+    while (!linked.empty())
+      sum += linked.dequeue();
+    double linked_drained = now();
+
+    ics::HeapPriorityQueue<int,gt_int> heap;
+    for (int x : v)
+      heap.enqueue(x);
+    double heap_loaded = now();
+    while (!heap.empty())
+      sum += heap.dequeue();
+    double heap_drained = now();
+
+    std::printf("N=%d linked: load %.4fs  drain %.4fs | heap: load %.4fs  drain %.4fs\n", n,
+                linked_loaded-start, linked_drained-linked_loaded, heap_loaded-linked_drained, heap_drained-heap_loaded);
+  }
+  std::printf("(%lld)\n", sum%7);
+}
@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "timer.hpp"
+#include "linked_queue.hpp"
+#include "bst_map.hpp"
+#include "hash_map.hpp"
+
+
+bool lt_int  (const int& a, const int& b) {return a < b;}
+int  hash_int(const int& i)               {return i;}
+
+
+//A queue that stays about n long while 10n values pass through it
+double queue_churn(int n, long long& sum) {
+  double start = now();
+  ics::LinkedQueue<int> q;
+  for (int i = 0; i < n; ++i)
+    q.enqueue(i);
+  for (int i = 0; i < 10*n; ++i) {
+    sum += q.dequeue();
+    q.enqueue(i);
+  }
+  return now()-start;
+}
+
+
+//Random puts and erases that keep a map at about n keys
+template<class Map>
+double map_churn(Map& m, int n, long long& sum) {
+  Random r(n);
+  double start = now();
+  for (int i = 0; i < n; ++i)
+    m.put(r.next(2*n), i);
+  for (int i = 0; i < 10*n; ++i) {
+    int k = r.next(2*n);
+    if (m.has_key(k))
+      sum += m.erase(k);
+    else
+      m.put(k, i);
+  }
+  return now()-start;
+}
+
+
+//One thread enqueues, another dequeues (so frees) the same nodes, in rounds of n
+double cross_thread(int n, long long& sum) {
+  double start = now();
+  for (int round = 0; round < 10; ++round) {
+    ics::LinkedQueue<int>* q = new ics::LinkedQueue<int>;
+    std::thread producer([q,n] {for (int i = 0; i < n; ++i) q->enqueue(i);});
+    producer.join();
+    std::thread consumer([q,&sum] {while (!q->empty()) sum += q->dequeue();});
+    consumer.join();
+    delete q;
+  }
+  return now()-start;
+}
+
+
+//The same node churn with the pool and with the global allocator: build once as is and once
+//  with -DICS_NO_NODE_POOL, and compare the two runs. N defaults to 1M
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+#ifdef ICS_NO_NODE_POOL
+  const char* allocator = "::operator new";
+#else
+  const char* allocator = "NodePool";
+#endif
+  long long sum = 0;
+  for (int run = 0; run < 2; ++run) {
+    ics::BSTMap<int,int,lt_int>   tree;
+    ics::HashMap<int,int,hash_int> table;
+    double queue   = queue_churn(n,sum);
+    double bst     = map_churn(tree,n/4,sum);
+    double hash    = map_churn(table,n,sum);
+    double threads = cross_thread(n,sum);
+    std::printf("%s, N=%d: LinkedQueue %.3fs  BSTMap %.3fs  HashMap %.3fs  cross-thread LinkedQueue %.3fs\n",
+                allocator, n, queue, bst, hash, threads);
+  }
+  std::printf("(%lld)\n", sum%3);
+}
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include "timer.hpp"
+#include "heap_priority_queue.hpp"
+#include "linked_priority_queue.hpp"
+#include "pairing_priority_queue.hpp"
+#include "radix_priority_queue.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+unsigned long long key_int(const int& a) {return (unsigned int)a;}
+
+typedef std::pair<int,int> Distance;                 //(distance, node)
+bool lt_distance(const Distance& a, const Distance& b) {return a.first < b.first;}
+unsigned long long key_distance(const Distance& a) {return (unsigned int)a.first;}
+
+
+template<class PQ>
+double enqueue_drain(const std::vector<int>& v, long long& sum) {
+  double start = now();
+  PQ pq;
+  for (int x : v)
+    pq.enqueue(x);
+  while (!pq.empty())
+    sum += pq.dequeue();
+  return now()-start;
+}
+
+
+//Lazy-deletion Dijkstra from node 0 over the graph in (edge_start, to, weight) form
+template<class PQ>
+double dijkstra(int n, const std::vector<int>& edge_start, const std::vector<int>& to, const std::vector<int>& weight, long long& sum) {
+  double start = now();
+  std::vector<int> dist(n, 2147483647);
+  PQ pq;
+  dist[0] = 0;
+  pq.enqueue(Distance(0,0));
+  while (!pq.empty()) {
+    Distance d = pq.dequeue();
+    if (d.first > dist[d.second])
+      continue;
+    for (int e = edge_start[d.second]; e < edge_start[d.second+1]; ++e)
+      if (d.first+weight[e] < dist[to[e]]) {
+        dist[to[e]] = d.first+weight[e];
+        pq.enqueue(Distance(dist[to[e]],to[e]));
+      }
+  }
+  for (int x : dist)
+    sum += x;
+  return now()-start;
+}
+
+
+//The four priority queues on random enqueue/drain, O(1) merge, and Dijkstra on a random
+//  graph with N nodes and 4N edges (N defaults to 1M)
+int main(int argc, char** argv) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  Random r(1);
+  long long sum = 0;
+  std::vector<int> v(n);
+  for (int& x : v)
+    x = r.next(1000000000);
+
+  std::printf("enqueue+drain %d random: heap %.3fs  pairing %.3fs  radix %.3fs\n", n,
+              enqueue_drain<ics::HeapPriorityQueue<int,lt_int>>(v,sum),
+              enqueue_drain<ics::PairingPriorityQueue<int,lt_int>>(v,sum),
+              enqueue_drain<ics::RadixPriorityQueue<int,key_int>>(v,sum));
+  std::vector<int> small(v.begin(), v.begin()+std::min(n,20000));
+  std::printf("enqueue+drain %zu random: linked %.4fs  heap %.4fs  pairing %.4fs  radix %.4fs\n", small.size(),
+              enqueue_drain<ics::LinkedPriorityQueue<int,lt_int>>(small,sum),
+              enqueue_drain<ics::HeapPriorityQueue<int,lt_int>>(small,sum),
+              enqueue_drain<ics::PairingPriorityQueue<int,lt_int>>(small,sum),
+              enqueue_drain<ics::RadixPriorityQueue<int,key_int>>(small,sum));
+
+  {
+    std::vector<int> a(v.begin(), v.begin()+n/2), b(v.begin()+n/2, v.end());
+    ics::HeapPriorityQueue<int,lt_int> heap_a(a), heap_b(b);
+    ics::PairingPriorityQueue<int,lt_int> pairing_a(a), pairing_b(b);
+    double start = now();
+    heap_a.merge(std::move(heap_b));
+    double heap_merged = now();
+    pairing_a.merge(std::move(pairing_b));
+    double pairing_merged = now();
+    std::printf("merge %d into %d: heap %.5fs  pairing %.7fs\n", n/2, n/2, heap_merged-start, pairing_merged-heap_merged);
+  }
+
+  int m = 4*n;
+  std::vector<int> edge_start(n+1), to(m), weight(m);
+  for (int i = 0; i <= n; ++i)
+    edge_start[i] = 4*i;
+  for (int e = 0; e < m; ++e) {
+    to[e]     = r.next(n);
+    weight[e] = 1+r.next(1000);
+  }
+  long long heap_sum = 0, pairing_sum = 0, radix_sum = 0;
+  double heap    = dijkstra<ics::HeapPriorityQueue<Distance,lt_distance>>(n,edge_start,to,weight,heap_sum);
+  double pairing = dijkstra<ics::PairingPriorityQueue<Distance,lt_distance>>(n,edge_start,to,weight,pairing_sum);
+  double radix   = dijkstra<ics::RadixPriorityQueue<Distance,key_distance>>(n,edge_start,to,weight,radix_sum);
+  std::printf("dijkstra %d nodes %d edges: heap %.3fs  pairing %.3fs  radix %.3fs%s\n", n, m, heap, pairing, radix,
+              heap_sum == pairing_sum && heap_sum == radix_sum ? "" : "  (DISTANCES DIFFER)");
+  std::printf("(%lld)\n", sum%10);
+}
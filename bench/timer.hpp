@@ -0,0 +1,22 @@
+#ifndef BENCH_TIMER_HPP_
+#define BENCH_TIMER_HPP_
+
+#include <chrono>
+
+
+//Seconds on a monotonic clock: time a step as (now() - start)
+inline double now() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+//A fixed xorshift stream, so each run (and each structure compared) sees the same keys
+class Random {
+  public:
+    explicit Random(unsigned int seed = 2463534242u) : x(seed) {}
+    int next (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % (unsigned int)bound);}
+  private:
+    unsigned int x;
+};
+
+#endif /* BENCH_TIMER_HPP_ */
@@ -10,9 +10,14 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <algorithm>            //std::max
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
 #include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
 #include "pair.hpp"
 #include "array_queue.hpp"   //For traversal
+#include "array_stack.hpp"   //For Iterator
 
 
 namespace ics {
@@ -24,12 +29,31 @@ template<class T>
 bool undefinedlt (const T& a, const T& b) {return false;}
 #endif /* undefinedltdefined */
 
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
 //Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
 //If tgt is defaulted to undefinedlt in the template, then a constructor must supply cgt.
 //If both tlt and clt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-undefinedlt value supplied by tlt/clt is stored in the instance variable gt.
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedlt<KEY>> class BSTMap {
+//Alternatively, leave tlt defaulted and supply a stateless functor type LT (e.g., std::less<KEY>, or a
+//  lambda's type in C++20): LT()(...) is then called directly, so it can be inlined (as is a
+//  tlt template argument); only a clt supplied at run time is called through the pointer lt.
+//Supplying both tlt and LT is a compile-time error.
+//If balanced is true, the tree is kept AVL-balanced (every node's subtrees differ in height
+//  by at most 1), so put/erase/has_key are O(log N) even when keys arrive in sorted order;
+//  if false (the default), nodes are never rotated and the tree's shape is its insertion order.
+//If ranked is true, each node also caches the size of its subtree, so select/rank/count_range
+//  are O(height); calling them on a map that is not ranked is a compile-time error.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedlt<KEY>, bool balanced = false, bool ranked = false, class LT = undefinedfunctor> class BSTMap {
   public:
     typedef pair<KEY,T> Entry;
     typedef bool (*ltfunc) (const KEY& a, const KEY& b);
@@ -38,13 +62,18 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedl
     ~BSTMap();
 
     BSTMap          (bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
-    BSTMap          (const BSTMap<KEY,T,tlt>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+    BSTMap          (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+    BSTMap          (BSTMap<KEY,T,tlt,balanced,ranked,LT>&& to_move);   //O(1): takes to_move's tree, leaving it empty
     explicit BSTMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
     explicit BSTMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
 
+    //Returns a map built by put_all_sorted(i): O(N) and perfectly balanced when i is sorted
+    template <class Iterable>
+    static BSTMap<KEY,T,tlt,balanced,ranked,LT> from_sorted (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+
 
     //Queries
     bool empty      () const;
@@ -56,55 +85,82 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedl
 
     //Commands
     T    put   (const KEY& key, const T& value);
+    T    put   (const KEY& key, T&& value);
     T    erase (const KEY& key);
     void clear ();
 
+    //Like put, but the value is T(args...) moved into key's node; returns a reference to it
+    template <class... Args>
+    T&   emplace (const KEY& key, Args&&... args);
+
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
     int put_all(const Iterable& i);
 
+    //If i's keys are strictly increasing by lt, rebuilds the map as a perfectly balanced tree
+    //  in O(size()+N) (merging in the existing entries; i's values win for equal keys);
+    //  otherwise it is the same as put_all(i). The Iterable/initializer_list constructors use it.
+    template <class Iterable>
+    int put_all_sorted(const Iterable& i);
+
 
     //Operators
 
     T&       operator [] (const KEY&);
     const T& operator [] (const KEY&) const;
-    BSTMap<KEY,T,tlt>& operator = (const BSTMap<KEY,T,tlt>& rhs);
-    bool operator == (const BSTMap<KEY,T,tlt>& rhs) const;
-    bool operator != (const BSTMap<KEY,T,tlt>& rhs) const;
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>& operator = (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& rhs);
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>& operator = (BSTMap<KEY,T,tlt,balanced,ranked,LT>&& rhs);   //O(1): swaps trees with rhs
+    bool operator == (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& rhs) const;
+    bool operator != (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& rhs) const;
+
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), bool balanced2, bool ranked2, class LT2>
+    friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY2,T2,lt2,balanced2,ranked2,LT2>& m);
 
-    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY2,T2,lt2>& m);
 
 
+  private:
+    class TN;
 
+  public:
     class Iterator {
       public:
         //Private constructor called in begin/end, which are friends of BSTMap<T>
         ~Iterator();
         Entry       erase();
         std::string str  () const;
-        BSTMap<KEY,T,tlt>::Iterator& operator ++ ();
-        BSTMap<KEY,T,tlt>::Iterator  operator ++ (int);
-        bool operator == (const BSTMap<KEY,T,tlt>::Iterator& rhs) const;
-        bool operator != (const BSTMap<KEY,T,tlt>::Iterator& rhs) const;
+        BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& operator ++ ();
+        BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator  operator ++ (int);
+        bool operator == (const BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& rhs) const;
+        bool operator != (const BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& rhs) const;
         Entry& operator *  () const;
         Entry* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator BSTMap<KEY,T,tlt>::begin () const;
-        friend Iterator BSTMap<KEY,T,tlt>::end   () const;
+        friend Iterator BSTMap<KEY,T,tlt,balanced,ranked,LT>::begin () const;
+        friend Iterator BSTMap<KEY,T,tlt,balanced,ranked,LT>::end   () const;
+        friend Iterator BSTMap<KEY,T,tlt,balanced,ranked,LT>::lower_bound (const KEY& key) const;
+        friend Iterator BSTMap<KEY,T,tlt,balanced,ranked,LT>::upper_bound (const KEY& key) const;
+        friend Iterator BSTMap<KEY,T,tlt,balanced,ranked,LT>::floor       (const KEY& key) const;
+        friend Iterator BSTMap<KEY,T,tlt,balanced,ranked,LT>::select      (int k) const;
 
       private:
-        //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        ArrayQueue<Entry> it;                 //Queue for all associations (from begin); use it as iterator via dequeue
-        BSTMap<KEY,T,tlt>* ref_map;
+        //path.peek() is the current node; below it are its ancestors still to be visited
+        //  (those it is in the left subtree of), so path holds O(height) nodes and the
+        //  Iterator is at the end when path is empty.
+        //If can_erase is false, path.peek() is the "next" node (must ++ to reach it)
+        ArrayStack<TN*>   path;
+        BSTMap<KEY,T,tlt,balanced,ranked,LT>* ref_map;
         int               expected_mod_count;
         bool              can_erase = true;
 
-        //Called in friends begin/end
-        Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from_begin);
+        //Helper methods
+        void push_left  (TN* root);           //Push root and its chain of left children
+        void seek       (const KEY& key, bool inclusive); //Reset path to the first node whose key is >= key (inclusive) or > key
+
+        //Called in friends begin/end/lower_bound/upper_bound/floor/select
+        Iterator(BSTMap<KEY,T,tlt,balanced,ranked,LT>* iterate_over, bool from_begin);
     };
 
 
@@ -112,17 +168,58 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedl
     Iterator end   () const;
 
 
+    //A Range is the half-open span [first,last) of a map's Iterators, for use in a
+    //  "for-each" loop: for (const Entry& e : m.range(lo,hi)) ...
+    //last is an Iterator at the first key not in the span (or end()), so the loop
+    //  stops when the Iterator reaches it.
+    class Range {
+      public:
+        Iterator begin () const {return first;}
+        Iterator end   () const {return last;}
+
+      private:
+        Iterator first;
+        Iterator last;
+
+        Range(const Iterator& f, const Iterator& l) : first(f), last(l) {}
+        friend class BSTMap<KEY,T,tlt,balanced,ranked,LT>;
+    };
+
+
+    //Ordered queries: each descends the tree once (twice for floor) to position the
+    //  returned Iterator, which then streams the following keys in order; it is end()
+    //  if there is no such key
+    Iterator lower_bound (const KEY& key) const;        //First key >= key
+    Iterator upper_bound (const KEY& key) const;        //First key >  key
+    Iterator floor       (const KEY& key) const;        //Last  key <= key (predecessor-or-equal)
+    Iterator ceiling     (const KEY& key) const;        //First key >= key (same as lower_bound)
+    Range    range       (const KEY& lo, const KEY& hi) const; //All keys in [lo,hi) (none if hi <= lo)
+
+    //Order statistics (only for ranked maps)
+    Iterator select      (int k) const;                 //Iterator at the k-th smallest key (k=0 is first); end() if k not in [0,size())
+    int      rank        (const KEY& key) const;        //Number of keys < key
+    int      count_range (const KEY& lo, const KEY& hi) const; //Number of keys in [lo,hi)
+
+
   private:
     class TN {
       public:
         TN ()                     : left(nullptr), right(nullptr){}
-        TN (const TN& tn)         : value(tn.value), left(tn.left), right(tn.right){}
-        TN (Entry v, TN* l = nullptr,
-                     TN* r = nullptr) : value(v), left(l), right(r){}
+        TN (const TN& tn)         : value(tn.value), left(tn.left), right(tn.right), height(tn.height), size(tn.size){}
+        TN (const Entry& v, TN* l = nullptr,
+                            TN* r = nullptr,
+                            int h = 1,
+                            int s = 1) : value(v), left(l), right(r), height(h), size(s){}
+        TN (const KEY& k, const T& v) : value(k,v), left(nullptr), right(nullptr){}
+        TN (const KEY& k, T&& v)      : left(nullptr), right(nullptr){value.first = k; value.second = std::move(v);}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(TN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(TN)>::deallocate(p);}
 
         Entry value;
         TN*   left;
         TN*   right;
+        int   height = 1;                //Height of this node's subtree (maintained only if balanced)
+        int   size   = 1;                //Number of nodes in this node's subtree (maintained only if ranked)
     };
 
   bool (*lt) (const KEY& a, const KEY& b); // The lt used for searching BST (from template or constructor)
@@ -130,19 +227,43 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedl
   int used      = 0;                       //Cache for number of key->value pairs in the BST
   int mod_count = 0;                       //For sensing concurrent modification
 
-  //Helper methods (find_key written iteratively, the rest recursively)
+  static_assert(std::is_same<LT,undefinedfunctor>::value || tlt == (ltfunc)undefinedlt<KEY>,
+                "BSTMap: supply tlt or LT, not both");
+  static ltfunc template_lt ();                      //functor_lt if LT is supplied, else tlt (undefinedlt if neither)
+  static bool functor_lt  (const KEY& a, const KEY& b);
+  bool less_than (const KEY& a, const KEY& b) const;   //lt(a,b), called directly when tlt/LT fixes it at compile time
+
+  //Bound on the links find_or_insert/remove record while descending a balanced tree:
+  //  an AVL tree of height h has at least fib(h+2)-1 nodes, so 64 levels exceed any int size
+  static const int max_height = 64;
+
+  //Helper methods (all iterative, so even a degenerate unbalanced tree cannot overflow the call stack)
   TN*   find_key            (TN*  root, const KEY& key)                 const; //Returns reference to key's node or nullptr
   bool  has_value           (TN*  root, const T& value)                 const; //Returns whether value is is root's tree
   TN*   copy                (TN*  root)                                 const; //Copy the keys/values in root's tree (identical structure)
   void  copy_to_queue       (TN* root, ArrayQueue<Entry>& q)            const; //Fill queue with root's tree value
-  bool  equals              (TN*  root, const BSTMap<KEY,T,tlt>& other) const; //Returns whether root's keys/value are all in other
+  bool  equals              (TN*  root, const BSTMap<KEY,T,tlt,balanced,ranked,LT>& other) const; //Returns whether root's keys/value are all in other
+  bool  same_in_order       (TN*  root, TN* other)                      const; //Returns whether both trees (same size) list the same keys/values in order
   std::string string_rotated(TN* root, std::string indent)              const; //Returns string representing root's tree
 
-  T     insert              (TN*& root, const KEY& key, const T& value);       //Put key->value, returning key's old value (or new one's, if key absent)
+  template <class V>
+  TN*   find_or_insert      (TN*& root, const KEY& key, V&& value, bool& inserted); //Return key's node, adding key->value (copied or moved) first (inserted = true) if key absent
+  template <class V>
+  T     insert              (TN*& root, const KEY& key, V&& value);            //Put key->value, returning key's old value (or new one's, if key absent)
   T&    find_addempty       (TN*& root, const KEY& key);                       //Return reference to key's value (adding key->T() first, if key absent)
-  Entry remove_closest      (TN*& root);                                       //Helper for remove
   T     remove              (TN*& root, const KEY& key);                       //Remove key->value from root's tree
   void  delete_BST          (TN*& root);                                       //Deallocate all TN in tree; root == nullptr
+  template <class Source>
+  TN*   build_sorted        (Source& next, int n);                             //Balanced tree of the n entries *next, ++next... (recurses log2(n) deep)
+
+  //AVL/size helpers (rotations only if balanced; sizes only if ranked)
+  static int height         (TN* root);                                        //Height of root's tree (0 for nullptr)
+  static int tree_size      (TN* root);                                        //Size of root's tree (0 for nullptr)
+  static void update        (TN* root);                                        //Recompute root's cached height/size from its children
+  void  rotate_left         (TN*& root);                                       //root's right child becomes root
+  void  rotate_right        (TN*& root);                                       //root's left child becomes root
+  void  rebalance           (TN*& root);                                       //Restore root's height/size/balance after a child changed
+  void  adjust_sizes        (TN* root, const KEY& key, TN* stop, int delta);   //Add delta to sizes on key's search path, above stop (unbalanced but ranked)
 };
 
 
@@ -155,31 +276,31 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedl
 
 //Destructor/Constructors
 
-    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-    BSTMap<KEY,T,tlt>::~BSTMap() {
-        delete map;
+    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>::~BSTMap() {
+        delete_BST(map);
     }
 
 
-    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-    BSTMap<KEY,T,tlt>::BSTMap(bool (*clt)(const KEY& a, const KEY& b))
-            : lt(tlt != (ltfunc)undefinedlt<KEY> ? tlt : clt)
+    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>::BSTMap(bool (*clt)(const KEY& a, const KEY& b))
+            : lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
     {
         if (lt == (ltfunc)undefinedlt<KEY>)
             throw TemplateFunctionError("BSTMap::default constructor: neither specified");
-        if (tlt != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && tlt != clt)
+        if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
             throw TemplateFunctionError("BSTMap::default constructor: both specified and different");
 
     }
 
 
-    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-    BSTMap<KEY,T,tlt>::BSTMap(const BSTMap<KEY,T,tlt>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
-            : lt(tlt != (ltfunc)undefinedlt<KEY> ? tlt : clt)
+    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>::BSTMap(const BSTMap<KEY,T,tlt,balanced,ranked,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+            : lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
     {
         if (lt == (ltfunc)undefinedlt<KEY>)
             lt  = to_copy.lt; //throw TemplateFunctionError("BSTMap::default constructor: neither specified");
-        if (tlt != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && tlt != clt)
+        if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
             throw TemplateFunctionError("BSTMap::to_copy constructor: both specified and different");
 
         if (lt == to_copy.lt) {
@@ -195,66 +316,86 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedl
     }
 
 
-    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-    BSTMap<KEY,T,tlt>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
-            : lt(tlt != (ltfunc)undefinedlt<KEY> ? tlt : clt)
+    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>::BSTMap(BSTMap<KEY,T,tlt,balanced,ranked,LT>&& to_move)
+            : lt(to_move.lt), map(to_move.map), used(to_move.used)
+    {
+        to_move.map  = nullptr;
+        to_move.used = 0;
+        ++to_move.mod_count;
+    }
+
+
+    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+            : lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
     {
         if (lt == (ltfunc)undefinedlt<KEY>)
             throw TemplateFunctionError("BSTMap::initializer constructor: neither specified");
-        if (tlt != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && tlt != clt)
+        if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
             throw TemplateFunctionError("BSTMap::initializer constructor: both specified and different");
 
-        for (const Entry& il_entry: il)
-            put(il_entry.first, il_entry.second);
+        put_all_sorted(il);
     }
 
 
-    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
+    template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
     template <class Iterable>
-    BSTMap<KEY,T,tlt>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
-            : lt(tlt != (ltfunc)undefinedlt<KEY> ? tlt : clt)
+    BSTMap<KEY,T,tlt,balanced,ranked,LT>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+            : lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
     {
         if (lt == (ltfunc)undefinedlt<KEY>)
             throw TemplateFunctionError("BSTMap::iterable constructor: neither specified");
-        if (tlt != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && tlt != clt)
+        if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
             throw TemplateFunctionError("BSTMap::iterable constructor: both specified and different");
 
-        for (const Entry& i_entry : i)
-            put(i_entry.first, i_entry.second);
+        put_all_sorted(i);
     }
 
 
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+template <class Iterable>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::from_sorted(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b)) -> BSTMap<KEY,T,tlt,balanced,ranked,LT> {
+    BSTMap<KEY,T,tlt,balanced,ranked,LT> to_return(clt);
+    to_return.put_all_sorted(i);
+    return to_return;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Queries
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::empty() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::empty() const {
     return used==0;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-int BSTMap<KEY,T,tlt>::size() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::size() const {
     return used;
 }
 
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_key (const KEY& key) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::has_key (const KEY& key) const {
     return find_key(map,key)!=nullptr;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_value (const T& value) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::has_value (const T& value) const {
     return has_value(map,value);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::str() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+std::string BSTMap<KEY,T,tlt,balanced,ranked,LT>::str() const {
+    std::ostringstream answer;
+    answer << "bst_map[" << string_rotated(map,"\n") << "](used=" << used << ",mod_count=" << mod_count << ")";
+    return answer.str();
 }
 
 
@@ -262,33 +403,35 @@ std::string BSTMap<KEY,T,tlt>::str() const {
 //
 //Commands
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::put(const KEY& key, const T& value) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+T BSTMap<KEY,T,tlt,balanced,ranked,LT>::put(const KEY& key, const T& value) {
     ++mod_count;
-    if(has_key(key)){
-        T temp=find_key(map,key)->value.second;
-        find_key(map,key)->value.second=value;
-        return temp;
-    }
-    if(map == nullptr){
-        used++;
-        map=new TN(ics::make_pair(key,value));
-        return value;
-    }
-    else{
-        used++;
-        if(lt(key,map->value.first)){
-            return insert(map->left,key,value);
-        }
-        else{
-            return insert(map->right, key, value);
-        }
-    }
+    return insert(map,key,value);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+T BSTMap<KEY,T,tlt,balanced,ranked,LT>::put(const KEY& key, T&& value) {
+    ++mod_count;
+    return insert(map,key,std::move(value));
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+template <class... Args>
+T& BSTMap<KEY,T,tlt,balanced,ranked,LT>::emplace(const KEY& key, Args&&... args) {
+    ++mod_count;
+    T value(std::forward<Args>(args)...);
+    bool inserted;
+    TN*  found = find_or_insert(map, key, std::move(value), inserted);
+    if (!inserted)
+        found->value.second = std::move(value);
+    return found->value.second;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::erase(const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+T BSTMap<KEY,T,tlt,balanced,ranked,LT>::erase(const KEY& key) {
     ++mod_count;
     T value=remove(map,key);
     used--;
@@ -296,17 +439,17 @@ T BSTMap<KEY,T,tlt>::erase(const KEY& key) {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::clear() {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::clear() {
     ++mod_count;
-    map = nullptr;
+    delete_BST(map);
     used = 0;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
 template<class Iterable>
-int BSTMap<KEY,T,tlt>::put_all(const Iterable& i) {
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::put_all(const Iterable& i) {
     int count=0;
     for(const Entry& p: i){
         count+=1;
@@ -316,63 +459,112 @@ int BSTMap<KEY,T,tlt>::put_all(const Iterable& i) {
 }
 
 
+//The first pass over i counts it and checks it is sorted; the second builds the tree
+//  straight from i (into an empty map) or from i merged with the map's current entries.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+template<class Iterable>
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::put_all_sorted(const Iterable& i) {
+    int count = 0;
+    KEY prev;                                    //A copy: i may yield its Entries by value
+    for (const Entry& p : i) {
+        if (count != 0 && !less_than(prev,p.first))
+            return put_all(i);
+        prev = p.first;
+        ++count;
+    }
+    if (count == 0)
+        return 0;
+
+    ++mod_count;
+    if (map == nullptr) {
+        auto next = i.begin();
+        map  = build_sorted(next, count);
+        used = count;
+        return count;
+    }
+
+    ArrayQueue<Entry> merged;
+    Iterator old = begin();
+    for (const Entry& p : i) {
+        for (; old != end() && less_than(old->first,p.first); ++old)
+            merged.enqueue(*old);
+        if (old != end() && old->first == p.first)
+            ++old;                               //Replaced by p
+        merged.enqueue(p);
+    }
+    for (; old != end(); ++old)
+        merged.enqueue(*old);
+
+    delete_BST(map);
+    auto next = merged.begin();
+    used = merged.size();
+    map  = build_sorted(next, used);
+    return count;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Operators
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T& BSTMap<KEY,T,tlt>::operator [] (const KEY& key) {
-    T value;
-    if(!has_key(key)){
-        put(key, value);
-    }
-    return find_key(map,key)->value.second;
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+T& BSTMap<KEY,T,tlt,balanced,ranked,LT>::operator [] (const KEY& key) {
+    return find_addempty(map,key);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-const T& BSTMap<KEY,T,tlt>::operator [] (const KEY& key) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+const T& BSTMap<KEY,T,tlt,balanced,ranked,LT>::operator [] (const KEY& key) const {
     return find_key(map,key)->value.second;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>& BSTMap<KEY,T,tlt>::operator = (const BSTMap<KEY,T,tlt>& rhs) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+BSTMap<KEY,T,tlt,balanced,ranked,LT>& BSTMap<KEY,T,tlt,balanced,ranked,LT>::operator = (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& rhs) {
     if (this == &rhs)
         return *this;
+    delete_BST(map);
     lt = rhs.lt;
-    put_all(rhs);
+    map = copy(rhs.map);
     used = rhs.used;
     ++mod_count;
     return *this;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::operator == (const BSTMap<KEY,T,tlt>& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+BSTMap<KEY,T,tlt,balanced,ranked,LT>& BSTMap<KEY,T,tlt,balanced,ranked,LT>::operator = (BSTMap<KEY,T,tlt,balanced,ranked,LT>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(lt,   rhs.lt);
+    std::swap(map,  rhs.map);
+    std::swap(used, rhs.used);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::operator == (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& rhs) const {
     if (this == &rhs)
         return true;
     if (used != rhs.size())
         return false;
-    for (const Entry& entry: rhs){
-        if (!(has_key(entry.first)))
-            return false;
-        else if (find_key(map, entry.first)->value.second != entry.second)
-            return false;
-    }
-    return true;
-
+    if (lt == rhs.lt)                        //Same order: equal iff the in-order walks match, O(N)
+        return same_in_order(map, rhs.map);
+    return equals(map, rhs);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::operator != (const BSTMap<KEY,T,tlt>& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::operator != (const BSTMap<KEY,T,tlt,balanced,ranked,LT>& rhs) const {
     return !(*this == rhs);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>& m) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt,balanced,ranked,LT>& m) {
     outs << "map[";
     if(!m.empty()){
         outs << m.map->value.first << "->" <<  m.map->value.second;
@@ -389,142 +581,474 @@ std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>& m) {
 //
 //Iterator constructors
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::begin () const -> BSTMap<KEY,T,tlt>::Iterator
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::begin () const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator
 {
-    return Iterator(const_cast<BSTMap<KEY,T,tlt>*>(this), true);
+    return Iterator(const_cast<BSTMap<KEY,T,tlt,balanced,ranked,LT>*>(this), true);
+}
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::end () const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
+    return Iterator(const_cast<BSTMap<KEY,T,tlt,balanced,ranked,LT>*>(this), false);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::lower_bound (const KEY& key) const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
+    Iterator i(const_cast<BSTMap<KEY,T,tlt,balanced,ranked,LT>*>(this), false);
+    i.seek(key, true);
+    return i;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::upper_bound (const KEY& key) const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
+    Iterator i(const_cast<BSTMap<KEY,T,tlt,balanced,ranked,LT>*>(this), false);
+    i.seek(key, false);
+    return i;
 }
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::end () const -> BSTMap<KEY,T,tlt>::Iterator {
-    return Iterator(const_cast<BSTMap<KEY,T,tlt>*>(this), false);
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::floor (const KEY& key) const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
+    TN* last_le = nullptr;                   //Last node on the search path whose key is <= key
+    for (TN* c = map; c != nullptr; )
+        if (key == c->value.first) {
+            last_le = c;
+            break;
+        }else if (less_than(key,c->value.first))
+            c = c->left;
+        else {
+            last_le = c;
+            c = c->right;
+        }
+
+    Iterator i(const_cast<BSTMap<KEY,T,tlt,balanced,ranked,LT>*>(this), false);
+    if (last_le != nullptr)
+        i.seek(last_le->value.first, true);
+    return i;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::ceiling (const KEY& key) const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
+    return lower_bound(key);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::range (const KEY& lo, const KEY& hi) const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Range {
+    if (!less_than(lo,hi))
+        return Range(end(), end());
+    return Range(lower_bound(lo), lower_bound(hi));
+}
+
+
+//Descends by subtree sizes, pushing each node whose left subtree the k-th node is in,
+//  which is exactly the Iterator's path to that node
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::select (int k) const -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
+    static_assert(ranked, "BSTMap::select requires a ranked BSTMap");
+    Iterator i(const_cast<BSTMap<KEY,T,tlt,balanced,ranked,LT>*>(this), false);
+    if (k < 0 || k >= used)
+        return i;
+    for (TN* c = map; c != nullptr; ) {
+        int left_size = tree_size(c->left);
+        if (k < left_size) {
+            i.path.push(c);
+            c = c->left;
+        }else if (k == left_size) {
+            i.path.push(c);
+            break;
+        }else {
+            k -= left_size + 1;
+            c = c->right;
+        }
+    }
+    return i;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::rank (const KEY& key) const {
+    static_assert(ranked, "BSTMap::rank requires a ranked BSTMap");
+    int smaller = 0;
+    for (TN* c = map; c != nullptr; )
+        if (key == c->value.first)
+            return smaller + tree_size(c->left);
+        else if (less_than(key,c->value.first))
+            c = c->left;
+        else {
+            smaller += tree_size(c->left) + 1;
+            c = c->right;
+        }
+    return smaller;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::count_range (const KEY& lo, const KEY& hi) const {
+    static_assert(ranked, "BSTMap::count_range requires a ranked BSTMap");
+    return less_than(lo,hi) ? rank(hi) - rank(lo) : 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::find_key (TN* root, const KEY& key) const {
-    if (root==nullptr || root->value.first==key){
-        return root;
-    }
-    if(lt(key,root->value.first)){
-        return find_key(root->left,key);
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+typename BSTMap<KEY,T,tlt,balanced,ranked,LT>::ltfunc BSTMap<KEY,T,tlt,balanced,ranked,LT>::template_lt () {
+    return !std::is_same<LT,undefinedfunctor>::value ? functor_lt : tlt;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::functor_lt (const KEY& a, const KEY& b) {
+    return LT()(a,b);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::less_than (const KEY& a, const KEY& b) const {
+    if (!std::is_same<LT,undefinedfunctor>::value)
+        return LT()(a,b);
+    if (tlt != (ltfunc)undefinedlt<KEY>)
+        return tlt(a,b);
+    return lt(a,b);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+typename BSTMap<KEY,T,tlt,balanced,ranked,LT>::TN* BSTMap<KEY,T,tlt,balanced,ranked,LT>::find_key (TN* root, const KEY& key) const {
+    for (TN* c = root; c != nullptr; c = (less_than(key,c->value.first) ? c->left : c->right))
+        if (c->value.first == key)
+            return c;
+    return nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::has_value (TN* root, const T& value) const {
+    ArrayStack<TN*> to_visit;
+    if (root != nullptr)
+        to_visit.push(root);
+    while (!to_visit.empty()) {
+        TN* c = to_visit.pop();
+        if (c->value.second == value)
+            return true;
+        if (c->left != nullptr)
+            to_visit.push(c->left);
+        if (c->right != nullptr)
+            to_visit.push(c->right);
     }
-    return find_key(root->right,key);
+    return false;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_value (TN* root, const T& value) const {
-    if(root==nullptr){
-        return false;
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+typename BSTMap<KEY,T,tlt,balanced,ranked,LT>::TN* BSTMap<KEY,T,tlt,balanced,ranked,LT>::copy (TN* root) const {
+    TN* to_return = nullptr;
+    ArrayStack<pair<TN*,TN**>> to_copy;      //Node to copy, and the link its copy is stored in
+    if (root != nullptr)
+        to_copy.push(ics::make_pair(root,&to_return));
+    while (!to_copy.empty()) {
+        pair<TN*,TN**> next = to_copy.pop();
+        TN* c = next.first;
+        TN* n = *next.second = new TN(c->value, nullptr, nullptr, c->height, c->size);
+        if (c->left != nullptr)
+            to_copy.push(ics::make_pair(c->left,&n->left));
+        if (c->right != nullptr)
+            to_copy.push(ics::make_pair(c->right,&n->right));
     }
-    if(root->value.second==value){
-        return true;
+    return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
+    ArrayStack<TN*> to_visit;
+    if (root != nullptr)
+        to_visit.push(root);
+    while (!to_visit.empty()) {
+        TN* c = to_visit.pop();
+        q.enqueue(c->value);
+        if (c->right != nullptr)             //Pushed first, so the left subtree is enqueued first
+            to_visit.push(c->right);
+        if (c->left != nullptr)
+            to_visit.push(c->left);
     }
-    else{
-        return has_value(root->left,value) || has_value(root->right,value);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::equals (TN* root, const BSTMap<KEY,T,tlt,balanced,ranked,LT>& other) const {
+    ArrayStack<TN*> to_visit;
+    if (root != nullptr)
+        to_visit.push(root);
+    while (!to_visit.empty()) {
+        TN* c = to_visit.pop();
+        TN* o = other.find_key(other.map, c->value.first);
+        if (o == nullptr || o->value.second != c->value.second)
+            return false;
+        if (c->left != nullptr)
+            to_visit.push(c->left);
+        if (c->right != nullptr)
+            to_visit.push(c->right);
     }
+    return true;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::copy (TN* root) const {
-    if (root == nullptr)
-        return nullptr;
-    else
-        return new TN(root->value, copy(root->left), copy(root->right));
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::same_in_order (TN* root, TN* other) const {
+    ArrayStack<TN*> path, other_path;        //Each walk's nodes whose left subtrees are being visited
+    for (TN* c = root, *o = other; ; c = c->right, o = o->right) {
+        for (; c != nullptr; c = c->left)
+            path.push(c);
+        for (; o != nullptr; o = o->left)
+            other_path.push(o);
+        if (path.empty())                   //Same size, so other_path is empty too
+            return true;
+        c = path.pop();
+        o = other_path.pop();
+        if (!(c->value.first == o->value.first) || c->value.second != o->value.second)
+            return false;
+    }
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
-    if(root== nullptr){
-        return;
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+std::string BSTMap<KEY,T,tlt,balanced,ranked,LT>::string_rotated(TN* root, std::string indent) const {
+    std::ostringstream answer;
+    ArrayStack<pair<TN*,int>> to_print;      //Nodes whose right subtrees are printed, and their depths
+    TN* c     = root;
+    int depth = 0;
+    for (;;) {
+        for (; c != nullptr; c = c->right, ++depth)
+            to_print.push(pair<TN*,int>(c,depth));
+        if (to_print.empty())
+            break;
+        pair<TN*,int> next = to_print.pop();
+        answer << indent << std::string(2*(next.second < max_height ? next.second : max_height),'.');
+        if (next.second > max_height)       //Keeps a degenerate tree's string O(N), not O(N^2)
+            answer << "(depth " << next.second << ")";
+        answer << next.first->value.first << "->" << next.first->value.second;
+        c     = next.first->left;
+        depth = next.second+1;
     }
-    else{
-        q.enqueue(root->value);
-        copy_to_queue(root->left,q);
-        copy_to_queue(root->right,q);
+    return answer.str();
+}
+
+
+//Descends from root; if balanced, records each link passed so the tree can be rebalanced
+//  bottom-up after a node is added (if only ranked, sizes are fixed by a second descent).
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+template <class V>
+typename BSTMap<KEY,T,tlt,balanced,ranked,LT>::TN* BSTMap<KEY,T,tlt,balanced,ranked,LT>::find_or_insert (TN*& root, const KEY& key, V&& value, bool& inserted) {
+    TN** path[max_height];
+    int  depth = 0;
+    TN** link  = &root;
+    while (*link != nullptr) {
+        TN* c = *link;
+        if (c->value.first == key) {
+            inserted = false;
+            return c;
+        }
+        if (balanced)
+            path[depth++] = link;
+        link = (less_than(key,c->value.first) ? &c->left : &c->right);
     }
+
+    TN* to_return = *link = new TN(key, std::forward<V>(value));
+    ++used;
+    inserted = true;
+    if (!balanced && ranked)
+        adjust_sizes(root, key, to_return, 1);
+    while (depth > 0)
+        rebalance(*path[--depth]);
+    return to_return;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::equals (TN* root, const BSTMap<KEY,T,tlt>& other) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+template <class V>
+T BSTMap<KEY,T,tlt,balanced,ranked,LT>::insert (TN*& root, const KEY& key, V&& value) {
+    bool inserted;
+    TN*  found = find_or_insert(root, key, std::forward<V>(value), inserted);
+    if (inserted)
+        return found->value.second;
+    T to_return = std::move(found->value.second);
+    found->value.second = std::forward<V>(value);   //Not moved from by find_or_insert: key was present
+    return to_return;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::string_rotated(TN* root, std::string indent) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+T& BSTMap<KEY,T,tlt,balanced,ranked,LT>::find_addempty (TN*& root, const KEY& key) {
+    bool inserted;
+    TN*  found = find_or_insert(root, key, T(), inserted);
+    if (inserted)
+        ++mod_count;
+    return found->value.second;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::insert (TN*& root, const KEY& key, const T& value) {
-    if(root==nullptr){
-        root=new TN(ics::make_pair(key,value));
-        return value;
+//A node with two children keeps its place: its entry is replaced by its predecessor's
+//  (the rightmost node in its left subtree), and that node is unlinked instead.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+T BSTMap<KEY,T,tlt,balanced,ranked,LT>::remove (TN*& root, const KEY& key) {
+    TN** path[max_height];
+    int  depth = 0;
+    TN** link  = &root;
+    while (*link != nullptr && !((*link)->value.first == key)) {
+        if (balanced)
+            path[depth++] = link;
+        link = (less_than(key,(*link)->value.first) ? &(*link)->left : &(*link)->right);
     }
-    else{
-        if(lt(key,root->value.first)){
-            return insert(root->left,key,value);
-        }
-        else{
-            return insert(root->right,key,value);
+    if (*link == nullptr) {
+        std::ostringstream answer;
+        answer << "BSTMap::erase: key(" << key << ") not in Map";
+        throw KeyError(answer.str());
+    }
+
+    TN* to_delete = *link;
+    T   to_return = std::move(to_delete->value.second);
+    if (!balanced && ranked)
+        adjust_sizes(root, key, to_delete, -1);
+    if (to_delete->left == nullptr)
+        *link = to_delete->right;
+    else if (to_delete->right == nullptr)
+        *link = to_delete->left;
+    else {
+        if (balanced)
+            path[depth++] = link;
+        else if (ranked)
+            --to_delete->size;
+        TN** closest = &to_delete->left;
+        while ((*closest)->right != nullptr) {
+            if (balanced)
+                path[depth++] = closest;
+            else if (ranked)
+                --(*closest)->size;
+            closest = &(*closest)->right;
         }
+        TN* closest_node = *closest;
+        to_delete->value.first  = std::move(closest_node->value.first);
+        to_delete->value.second = std::move(closest_node->value.second);
+        *closest = closest_node->left;
+        to_delete = closest_node;
     }
+    delete to_delete;
+
+    while (depth > 0)
+        rebalance(*path[--depth]);
+    return to_return;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T& BSTMap<KEY,T,tlt>::find_addempty (TN*& root, const KEY& key) {
+//Rotates each left child up until the root has none, then deletes the root and moves
+//  right: O(N) with no stack, whatever the tree's shape.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::delete_BST (TN*& root) {
+    while (root != nullptr)
+        if (root->left != nullptr) {
+            TN* to_rotate   = root->left;
+            root->left      = to_rotate->right;
+            to_rotate->right = root;
+            root            = to_rotate;
+        }else {
+            TN* to_delete = root;
+            root = root->right;
+            delete to_delete;
+        }
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T> BSTMap<KEY,T,tlt>::remove_closest(TN*& root) {
-  if (root->right != nullptr)
-    return remove_closest(root->right);
-  else{
-    Entry to_return = root->value;
-    TN* to_delete = root;
-    root = root->left;
-    delete to_delete;
-    return to_return;
-  }
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::adjust_sizes (TN* root, const KEY& key, TN* stop, int delta) {
+    for (TN* c = root; c != stop; c = (less_than(key,c->value.first) ? c->left : c->right))
+        c->size += delta;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::remove (TN*& root, const KEY& key) {
-  if (root == nullptr) {
-    std::ostringstream answer;
-    answer << "BSTMap::erase: key(" << key << ") not in Map";
-    throw KeyError(answer.str());
-  }else
-    if (key == root->value.first) {
-      T to_return = root->value.second;
-      if (root->left == nullptr) {
-        TN* to_delete = root;
-        root = root->right;
-        delete to_delete;
-      }else if (root->right == nullptr) {
-        TN* to_delete = root;
-        root = root->left;
-        delete to_delete;
-      }else
-        root->value = remove_closest(root->left);
-      return to_return;
-    }else
-      return remove( (lt(key,root->value.first) ? root->left : root->right), key);
+//Splits the n entries around the middle one, so subtree sizes (and so heights) differ
+//  by at most 1 at every node: the result is AVL-balanced and update() sets its caches.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+template <class Source>
+typename BSTMap<KEY,T,tlt,balanced,ranked,LT>::TN* BSTMap<KEY,T,tlt,balanced,ranked,LT>::build_sorted (Source& next, int n) {
+    if (n == 0)
+        return nullptr;
+    TN* left = build_sorted(next, n/2);
+    TN* root = new TN(*next, left);
+    ++next;
+    root->right = build_sorted(next, n-n/2-1);
+    update(root);
+    return root;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::height (TN* root) {
+    return root == nullptr ? 0 : root->height;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::rotate_left (TN*& root) {
+    TN* to_rotate = root->right;
+    root->right   = to_rotate->left;
+    to_rotate->left = root;
+    update(root);
+    root          = to_rotate;
+    update(root);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::rotate_right (TN*& root) {
+    TN* to_rotate = root->left;
+    root->left    = to_rotate->right;
+    to_rotate->right = root;
+    update(root);
+    root          = to_rotate;
+    update(root);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+int BSTMap<KEY,T,tlt,balanced,ranked,LT>::tree_size (TN* root) {
+    return root == nullptr ? 0 : root->size;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::update (TN* root) {
+    if (balanced)
+        root->height = 1 + std::max(height(root->left), height(root->right));
+    if (ranked)
+        root->size   = 1 + tree_size(root->left) + tree_size(root->right);
+}
+
+
+//Called on the way back up from an insert/remove in one of root's subtrees, whose
+//  height therefore changed by at most 1: at most a single or double rotation is needed.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::rebalance (TN*& root) {
+    if (balanced) {
+        int balance = height(root->left) - height(root->right);
+        if (balance > 1) {
+            if (height(root->left->left) < height(root->left->right))
+                rotate_left(root->left);
+            rotate_right(root);
+            return;
+        }else if (balance < -1) {
+            if (height(root->right->right) < height(root->right->left))
+                rotate_right(root->right);
+            rotate_left(root);
+            return;
+        }
+    }
+    update(root);
 }
 
 
@@ -536,50 +1060,55 @@ void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
 //
 //Iterator class definitions
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::Iterator::Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from_begin)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::Iterator(BSTMap<KEY,T,tlt,balanced,ranked,LT>* iterate_over, bool from_begin)
         :ref_map(iterate_over), expected_mod_count(ref_map->mod_count)
 {
-    if(from_begin){
-        ref_map->copy_to_queue(ref_map->map,it);
-    }
-    std::cout << it.str() << std::endl;
+    if(from_begin)
+        push_left(ref_map->map);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::Iterator::~Iterator()
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::~Iterator()
 {}
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::Iterator::erase() -> Entry {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::erase() -> Entry {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("BST_MAP::Iterator::operator *");
     if (!can_erase)
         throw CannotEraseError("BST_MAP::Iterator::erase Iterator cursor already erased");
+    if (path.empty())
+        throw CannotEraseError("BST_MAP::Iterator::erase Iterator cursor beyond data structure");
     can_erase = false;
-    Entry to_return = it.dequeue();
+    Entry to_return = path.peek()->value;
+    //Erasing may free/rotate nodes on path, so re-find the successor from the root
     ref_map->erase(to_return.first);
+    seek(to_return.first, false);
     expected_mod_count = ref_map->mod_count;
     return to_return;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::Iterator::str() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+std::string BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_map->str() << "(path size=" << path.size() << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+    return answer.str();
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto  BSTMap<KEY,T,tlt>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt>::Iterator& {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto  BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("BST_MAP::Iterator::operator *");
-    if(it.size()==0){
+    if(path.empty()){
         return *this;
     }
     if(can_erase){
-        it.dequeue();
+        push_left(path.pop()->right);
     }
     else{
         can_erase=true;
@@ -588,16 +1117,16 @@ auto  BSTMap<KEY,T,tlt>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt>::Iterator
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt>::Iterator {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+auto BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("BST_MAP::Iterator::operator *");
-    if(it.size()==0){
+    if(path.empty()){
         return *this;
     }
     Iterator to_return(*this);
     if(can_erase){
-        it.dequeue();
+        push_left(path.pop()->right);
     }
     else{
         can_erase=true;
@@ -607,22 +1136,36 @@ auto BSTMap<KEY,T,tlt>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt>::Iterat
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::Iterator::operator == (const BSTMap<KEY,T,tlt>::Iterator& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::operator == (const BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& rhs) const {
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
-    return it.size() == rhsASI->it.size();
+    if (rhsASI == 0)
+        throw IteratorTypeError("BST_MAP::Iterator::operator ==");
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BST_MAP::Iterator::operator ==");
+    if (ref_map != rhsASI->ref_map)
+        throw ComparingDifferentIteratorsError("BST_MAP::Iterator::operator ==");
+
+    return (path.empty() ? nullptr : path.peek()) == (rhsASI->path.empty() ? nullptr : rhsASI->path.peek());
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::Iterator::operator != (const BSTMap<KEY,T,tlt>::Iterator& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+bool BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::operator != (const BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator& rhs) const {
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
-    return it.size() != rhsASI->it.size();
+    if (rhsASI == 0)
+        throw IteratorTypeError("BST_MAP::Iterator::operator !=");
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BST_MAP::Iterator::operator !=");
+    if (ref_map != rhsASI->ref_map)
+        throw ComparingDifferentIteratorsError("BST_MAP::Iterator::operator !=");
+
+    return (path.empty() ? nullptr : path.peek()) != (rhsASI->path.empty() ? nullptr : rhsASI->path.peek());
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T>& BSTMap<KEY,T,tlt>::Iterator::operator *() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+pair<KEY,T>& BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::operator *() const {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("BST_MAP::Iterator::operator *");
     if (!can_erase) {
@@ -630,12 +1173,14 @@ pair<KEY,T>& BSTMap<KEY,T,tlt>::Iterator::operator *() const {
 //        where << current << " when size = " << ref_pq->size();
         throw IteratorPositionIllegal("BST_MAP::Iterator::operator -> Iterator illegal: ");
     }
-    return it.peek();
+    if (path.empty())
+        throw IteratorPositionIllegal("BST_MAP::Iterator::operator * Iterator illegal: beyond data structure");
+    return path.peek()->value;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T>* BSTMap<KEY,T,tlt>::Iterator::operator ->() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+pair<KEY,T>* BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::operator ->() const {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("BST_MAP::Iterator::operator *");
     if (!can_erase) {
@@ -643,7 +1188,31 @@ pair<KEY,T>* BSTMap<KEY,T,tlt>::Iterator::operator ->() const {
 //        where << current << " when size = " << ref_pq->size();
         throw IteratorPositionIllegal("BST_MAP::Iterator::operator -> Iterator illegal: ");
     }
-    return &it.peek();
+    if (path.empty())
+        throw IteratorPositionIllegal("BST_MAP::Iterator::operator -> Iterator illegal: beyond data structure");
+    return &path.peek()->value;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::push_left(TN* root) {
+    for (; root != nullptr; root = root->left)
+        path.push(root);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), bool balanced, bool ranked, class LT>
+void BSTMap<KEY,T,tlt,balanced,ranked,LT>::Iterator::seek(const KEY& key, bool inclusive) {
+    path.clear();
+    for (TN* c = ref_map->map; c != nullptr; )
+        if (inclusive && key == c->value.first) {
+            path.push(c);
+            return;
+        }else if (ref_map->less_than(key,c->value.first)) {
+            path.push(c);
+            c = c->left;
+        }else
+            c = c->right;
 }
 
 
@@ -0,0 +1,1077 @@
+#ifndef BTREE_MAP_HPP_
+#define BTREE_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
+#include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
+#include "pair.hpp"
+#include "array_stack.hpp"   //For Iterator and tree walks
+
+
+namespace ics {
+
+
+#ifndef undefinedltdefined
+#define undefinedltdefined
+template<class T>
+bool undefinedlt (const T& a, const T& b) {return false;}
+#endif /* undefinedltdefined */
+
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
+//An ordered map with the same public interface as BSTMap, stored as a B-tree.
+//Each node holds up to max_keys entries in a sorted array (and, if internal, one more
+//  child than entries), so a lookup binary-searches O(log N / log max_keys) nodes of a
+//  few contiguous cache lines each, instead of following O(log N) single-entry nodes.
+//Every node but the root holds min_degree-1..max_keys (= 2*min_degree-1) entries and
+//  all leaves are at the same depth. put/erase split, merge, or borrow into nodes on
+//  the way down (top-down, as in CLRS), so each is one iterative descent.
+//
+//Instantiate the templated class supplying tlt(a,b): true, iff a is less than b.
+//If tlt is defaulted to undefinedlt in the template, then a constructor must supply clt.
+//If both tlt and clt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedlt value supplied by tlt/clt is stored in the instance variable lt.
+//Alternatively, leave tlt defaulted and supply a stateless functor type LT (e.g., std::less<KEY>, or a
+//  lambda's type in C++20): LT()(...) is then called directly, so it can be inlined (as is a
+//  tlt template argument); only a clt supplied at run time is called through the pointer lt.
+//Supplying both tlt and LT is a compile-time error.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = undefinedlt<KEY>, class LT = undefinedfunctor> class BTreeMap {
+  public:
+    typedef pair<KEY,T> Entry;
+    typedef bool (*ltfunc) (const KEY& a, const KEY& b);
+
+    //Destructor/Constructors
+    ~BTreeMap();
+
+    BTreeMap          (bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+    BTreeMap          (const BTreeMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+    BTreeMap          (BTreeMap<KEY,T,tlt,LT>&& to_move);   //O(1): takes to_move's tree, leaving it empty
+    explicit BTreeMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit BTreeMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = undefinedlt<KEY>);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool has_key    (const KEY& key) const;
+    bool has_value  (const T& value) const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    T    put   (const KEY& key, const T& value);
+    T    put   (const KEY& key, T&& value);
+    T    erase (const KEY& key);
+    void clear ();
+
+    //Like put, but the value is T(args...) moved into key's entry; returns a reference to it
+    template <class... Args>
+    T&   emplace (const KEY& key, Args&&... args);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int put_all(const Iterable& i);
+
+
+    //Operators
+
+    T&       operator [] (const KEY&);
+    const T& operator [] (const KEY&) const;
+    BTreeMap<KEY,T,tlt,LT>& operator = (const BTreeMap<KEY,T,tlt,LT>& rhs);
+    BTreeMap<KEY,T,tlt,LT>& operator = (BTreeMap<KEY,T,tlt,LT>&& rhs);   //O(1): swaps trees with rhs
+    bool operator == (const BTreeMap<KEY,T,tlt,LT>& rhs) const;
+    bool operator != (const BTreeMap<KEY,T,tlt,LT>& rhs) const;
+
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), class LT2>
+    friend std::ostream& operator << (std::ostream& outs, const BTreeMap<KEY2,T2,lt2,LT2>& m);
+
+
+
+  private:
+    class BN;
+
+  public:
+    class Iterator {
+      public:
+        typedef pair<BN*,int> Cursor;  //A node, and the index of its next entry to visit
+
+        //Private constructor called in begin/end, which are friends of BTreeMap<T>
+        ~Iterator();
+        Entry       erase();
+        std::string str  () const;
+        BTreeMap<KEY,T,tlt,LT>::Iterator& operator ++ ();
+        BTreeMap<KEY,T,tlt,LT>::Iterator  operator ++ (int);
+        bool operator == (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        bool operator != (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        Entry& operator *  () const;
+        Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const BTreeMap<KEY,T,tlt,LT>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::begin () const;
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::end   () const;
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::lower_bound (const KEY& key) const;
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::upper_bound (const KEY& key) const;
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::floor       (const KEY& key) const;
+
+      private:
+        //path.peek() is the current entry; below it are the ancestors' Cursors, each at
+        //  the entry to visit after the child being walked, so path holds O(height) Cursors
+        //  and the Iterator is at the end when path is empty.
+        //If can_erase is false, path.peek() is the "next" entry (must ++ to reach it)
+        ArrayStack<Cursor>   path;
+        BTreeMap<KEY,T,tlt,LT>* ref_map;
+        int                  expected_mod_count;
+        bool                 can_erase = true;
+
+        //Helper methods
+        Entry* current       () const;                     //Current entry, or nullptr at the end
+        void   push_left     (BN* root);                   //Push Cursors down root's leftmost path
+        void   skip_finished ();                           //Pop Cursors whose node has no entries left to visit
+        void   seek          (const KEY& key, bool inclusive); //Reset path to the first entry whose key is >= key (inclusive) or > key
+
+        //Called in friends begin/end/lower_bound/upper_bound/floor
+        Iterator(BTreeMap<KEY,T,tlt,LT>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+    //A Range is the half-open span [first,last) of a map's Iterators, for use in a
+    //  "for-each" loop: for (const Entry& e : m.range(lo,hi)) ...
+    class Range {
+      public:
+        Iterator begin () const {return first;}
+        Iterator end   () const {return last;}
+
+      private:
+        Iterator first;
+        Iterator last;
+
+        Range(const Iterator& f, const Iterator& l) : first(f), last(l) {}
+        friend class BTreeMap<KEY,T,tlt,LT>;
+    };
+
+
+    //Ordered queries: each descends the tree once (twice for floor) to position the
+    //  returned Iterator, which then streams the following keys in order; it is end()
+    //  if there is no such key
+    Iterator lower_bound (const KEY& key) const;        //First key >= key
+    Iterator upper_bound (const KEY& key) const;        //First key >  key
+    Iterator floor       (const KEY& key) const;        //Last  key <= key (predecessor-or-equal)
+    Iterator ceiling     (const KEY& key) const;        //First key >= key (same as lower_bound)
+    Range    range       (const KEY& lo, const KEY& hi) const; //All keys in [lo,hi) (none if hi <= lo)
+
+
+  private:
+    //About 256 bytes of entries per node (at least 3), so small entries share cache lines
+    static const int min_degree = 128/sizeof(Entry) >= 2 ? 128/sizeof(Entry) : 2;
+    static const int max_keys   = 2*min_degree-1;
+
+    class BN {
+      public:
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(BN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(BN)>::deallocate(p);}
+
+        int   count = 0;                 //entries[0..count-1] are in use, in increasing key order
+        bool  leaf  = true;              //If false, children[0..count] are all non-nullptr
+        Entry entries [max_keys];
+        BN*   children[max_keys+1];
+    };
+
+  bool (*lt) (const KEY& a, const KEY& b); // The lt used for searching the B-tree (from template or constructor)
+  BN* map       = nullptr;                 //Root; nullptr iff the map is empty
+  int used      = 0;                       //Cache for number of key->value pairs in the B-tree
+  int mod_count = 0;                       //For sensing concurrent modification
+
+  static_assert(std::is_same<LT,undefinedfunctor>::value || tlt == (ltfunc)undefinedlt<KEY>,
+                "BTreeMap: supply tlt or LT, not both");
+  static ltfunc template_lt ();                      //functor_lt if LT is supplied, else tlt (undefinedlt if neither)
+  static bool functor_lt  (const KEY& a, const KEY& b);
+  bool less_than (const KEY& a, const KEY& b) const;   //lt(a,b), called directly when tlt/LT fixes it at compile time
+
+  //Helper methods (all iterative)
+  int    index_of          (BN* n, const KEY& key)                       const; //First i with !less_than(n->entries[i].first,key), or n->count
+  Entry* find_key          (const KEY& key)                              const; //Returns key's entry or nullptr
+  BN*    copy              (BN* root)                                    const; //Copy the keys/values in root's tree (identical structure)
+  template <class V>
+  Entry* find_or_insert    (const KEY& key, V&& value, bool& inserted);         //Return key's entry, adding key->value (copied or moved) first (inserted = true) if key absent
+  T      remove            (const KEY& key);                                    //Remove key->value, returning value (KeyError if absent)
+  void   delete_tree       (BN*& root);                                         //Deallocate all BN in tree; root == nullptr
+
+  void   split_child       (BN* parent, int i);  //Full children[i] keeps its lower half; entries[i] becomes its median; children[i+1] its upper half
+  void   merge_children    (BN* parent, int i);  //children[i] absorbs entries[i] and children[i+1] (deleted); both had min_degree-1 entries
+  void   borrow_from_left  (BN* parent, int i);  //children[i] gets entries[i-1]; entries[i-1] gets children[i-1]'s last entry
+  void   borrow_from_right (BN* parent, int i);  //children[i] gets entries[i];   entries[i]   gets children[i+1]'s first entry
+  static void move_entry   (Entry& to, Entry& from); //Shift an entry between slots without copying its key/value
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BTreeMap class and related definitions
+
+//Destructor/Constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::~BTreeMap() {
+    delete_tree(map);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(bool (*clt)(const KEY& a, const KEY& b))
+: lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
+{
+    if (lt == (ltfunc)undefinedlt<KEY>)
+        throw TemplateFunctionError("BTreeMap::default constructor: neither specified");
+    if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
+        throw TemplateFunctionError("BTreeMap::default constructor: both specified and different");
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(const BTreeMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+: lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
+{
+    if (lt == (ltfunc)undefinedlt<KEY>)
+        lt = to_copy.lt;
+    if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
+        throw TemplateFunctionError("BTreeMap::copy constructor: both specified and different");
+
+    if (lt == to_copy.lt) {
+        used = to_copy.used;
+        map  = copy(to_copy.map);
+    }else
+        put_all(to_copy);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(BTreeMap<KEY,T,tlt,LT>&& to_move)
+: lt(to_move.lt), map(to_move.map), used(to_move.used)
+{
+    to_move.map  = nullptr;
+    to_move.used = 0;
+    ++to_move.mod_count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+: lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
+{
+    if (lt == (ltfunc)undefinedlt<KEY>)
+        throw TemplateFunctionError("BTreeMap::initializer_list constructor: neither specified");
+    if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
+        throw TemplateFunctionError("BTreeMap::initializer_list constructor: both specified and different");
+
+    put_all(il);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class Iterable>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+: lt(template_lt() != (ltfunc)undefinedlt<KEY> ? template_lt() : clt)
+{
+    if (lt == (ltfunc)undefinedlt<KEY>)
+        throw TemplateFunctionError("BTreeMap::Iterable constructor: neither specified");
+    if (template_lt() != (ltfunc)undefinedlt<KEY> && clt != (ltfunc)undefinedlt<KEY> && template_lt() != clt)
+        throw TemplateFunctionError("BTreeMap::Iterable constructor: both specified and different");
+
+    put_all(i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::empty() const {
+    return used == 0;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BTreeMap<KEY,T,tlt,LT>::size() const {
+    return used;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::has_key (const KEY& key) const {
+    return find_key(key) != nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::has_value (const T& value) const {
+    ArrayStack<BN*> to_visit;
+    if (map != nullptr)
+        to_visit.push(map);
+    while (!to_visit.empty()) {
+        BN* n = to_visit.pop();
+        for (int i = 0; i < n->count; ++i)
+            if (n->entries[i].second == value)
+                return true;
+        if (!n->leaf)
+            for (int i = 0; i <= n->count; ++i)
+                to_visit.push(n->children[i]);
+    }
+    return false;
+}
+
+
+//One line per node (preorder), indented by depth
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BTreeMap<KEY,T,tlt,LT>::str() const {
+    std::ostringstream answer;
+    answer << "BTreeMap[used=" << used << ",mod_count=" << mod_count << ",max_keys=" << max_keys << "]";
+    ArrayStack<pair<BN*,int>> to_visit;      //Node, and its depth
+    if (map != nullptr)
+        to_visit.push(pair<BN*,int>(map,0));
+    while (!to_visit.empty()) {
+        pair<BN*,int> next = to_visit.pop();
+        BN* n = next.first;
+        answer << "\n" << std::string(2*next.second,' ') << "[";
+        for (int i = 0; i < n->count; ++i)
+            answer << (i == 0 ? "" : ",") << n->entries[i].first << "->" << n->entries[i].second;
+        answer << "]";
+        if (!n->leaf)
+            for (int i = n->count; i >= 0; --i)  //Pushed last-first, so visited first-last
+                to_visit.push(pair<BN*,int>(n->children[i],next.second+1));
+    }
+    return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::put(const KEY& key, const T& value) {
+    ++mod_count;
+    bool inserted;
+    Entry* e = find_or_insert(key,value,inserted);
+    if (inserted)
+        return value;
+    T to_return = std::move(e->second);
+    e->second = value;
+    return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::put(const KEY& key, T&& value) {
+    ++mod_count;
+    bool inserted;
+    Entry* e = find_or_insert(key,std::move(value),inserted);
+    if (inserted)
+        return e->second;
+    T to_return = std::move(e->second);
+    e->second = std::move(value);           //Not moved from by find_or_insert: key was present
+    return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class... Args>
+T& BTreeMap<KEY,T,tlt,LT>::emplace(const KEY& key, Args&&... args) {
+    ++mod_count;
+    T value(std::forward<Args>(args)...);
+    bool inserted;
+    Entry* e = find_or_insert(key,std::move(value),inserted);
+    if (!inserted)
+        e->second = std::move(value);
+    return e->second;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::erase(const KEY& key) {
+    ++mod_count;
+    return remove(key);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::clear() {
+    ++mod_count;
+    delete_tree(map);
+    used = 0;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template<class Iterable>
+int BTreeMap<KEY,T,tlt,LT>::put_all(const Iterable& i) {
+    int count = 0;
+    for (const Entry& p : i) {
+        ++count;
+        put(p.first,p.second);
+    }
+    return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T& BTreeMap<KEY,T,tlt,LT>::operator [] (const KEY& key) {
+    bool inserted;
+    Entry* e = find_or_insert(key,T(),inserted);
+    if (inserted)
+        ++mod_count;
+    return e->second;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+const T& BTreeMap<KEY,T,tlt,LT>::operator [] (const KEY& key) const {
+    Entry* e = find_key(key);
+    if (e == nullptr) {
+        std::ostringstream answer;
+        answer << "BTreeMap::operator []: key(" << key << ") not in Map";
+        throw KeyError(answer.str());
+    }
+    return e->second;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>& BTreeMap<KEY,T,tlt,LT>::operator = (const BTreeMap<KEY,T,tlt,LT>& rhs) {
+    if (this == &rhs)
+        return *this;
+    delete_tree(map);
+    lt   = rhs.lt;
+    map  = copy(rhs.map);
+    used = rhs.used;
+    ++mod_count;
+    return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>& BTreeMap<KEY,T,tlt,LT>::operator = (BTreeMap<KEY,T,tlt,LT>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(lt,   rhs.lt);
+    std::swap(map,  rhs.map);
+    std::swap(used, rhs.used);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::operator == (const BTreeMap<KEY,T,tlt,LT>& rhs) const {
+    if (this == &rhs)
+        return true;
+    if (used != rhs.size())
+        return false;
+    for (const Entry& entry : *this) {
+        Entry* e = rhs.find_key(entry.first);
+        if (e == nullptr || e->second != entry.second)
+            return false;
+    }
+    return true;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::operator != (const BTreeMap<KEY,T,tlt,LT>& rhs) const {
+    return !(*this == rhs);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::ostream& operator << (std::ostream& outs, const BTreeMap<KEY,T,tlt,LT>& m) {
+    outs << "map[";
+    int count = 0;
+    for (const typename BTreeMap<KEY,T,tlt,LT>::Entry& entry : m)
+        outs << (count++ == 0 ? "" : ",") << entry.first << "->" << entry.second;
+    outs << "]";
+    return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::begin () const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    return Iterator(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this), true);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::end () const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    return Iterator(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this), false);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::lower_bound (const KEY& key) const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    Iterator i(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this), false);
+    i.seek(key, true);
+    return i;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::upper_bound (const KEY& key) const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    Iterator i(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this), false);
+    i.seek(key, false);
+    return i;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::floor (const KEY& key) const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    const KEY* last_le = nullptr;            //Last key on the search path that is <= key
+    for (BN* n = map; n != nullptr; ) {
+        int i = index_of(n,key);
+        if (i < n->count && key == n->entries[i].first) {
+            last_le = &n->entries[i].first;
+            break;
+        }
+        if (i > 0)
+            last_le = &n->entries[i-1].first;
+        n = (n->leaf ? nullptr : n->children[i]);
+    }
+
+    Iterator i(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this), false);
+    if (last_le != nullptr)
+        i.seek(*last_le, true);
+    return i;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::ceiling (const KEY& key) const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    return lower_bound(key);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::range (const KEY& lo, const KEY& hi) const -> BTreeMap<KEY,T,tlt,LT>::Range {
+    if (!less_than(lo,hi))
+        return Range(end(), end());
+    return Range(lower_bound(lo), lower_bound(hi));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BTreeMap<KEY,T,tlt,LT>::ltfunc BTreeMap<KEY,T,tlt,LT>::template_lt () {
+    return !std::is_same<LT,undefinedfunctor>::value ? functor_lt : tlt;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::functor_lt (const KEY& a, const KEY& b) {
+    return LT()(a,b);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::less_than (const KEY& a, const KEY& b) const {
+    if (!std::is_same<LT,undefinedfunctor>::value)
+        return LT()(a,b);
+    if (tlt != (ltfunc)undefinedlt<KEY>)
+        return tlt(a,b);
+    return lt(a,b);
+}
+
+
+//Binary search: entries are few and contiguous, so this touches only a node's own lines
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BTreeMap<KEY,T,tlt,LT>::index_of (BN* n, const KEY& key) const {
+    int low = 0, high = n->count;
+    while (low < high) {
+        int mid = (low+high)/2;
+        if (less_than(n->entries[mid].first,key))
+            low = mid+1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::find_key (const KEY& key) const -> Entry* {
+    for (BN* n = map; n != nullptr; ) {
+        int i = index_of(n,key);
+        if (i < n->count && key == n->entries[i].first)
+            return &n->entries[i];
+        n = (n->leaf ? nullptr : n->children[i]);
+    }
+    return nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BTreeMap<KEY,T,tlt,LT>::BN* BTreeMap<KEY,T,tlt,LT>::copy (BN* root) const {
+    BN* to_return = nullptr;
+    ArrayStack<pair<BN*,BN**>> to_copy;      //Node to copy, and the link its copy is stored in
+    if (root != nullptr)
+        to_copy.push(ics::make_pair(root,&to_return));
+    while (!to_copy.empty()) {
+        pair<BN*,BN**> next = to_copy.pop();
+        BN* n = *next.second = new BN(*next.first);
+        if (!n->leaf)
+            for (int i = 0; i <= n->count; ++i)
+                to_copy.push(ics::make_pair(n->children[i],&n->children[i]));
+    }
+    return to_return;
+}
+
+
+//Looks key up first, so finding a present key never restructures the tree (and so is
+//  not a modification). Otherwise splits every full node it is about to enter, so there
+//  is always room in the parent for the median of a split (and in the leaf for the new
+//  entry).
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class V>
+auto BTreeMap<KEY,T,tlt,LT>::find_or_insert (const KEY& key, V&& value, bool& inserted) -> Entry* {
+    Entry* e = find_key(key);
+    if (e != nullptr) {
+        inserted = false;
+        return e;
+    }
+
+    inserted = true;
+    if (map == nullptr)
+        map = new BN();
+    if (map->count == max_keys) {
+        BN* new_root = new BN();
+        new_root->leaf        = false;
+        new_root->children[0] = map;
+        map = new_root;
+        split_child(map,0);
+    }
+
+    for (BN* n = map; ; ) {
+        int i = index_of(n,key);
+        if (n->leaf) {
+            for (int j = n->count; j > i; --j)
+                move_entry(n->entries[j], n->entries[j-1]);
+            n->entries[i].first  = key;
+            n->entries[i].second = std::forward<V>(value);
+            ++n->count;
+            ++used;
+            return &n->entries[i];
+        }
+        if (n->children[i]->count == max_keys) {
+            split_child(n,i);
+            if (less_than(n->entries[i].first,key))
+                ++i;
+        }
+        n = n->children[i];
+    }
+}
+
+
+//Before entering a child, makes sure it has at least min_degree entries (borrowing from
+//  or merging with a sibling), so deleting from a leaf never leaves it underfull. A key
+//  found in an internal node is replaced by its predecessor/successor, which is then
+//  deleted from that child's subtree in the same descent.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::remove (const KEY& key) {
+    T    to_return;
+    bool found   = false;
+    const KEY* target = &key;                //Key being deleted: key, or its replacement's
+    for (BN* n = map; n != nullptr; ) {
+        int  i    = index_of(n,*target);
+        bool here = i < n->count && *target == n->entries[i].first;
+        if (here && !found) {
+            to_return = std::move(n->entries[i].second);
+            found     = true;
+        }
+
+        if (n->leaf) {
+            if (!here)
+                break;
+            for (int j = i; j < n->count-1; ++j)
+                move_entry(n->entries[j], n->entries[j+1]);
+            --n->count;
+            --used;
+            if (map->count == 0) {
+                delete map;
+                map = nullptr;
+            }
+            return to_return;
+        }
+
+        BN* next;
+        if (here) {
+            BN* left  = n->children[i];
+            BN* right = n->children[i+1];
+            if (left->count >= min_degree) {
+                BN* p = left;
+                while (!p->leaf)
+                    p = p->children[p->count];
+                n->entries[i] = p->entries[p->count-1];  //Copied: target must still find p's entry below
+                target = &n->entries[i].first;
+                next   = left;
+            }else if (right->count >= min_degree) {
+                BN* s = right;
+                while (!s->leaf)
+                    s = s->children[0];
+                n->entries[i] = s->entries[0];           //Copied: target must still find s's entry below
+                target = &n->entries[i].first;
+                next   = right;
+            }else {
+                merge_children(n,i);
+                next = left;
+            }
+        }else {
+            if (n->children[i]->count < min_degree) {
+                if (i > 0 && n->children[i-1]->count >= min_degree)
+                    borrow_from_left(n,i);
+                else if (i < n->count && n->children[i+1]->count >= min_degree)
+                    borrow_from_right(n,i);
+                else
+                    merge_children(n, (i < n->count ? i : --i));
+            }
+            next = n->children[i];
+        }
+
+        if (n == map && n->count == 0) {     //A merge emptied the root: its only child replaces it
+            map = next;
+            delete n;
+        }
+        n = next;
+    }
+
+    std::ostringstream answer;
+    answer << "BTreeMap::erase: key(" << key << ") not in Map";
+    throw KeyError(answer.str());
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::delete_tree (BN*& root) {
+    ArrayStack<BN*> to_delete;
+    if (root != nullptr)
+        to_delete.push(root);
+    while (!to_delete.empty()) {
+        BN* n = to_delete.pop();
+        if (!n->leaf)
+            for (int i = 0; i <= n->count; ++i)
+                to_delete.push(n->children[i]);
+        delete n;
+    }
+    root = nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::split_child (BN* parent, int i) {
+    BN* full  = parent->children[i];
+    BN* upper = new BN();
+    upper->leaf  = full->leaf;
+    upper->count = min_degree-1;
+    for (int j = 0; j < min_degree-1; ++j)
+        move_entry(upper->entries[j], full->entries[j+min_degree]);
+    if (!full->leaf)
+        for (int j = 0; j < min_degree; ++j)
+            upper->children[j] = full->children[j+min_degree];
+    full->count = min_degree-1;
+
+    for (int j = parent->count; j > i; --j) {
+        move_entry(parent->entries [j], parent->entries [j-1]);
+        parent->children[j+1] = parent->children[j];
+    }
+    move_entry(parent->entries [i], full->entries[min_degree-1]);
+    parent->children[i+1] = upper;
+    ++parent->count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::merge_children (BN* parent, int i) {
+    BN* left  = parent->children[i];
+    BN* right = parent->children[i+1];
+    move_entry(left->entries[left->count], parent->entries[i]);
+    for (int j = 0; j < right->count; ++j)
+        move_entry(left->entries[left->count+1+j], right->entries[j]);
+    if (!left->leaf)
+        for (int j = 0; j <= right->count; ++j)
+            left->children[left->count+1+j] = right->children[j];
+    left->count += 1+right->count;
+
+    for (int j = i; j < parent->count-1; ++j) {
+        move_entry(parent->entries [j], parent->entries [j+1]);
+        parent->children[j+1] = parent->children[j+2];
+    }
+    --parent->count;
+    delete right;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::borrow_from_left (BN* parent, int i) {
+    BN* child   = parent->children[i];
+    BN* sibling = parent->children[i-1];
+    for (int j = child->count; j > 0; --j)
+        move_entry(child->entries[j], child->entries[j-1]);
+    if (!child->leaf)
+        for (int j = child->count+1; j > 0; --j)
+            child->children[j] = child->children[j-1];
+
+    move_entry(child->entries[0], parent->entries[i-1]);
+    if (!child->leaf)
+        child->children[0] = sibling->children[sibling->count];
+    move_entry(parent->entries[i-1], sibling->entries[sibling->count-1]);
+    ++child->count;
+    --sibling->count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::borrow_from_right (BN* parent, int i) {
+    BN* child   = parent->children[i];
+    BN* sibling = parent->children[i+1];
+    move_entry(child->entries[child->count], parent->entries[i]);
+    if (!child->leaf)
+        child->children[child->count+1] = sibling->children[0];
+    move_entry(parent->entries[i], sibling->entries[0]);
+    ++child->count;
+
+    for (int j = 0; j < sibling->count-1; ++j)
+        move_entry(sibling->entries[j], sibling->entries[j+1]);
+    if (!sibling->leaf)
+        for (int j = 0; j < sibling->count; ++j)
+            sibling->children[j] = sibling->children[j+1];
+    --sibling->count;
+}
+
+
+//Member-wise, so it moves even if Entry's own assignment only copies
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::move_entry (Entry& to, Entry& from) {
+    to.first  = std::move(from.first);
+    to.second = std::move(from.second);
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::Iterator::Iterator(BTreeMap<KEY,T,tlt,LT>* iterate_over, bool from_begin)
+: ref_map(iterate_over), expected_mod_count(ref_map->mod_count)
+{
+    if (from_begin)
+        push_left(ref_map->map);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::Iterator::erase() -> Entry {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::erase");
+    if (!can_erase)
+        throw CannotEraseError("BTreeMap::Iterator::erase Iterator cursor already erased");
+    if (path.empty())
+        throw CannotEraseError("BTreeMap::Iterator::erase Iterator cursor beyond data structure");
+
+    can_erase = false;
+    Entry to_return = *current();
+    //Erasing may move entries between nodes or free nodes on path, so re-find the successor
+    ref_map->erase(to_return.first);
+    seek(to_return.first, false);
+    expected_mod_count = ref_map->mod_count;
+    return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BTreeMap<KEY,T,tlt,LT>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_map->str() << "(path size=" << path.size() << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+    return answer.str();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto  BTreeMap<KEY,T,tlt,LT>::Iterator::operator ++ () -> BTreeMap<KEY,T,tlt,LT>::Iterator& {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::operator ++");
+
+    if (path.empty())
+        return *this;
+
+    if (can_erase) {
+        Cursor& c = path.peek();
+        BN*     n = c.first;
+        int     i = ++c.second;
+        if (n->leaf)
+            skip_finished();
+        else
+            push_left(n->children[i]);
+    }else
+        can_erase = true;
+
+    return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::Iterator::operator ++ (int) -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::operator ++(int)");
+
+    if (path.empty())
+        return *this;
+
+    Iterator to_return(*this);
+    ++(*this);
+    return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::Iterator::operator == (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+    if (rhsASI == 0)
+        throw IteratorTypeError("BTreeMap::Iterator::operator ==");
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::operator ==");
+    if (ref_map != rhsASI->ref_map)
+        throw ComparingDifferentIteratorsError("BTreeMap::Iterator::operator ==");
+
+    return current() == rhsASI->current();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::Iterator::operator != (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+    if (rhsASI == 0)
+        throw IteratorTypeError("BTreeMap::Iterator::operator !=");
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::operator !=");
+    if (ref_map != rhsASI->ref_map)
+        throw ComparingDifferentIteratorsError("BTreeMap::Iterator::operator !=");
+
+    return current() != rhsASI->current();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T>& BTreeMap<KEY,T,tlt,LT>::Iterator::operator *() const {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::operator *");
+    if (!can_erase || path.empty())
+        throw IteratorPositionIllegal("BTreeMap::Iterator::operator * Iterator illegal: " +
+                                      std::string(path.empty() ? "beyond data structure" : "already erased"));
+    return *current();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T>* BTreeMap<KEY,T,tlt,LT>::Iterator::operator ->() const {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("BTreeMap::Iterator::operator ->");
+    if (!can_erase || path.empty())
+        throw IteratorPositionIllegal("BTreeMap::Iterator::operator -> Iterator illegal: " +
+                                      std::string(path.empty() ? "beyond data structure" : "already erased"));
+    return current();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::Iterator::current() const -> Entry* {
+    if (path.empty())
+        return nullptr;
+    Cursor& c = path.peek();
+    return &c.first->entries[c.second];
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::Iterator::push_left(BN* root) {
+    for (; root != nullptr; root = (root->leaf ? nullptr : root->children[0]))
+        path.push(Cursor(root,0));
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::Iterator::skip_finished() {
+    while (!path.empty() && path.peek().second == path.peek().first->count)
+        path.pop();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::Iterator::seek(const KEY& key, bool inclusive) {
+    path.clear();
+    for (BN* n = ref_map->map; n != nullptr; ) {
+        int  i     = ref_map->index_of(n,key);
+        bool equal = i < n->count && key == n->entries[i].first;
+        if (equal && inclusive) {
+            path.push(Cursor(n,i));
+            return;
+        }
+        if (equal) {                         //Successor: the first entry after children[i+1]
+            path.push(Cursor(n,i+1));
+            if (!n->leaf)
+                push_left(n->children[i+1]);
+            break;
+        }
+        path.push(Cursor(n,i));
+        n = (n->leaf ? nullptr : n->children[i]);
+    }
+    skip_finished();
+}
+
+
+}
+
+#endif /* BTREE_MAP_HPP_ */
@@ -11,7 +11,10 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
 #include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
 #include "pair.hpp"
 
 
@@ -24,12 +27,26 @@ template<class T>
 int undefinedhash (const T& a) {return 0;}
 #endif /* undefinedhashdefined */
 
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
 //Instantiate the templated class supplying thash(a): produces a hash value for a.
 //If thash is defaulted to undefinedhash in the template, then a constructor must supply chash.
 //If both thash and chash are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-undefinedhash value supplied by thash/chash is stored in the instance variable hash.
-template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> class HashMap {
+//Alternatively, leave thash defaulted and supply a stateless functor type HASH (e.g., std::hash<KEY>, or a
+//  lambda's type in C++20): HASH()(...) is then called directly, so it can be inlined (as is a
+//  thash template argument); only a chash supplied at run time is called through the pointer hash.
+//Supplying both thash and HASH is a compile-time error.
+template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>, class HASH = undefinedfunctor> class HashMap {
   public:
     typedef ics::pair<KEY,T>   Entry;
     typedef int (*hashfunc) (const KEY& a);
@@ -39,7 +56,8 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
 
     HashMap          (double the_load_threshold = 1.0, int (*chash)(const KEY& a) = undefinedhash<KEY>);
     explicit HashMap (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const KEY& k) = undefinedhash<KEY>);
-    HashMap          (const HashMap<KEY,T,thash>& to_copy, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = undefinedhash<KEY>);
+    HashMap          (const HashMap<KEY,T,thash,HASH>& to_copy, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = undefinedhash<KEY>);
+    HashMap          (HashMap<KEY,T,thash,HASH>&& to_move);   //O(1): takes to_move's table(s), leaving it empty
     explicit HashMap (const std::initializer_list<Entry>& il, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = undefinedhash<KEY>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -56,9 +74,17 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
 
 
     //Commands
-    T    put   (const KEY& key, const T& value);
-    T    erase (const KEY& key);
-    void clear ();
+    T    put         (const KEY& key, const T& value);
+    T    put         (const KEY& key, T&& value);
+    T&   try_emplace (const KEY& key, const T& value = T()); //Return reference to key's value (adding key->value first, if key absent)
+    T&   try_emplace (const KEY& key, T&& value);
+
+    //Like put, but the value is T(args...) moved into key's node; returns a reference to it
+    template <class... Args>
+    T&   emplace     (const KEY& key, Args&&... args);
+    T    erase       (const KEY& key);
+    void clear       ();
+    void set_rehash_step (int bins_per_op); //Resize incrementally, moving bins_per_op old bins per put/erase (0: all at once)
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
@@ -69,12 +95,13 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
 
     T&       operator [] (const KEY&);
     const T& operator [] (const KEY&) const;
-    HashMap<KEY,T,thash>& operator = (const HashMap<KEY,T,thash>& rhs);
-    bool operator == (const HashMap<KEY,T,thash>& rhs) const;
-    bool operator != (const HashMap<KEY,T,thash>& rhs) const;
+    HashMap<KEY,T,thash,HASH>& operator = (const HashMap<KEY,T,thash,HASH>& rhs);
+    HashMap<KEY,T,thash,HASH>& operator = (HashMap<KEY,T,thash,HASH>&& rhs);   //O(1): swaps table(s) with rhs
+    bool operator == (const HashMap<KEY,T,thash,HASH>& rhs) const;
+    bool operator != (const HashMap<KEY,T,thash,HASH>& rhs) const;
 
-    template<class KEY2,class T2, int (*hash2)(const KEY2& a)>
-    friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY2,T2,hash2>& m);
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY2,T2,hash2,HASH2>& m);
 
 
 
@@ -90,23 +117,23 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
         ~Iterator();
         Entry       erase();
         std::string str  () const;
-        HashMap<KEY,T,thash>::Iterator& operator ++ ();
-        HashMap<KEY,T,thash>::Iterator  operator ++ (int);
-        bool operator == (const HashMap<KEY,T,thash>::Iterator& rhs) const;
-        bool operator != (const HashMap<KEY,T,thash>::Iterator& rhs) const;
+        HashMap<KEY,T,thash,HASH>::Iterator& operator ++ ();
+        HashMap<KEY,T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
         Entry& operator *  () const;
         Entry* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash,HASH>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator HashMap<KEY,T,thash>::begin () const;
-        friend Iterator HashMap<KEY,T,thash>::end   () const;
+        friend Iterator HashMap<KEY,T,thash,HASH>::begin () const;
+        friend Iterator HashMap<KEY,T,thash,HASH>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
         Cursor                current; //Bin Index and Cursor; stops if LN* == nullptr
-        HashMap<KEY,T,thash>* ref_map;
+        HashMap<KEY,T,thash,HASH>* ref_map;
         int                   expected_mod_count;
         bool                  can_erase = true;
 
@@ -114,7 +141,7 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
         void advance_cursors();
 
         //Called in friends begin/end
-        Iterator(HashMap<KEY,T,thash>* iterate_over, bool from_begin);
+        Iterator(HashMap<KEY,T,thash,HASH>* iterate_over, bool from_begin);
     };
 
 
@@ -126,28 +153,56 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
     class LN {
     public:
       LN ()                         : next(nullptr){}
-      LN (const LN& ln)             : value(ln.value), next(ln.next){}
-      LN (Entry v, LN* n = nullptr) : value(v), next(n){}
+      LN (const LN& ln)             : value(ln.value), hashed(ln.hashed), next(ln.next){}
+      LN (const Entry& v, int h, LN* n = nullptr) : value(v), hashed(h), next(n){}
+      LN (const KEY& k, const T& v, int h, LN* n = nullptr) : value(k,v), hashed(h), next(n){}
+      LN (const KEY& k, T&& v,      int h, LN* n = nullptr) : hashed(h), next(n){value.first = k; value.second = std::move(v);}
+      static void* operator new    (std::size_t)  {return NodePool<sizeof(LN)>::allocate();}
+      static void  operator delete (void* p)      {NodePool<sizeof(LN)>::deallocate(p);}
 
       Entry value;
+      int   hashed = 0;  //Cached hash_mix(value.first): rehashing never calls hash, and chain walks compare it first
       LN*   next;
   };
 
   int (*hash)(const KEY& k);  //Hashing function used (from template or constructor)
   LN** map      = nullptr;    //Pointer to array of pointers: each bin stores a list with a trailer node
   double load_threshold;      //used/bins <= load_threshold
-  int bins      = 1;          //# bins in array (should start >= 1 so hash_compress doesn't % 0)
+  int bins      = 1;          //# bins in array (always a power of 2, so compress masks instead of %)
   int used      = 0;          //Cache for number of key->value pairs in the hash table
   int mod_count = 0;          //For sensing concurrent modification
 
+  static_assert(std::is_same<HASH,undefinedfunctor>::value || thash == (hashfunc)undefinedhash<KEY>,
+                "HashMap: supply thash or HASH, not both");
+  static hashfunc template_hash ();                      //functor_hash if HASH is supplied, else thash (undefinedhash if neither)
+  static int functor_hash  (const KEY& a);
+  int hash_of (const KEY& a) const;   //hash(a), called directly when thash/HASH fixes it at compile time
+
+  //While resizing incrementally, both tables are live: an entry is in old_map iff its old bin is >= migrated.
+  //Old bin b drains only into map bins b and b+old_bins, which are allocated (given trailers) when b is migrated.
+  LN** old_map     = nullptr; //Table being drained into map (nullptr when not resizing)
+  int  old_bins    = 0;       //# bins in old_map
+  int  migrated    = 0;       //# old_map bins (from 0) whose nodes have been relinked into map
+  int  rehash_step = 0;       //# old bins relinked per put/erase; 0 relinks them all when the resize starts
+
 
   //Helper methods
   int   hash_compress        (const KEY& key)          const;  //hash function ranged to [0,bins-1]
+  int   hash_mix             (const KEY& key)          const;  //hash function with its bits mixed (so masking keeps them all)
+  int   compress             (int hashed, int n)       const;  //already-mixed hash ranged to [0,n-1] (n a power of 2)
+  static int power_of_two    (int n);                          //Smallest power of 2 >= n (and >= 1)
+  LN*&  bin_front            (int hashed)              const;  //Returns reference to the front of hashed's bin (in map or old_map)
+  LN*   bin_at               (int i)                   const;  //Bins [0,bins) are map's, [bins,bins+old_bins) are old_map's (empty_bin if not live)
+  static LN* empty_bin       ();                               //Shared trailer standing in for bins not live during a resize
   LN*   find_key             (LN* front, const KEY& key) const;           //Returns reference to key's node or nullptr
+  LN*&  find_link            (int hashed, const KEY& key) const; //Returns reference to the pointer to key's node (or to its bin's trailer)
+  template <class V>
+  LN*   find_or_insert       (const KEY& key, int hashed, V&& value, bool& inserted); //Walk once; add key->value (copied or moved) if absent
   LN*   copy_list            (LN*   l)                 const;  //Copy the keys/values in a bin (order irrelevant)
   LN**  copy_hash_table      (LN** ht, int bins)       const;  //Copy the bins/keys/values in ht tree (order in bins irrelevant)
 
-  void  ensure_load_threshold(int new_used);                   //Reallocate if load_factor > load_threshold
+  void  ensure_load_threshold(int new_used);                   //Start a resize if load_factor > load_threshold
+  void  migrate_bins         (int n);                          //Relink the nodes in the next n old_map bins into map
   void  delete_hash_table    (LN**& ht, int bins);             //Deallocate all LN in ht (and the ht itself; ht == nullptr)
 };
 
@@ -161,107 +216,122 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
 
 //Destructor/Constructors
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::~HashMap() {
-    delete [] map;
-
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::~HashMap() {
+    if (old_map != nullptr)
+        migrate_bins(old_bins);
+    delete_hash_table(map,bins);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(double the_load_threshold, int (*chash)(const KEY& k))
-: hash(thash != (hashfunc)undefinedhash<KEY> ? thash : chash)
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash)
 {
     if (hash == (hashfunc)undefinedhash<KEY>)
         throw TemplateFunctionError("HashMap::default constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
         throw TemplateFunctionError("HashMap::default constructor: both specified and different");
 
     map = new LN*[bins];
     map[0]=new LN();
-    load_threshold=1;
+    load_threshold = the_load_threshold;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k))
-: hash(thash != (hashfunc)undefinedhash<KEY> ? thash : chash), bins(initial_bins)
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash), bins(power_of_two(initial_bins))
 {
     if (hash == (hashfunc)undefinedhash<KEY>)
         throw TemplateFunctionError("HashMap::length constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
         throw TemplateFunctionError("HashMap::length constructor: both specified and different");
 
-    bins = initial_bins;
     map = new LN*[bins];
     for(int i=0; i < bins; i++ ){
         map[i] = new LN();
     }
-
+    load_threshold = the_load_threshold;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(const HashMap<KEY,T,thash>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
-: hash(to_copy.hash), used(to_copy.used), bins(to_copy.bins)
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(const HashMap<KEY,T,thash,HASH>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
+: hash(to_copy.hash), load_threshold(to_copy.load_threshold), bins(to_copy.bins), rehash_step(to_copy.rehash_step)
 {
     if (hash == (hashfunc)undefinedhash<KEY>)
         hash = to_copy.hash;
-    if (thash != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
         throw TemplateFunctionError("HashMap::copy constructor: both specified and different");
 
     map = new LN*[bins];
-    if (hash == to_copy.hash) {
+    if (hash == to_copy.hash && to_copy.old_map == nullptr) {
         used = to_copy.used;
         for (int i = 0; i < to_copy.bins; ++i)
             map[i] = copy_list(to_copy.map[i]);
     }
     else {
-        map = new LN*[bins];
         for (int i = 0; i < bins; ++i)
             map[i] = new LN();
-        for (int i = 0; i < to_copy.bins; ++i)
-            for (LN * p = to_copy.map[i]; p->next != nullptr; p = p->next)
-                put(p->value.first, p->value.second);
-
+        for (int i = 0; i < to_copy.bins+to_copy.old_bins; ++i)
+            for (LN * p = to_copy.bin_at(i); p->next != nullptr; p = p->next) {
+                bool inserted;
+                find_or_insert(p->value.first, hash == to_copy.hash ? p->hashed : hash_mix(p->value.first), p->value.second, inserted);
+            }
     }
+}
 
 
-
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(HashMap<KEY,T,thash,HASH>&& to_move)
+: hash(to_move.hash), map(to_move.map), load_threshold(to_move.load_threshold), bins(to_move.bins), used(to_move.used),
+  old_map(to_move.old_map), old_bins(to_move.old_bins), migrated(to_move.migrated), rehash_step(to_move.rehash_step)
+{
+    to_move.bins     = 1;
+    to_move.map      = new LN*[1];
+    to_move.map[0]   = new LN();
+    to_move.used     = 0;
+    to_move.old_map  = nullptr;
+    to_move.old_bins = 0;
+    to_move.migrated = 0;
+    ++to_move.mod_count;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k))
-: hash(thash != (hashfunc)undefinedhash<KEY> ? thash : chash), bins(il.size())
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash), bins(power_of_two(il.size()))
 {
     if (hash == (hashfunc)undefinedhash<KEY>)
         throw TemplateFunctionError("HashMap::initializer_list constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
         throw TemplateFunctionError("HashMap::initializer_list constructor: both specified and different");
 
     map = new LN*[bins];
     for (int i = 0; i<bins; ++i)
         map[i] = new LN();
+    load_threshold = the_load_threshold;
 
     for (const Entry& entry : il)
         put(entry.first,entry.second);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
 template <class Iterable>
-HashMap<KEY,T,thash>::HashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k))
-: hash(thash != (hashfunc)undefinedhash<KEY> ? thash : chash), bins(i.size())
+HashMap<KEY,T,thash,HASH>::HashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash), bins(power_of_two(i.size()))
 {
     if (hash == (hashfunc)undefinedhash<KEY>)
         throw TemplateFunctionError("HashMap::Iterable constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
         throw TemplateFunctionError("HashMap::Iterable constructor: both specified and different");
 
     map = new LN*[bins];
     for (int i = 0; i<bins; ++i)
         map[i] = new LN();
+    load_threshold = the_load_threshold;
 
     for (const Entry& entry : i)
         put(entry.first,entry.second);
@@ -272,28 +342,28 @@ HashMap<KEY,T,thash>::HashMap(const Iterable& i, double the_load_threshold, int
 //
 //Queries
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::empty() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::empty() const {
     return used==0;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-int HashMap<KEY,T,thash>::size() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::size() const {
     return used;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::has_key (const KEY& key) const {
-    return find_key(map[hash_compress(key)],key)!=nullptr;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::has_key (const KEY& key) const {
+    return find_link(hash_mix(key),key)->next != nullptr;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::has_value (const T& value) const {
-    for(int i=0; i<bins; i++) {
-        for (LN *p = map[i]; p->next != nullptr; p = p->next) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::has_value (const T& value) const {
+    for(int i=0; i<bins+old_bins; i++) {
+        for (LN *p = bin_at(i); p->next != nullptr; p = p->next) {
             if (p->value.second == value) {
                 return true;
             }
@@ -303,12 +373,12 @@ bool HashMap<KEY,T,thash>::has_value (const T& value) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::string HashMap<KEY,T,thash>::str() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string HashMap<KEY,T,thash,HASH>::str() const {
     std::stringstream temp;
-    for(int i=0; i<bins; i++){
+    for(int i=0; i<bins+old_bins; i++){
         temp << " " << i << " : [";
-        for(LN* p=map[i]; p->next!=nullptr; p=p->next){
+        for(LN* p=bin_at(i); p->next!=nullptr; p=p->next){
 
             temp << '(' << p->value.first << ',' << p->value.second << ')';
         }
@@ -322,62 +392,97 @@ std::string HashMap<KEY,T,thash>::str() const {
 //
 //Commands
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
-    if(has_key(key)){
-        T to_return=find_key(map[hash_compress(key)],key)->value.second;
-        find_key(map[hash_compress(key)],key)->value.second=value;
-        return to_return;
-    }
-    used++;
-    ensure_load_threshold(used);
-    map[hash_compress(key)]=new LN(ics::make_pair(key,value),map[hash_compress(key)]);
-    ++mod_count;
-    return value;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T HashMap<KEY,T,thash,HASH>::put(const KEY& key, const T& value) {
+    bool inserted;
+    LN* p = find_or_insert(key,hash_mix(key),value,inserted);
+    if (inserted)
+        return value;
+    T to_return = p->value.second;
+    p->value.second = value;
+    return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T HashMap<KEY,T,thash,HASH>::put(const KEY& key, T&& value) {
+    bool inserted;
+    LN* p = find_or_insert(key,hash_mix(key),std::move(value),inserted);
+    if (inserted)
+        return p->value.second;
+    T to_return = std::move(p->value.second);
+    p->value.second = std::move(value);   //Not moved from by find_or_insert: key was present
+    return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T& HashMap<KEY,T,thash,HASH>::try_emplace(const KEY& key, const T& value) {
+    bool inserted;
+    return find_or_insert(key,hash_mix(key),value,inserted)->value.second;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T& HashMap<KEY,T,thash,HASH>::try_emplace(const KEY& key, T&& value) {
+    bool inserted;
+    return find_or_insert(key,hash_mix(key),std::move(value),inserted)->value.second;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+template <class... Args>
+T& HashMap<KEY,T,thash,HASH>::emplace(const KEY& key, Args&&... args) {
+    T value(std::forward<Args>(args)...);
+    bool inserted;
+    LN* p = find_or_insert(key,hash_mix(key),std::move(value),inserted);
+    if (!inserted)
+        p->value.second = std::move(value);
+    return p->value.second;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T HashMap<KEY,T,thash>::erase(const KEY& key) {
-    if(!has_key(key))
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T HashMap<KEY,T,thash,HASH>::erase(const KEY& key) {
+    if (old_map != nullptr)
+        migrate_bins(rehash_step);
+    LN*& link = find_link(hash_mix(key),key);
+    if (link->next == nullptr)
         throw KeyError("Key not in Map");
-    LN* prev=map[hash_compress(key)];
-    T to_return=find_key(map[hash_compress(key)], key)->value.second;
-    if(prev->value.first==key){
-        map[hash_compress(key)]=prev->next;
-        delete prev;
-    }
-    else {
-        for (LN *p = map[hash_compress(key)]->next; p->next != nullptr; p = p->next) {
-            if(p->value.first==key){
-                LN* to_delete=p;
-                prev->next=p->next;
-                delete to_delete;
-                break;
-            }
-            prev=prev->next;
-        }
-    }
+    LN* to_delete = link;
+    T to_return = to_delete->value.second;
+    link = to_delete->next;
+    delete to_delete;
     used--;
     ++mod_count;
     return to_return;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::clear() {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::clear() {
+    if (old_map != nullptr)
+        migrate_bins(old_bins);
+    delete_hash_table(map,bins);
     bins=1;
     map = new LN*[bins];
     map[0]=new LN;
     used=0;
     ++mod_count;
-    load_threshold=1;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::set_rehash_step(int bins_per_op) {
+    rehash_step = bins_per_op > 0 ? bins_per_op : 0;
+    if (rehash_step == 0 && old_map != nullptr)
+        migrate_bins(old_bins);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
 template<class Iterable>
-int HashMap<KEY,T,thash>::put_all(const Iterable& i) {
+int HashMap<KEY,T,thash,HASH>::put_all(const Iterable& i) {
     int count = 0;
     for (const Entry& m_entry : i) {
         ++count;
@@ -392,31 +497,32 @@ int HashMap<KEY,T,thash>::put_all(const Iterable& i) {
 //
 //Operators
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T& HashMap<KEY,T,thash>::operator [] (const KEY& key) {
-    T value;
-    if(!has_key(key)){
-        put(key, value);
-    }
-    return find_key(map[hash_compress(key)],key)->value.second;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T& HashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) {
+    bool inserted;
+    return find_or_insert(key,hash_mix(key),T(),inserted)->value.second;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-const T& HashMap<KEY,T,thash>::operator [] (const KEY& key) const {
-    return find_key(map[hash_compress(key)],key)->value.second;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+const T& HashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) const {
+    LN* p = find_link(hash_mix(key),key);
+    if (p->next == nullptr)
+        throw KeyError("Key not in Map");
+    return p->value.second;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>& HashMap<KEY,T,thash>::operator = (const HashMap<KEY,T,thash>& rhs) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>& HashMap<KEY,T,thash,HASH>::operator = (const HashMap<KEY,T,thash,HASH>& rhs) {
     if (this == &rhs)
         return *this;
     clear();
     hash = rhs.hash;
-    for(int i=0; i<rhs.bins; i++){
-        for(LN* p=rhs.map[i]; p->next!=nullptr; p=p->next){
-            put(p->value.first,p->value.second);
+    for(int i=0; i<rhs.bins+rhs.old_bins; i++){
+        for(LN* p=rhs.bin_at(i); p->next!=nullptr; p=p->next){
+            bool inserted;
+            find_or_insert(p->value.first,p->hashed,p->value.second,inserted);
         }
     }
     ++mod_count;
@@ -424,21 +530,36 @@ HashMap<KEY,T,thash>& HashMap<KEY,T,thash>::operator = (const HashMap<KEY,T,thas
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::operator == (const HashMap<KEY,T,thash>& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>& HashMap<KEY,T,thash,HASH>::operator = (HashMap<KEY,T,thash,HASH>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(hash,           rhs.hash);
+    std::swap(map,            rhs.map);
+    std::swap(load_threshold, rhs.load_threshold);
+    std::swap(bins,           rhs.bins);
+    std::swap(used,           rhs.used);
+    std::swap(old_map,        rhs.old_map);
+    std::swap(old_bins,       rhs.old_bins);
+    std::swap(migrated,       rhs.migrated);
+    std::swap(rehash_step,    rhs.rehash_step);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::operator == (const HashMap<KEY,T,thash,HASH>& rhs) const {
     if (this == &rhs)
         return true;
     if (used != rhs.size())
         return false;
 
-    for(int i=0; i<rhs.bins; i++){
-        for(LN* p=rhs.map[i]; p->next!=nullptr; p=p->next){
-            if(has_key(p->value.first)){
-                if(find_key(map[hash_compress(p->value.first)],p->value.first)->value.second!=p->value.second){
-                    return false;
-                }
-            }
-            else{
+    for(int i=0; i<rhs.bins+rhs.old_bins; i++){
+        for(LN* p=rhs.bin_at(i); p->next!=nullptr; p=p->next){
+            LN* q = find_link(hash == rhs.hash ? p->hashed : hash_mix(p->value.first),p->value.first);
+            if(q->next==nullptr || q->value.second!=p->value.second){
                 return false;
             }
         }
@@ -447,18 +568,18 @@ bool HashMap<KEY,T,thash>::operator == (const HashMap<KEY,T,thash>& rhs) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::operator != (const HashMap<KEY,T,thash>& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::operator != (const HashMap<KEY,T,thash,HASH>& rhs) const {
     return !(*this == rhs);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>& m) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash,HASH>& m) {
     outs << "map[";
     int count =0;
-    for (int i = 0; i < m.bins; ++i)
-        for (typename HashMap<KEY,T,thash>::LN* p = m.map[i]; p->next != nullptr; p = p->next){
+    for (int i = 0; i < m.bins+m.old_bins; ++i)
+        for (typename HashMap<KEY,T,thash,HASH>::LN* p = m.bin_at(i); p->next != nullptr; p = p->next){
             if (count++ == 0)
                 outs << "" ;
             else
@@ -475,15 +596,15 @@ std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>& m) {
 //
 //Iterator constructors
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::begin () const -> HashMap<KEY,T,thash>::Iterator {
-    return Iterator(const_cast<HashMap<KEY,T,thash>*>(this),true);
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto HashMap<KEY,T,thash,HASH>::begin () const -> HashMap<KEY,T,thash,HASH>::Iterator {
+    return Iterator(const_cast<HashMap<KEY,T,thash,HASH>*>(this),true);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
-    return Iterator(const_cast<HashMap<KEY,T,thash>*>(this),false);
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto HashMap<KEY,T,thash,HASH>::end () const -> HashMap<KEY,T,thash,HASH>::Iterator {
+    return Iterator(const_cast<HashMap<KEY,T,thash,HASH>*>(this),false);
 }
 
 
@@ -491,14 +612,90 @@ auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
 //
 //Private helper methods
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-int HashMap<KEY,T,thash>::hash_compress (const KEY& key) const {
-    return std::abs(thash(key))%bins;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::hashfunc HashMap<KEY,T,thash,HASH>::template_hash () {
+    return !std::is_same<HASH,undefinedfunctor>::value ? functor_hash : thash;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::functor_hash (const KEY& a) {
+    return (int)HASH()(a);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::hash_of (const KEY& a) const {
+    if (!std::is_same<HASH,undefinedfunctor>::value)
+        return (int)HASH()(a);
+    if (thash != (hashfunc)undefinedhash<KEY>)
+        return thash(a);
+    return hash(a);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::hash_compress (const KEY& key) const {
+    return compress(hash_mix(key),bins);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::hash_mix (const KEY& key) const {
+    //murmur3's 32-bit finalizer: a bijection, so cached/compared values stay exact
+    unsigned int h = (unsigned int)hash_of(key);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return (int)h;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::compress (int hashed, int n) const {
+    return hashed & (n-1);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::power_of_two (int n) {
+    int p = 1;
+    while (p < n)
+        p *= 2;
+    return p;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN*& HashMap<KEY,T,thash,HASH>::bin_front (int hashed) const {
+    if (old_map != nullptr) {
+        int old_bin = compress(hashed,old_bins);
+        if (old_bin >= migrated)
+            return old_map[old_bin];
+    }
+    return map[compress(hashed,bins)];
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::bin_at (int i) const {
+    if (i < bins)
+        return old_map == nullptr || i%old_bins < migrated ? map[i] : empty_bin();
+    return i-bins >= migrated ? old_map[i-bins] : empty_bin();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::empty_bin () {
+    static LN trailer;
+    return &trailer;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::find_key (LN* front, const KEY& key) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::find_key (LN* front, const KEY& key) const {
     if (front->next==nullptr){
         return front->next;
     }
@@ -509,42 +706,107 @@ typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::find_key (LN* front, co
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::copy_list (LN* l) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN*& HashMap<KEY,T,thash,HASH>::find_link (int hashed, const KEY& key) const {
+    LN** link = &bin_front(hashed);
+    while ((*link)->next != nullptr && !((*link)->hashed == hashed && (*link)->value.first == key))
+        link = &(*link)->next;
+    return *link;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+template <class V>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::find_or_insert (const KEY& key, int hashed, V&& value, bool& inserted) {
+    //Callers hash once: if the table grows, the same hash value is recompressed
+    LN*& link  = find_link(hashed,key);
+    inserted = link->next == nullptr;
+    if (!inserted)
+        return link;
+
+    //Only insertions (and erasures) advance a pending resize: finding a present key
+    //  must not move nodes under a live Iterator
+    if (old_map != nullptr)
+        migrate_bins(rehash_step);
+    used++;
+    ensure_load_threshold(used);
+    LN*& front = bin_front(hashed);
+    front = new LN(key,std::forward<V>(value),hashed,front);
+    ++mod_count;
+    return front;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::copy_list (LN* l) const {
     if (l == nullptr)
         return nullptr;
     else
-        return new LN(l->value, copy_list(l->next));
+        return new LN(l->value, l->hashed, copy_list(l->next));
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN** HashMap<KEY,T,thash>::copy_hash_table (LN** ht, int bins) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN** HashMap<KEY,T,thash,HASH>::copy_hash_table (LN** ht, int bins) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::ensure_load_threshold(int new_used) {
-    if(new_used/bins > load_threshold){
-        int old_bins = bins;
-        bins = 2*bins;
-        LN** new_map = new LN*[bins];
-        for(int i=0; i<bins; i++ ){
-            new_map[i] = new LN;
-        }
-        for(int i=0; i< old_bins; i++){
-            for(LN* p=map[i]; p->next!= nullptr; p=p->next){
-                int index = std::abs(thash(p->value.first))%bins;
-                new_map[index]=new LN(p->value, new_map[index]);
-            }
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::ensure_load_threshold(int new_used) {
+    if ((double)new_used/bins <= load_threshold)
+        return;
+
+    //Still draining the previous resize (rehash_step too small to keep up): finish it first
+    if (old_map != nullptr)
+        migrate_bins(old_bins);
+
+    //map's bins get their trailers as the old bins feeding them are migrated
+    old_map  = map;
+    old_bins = bins;
+    migrated = 0;
+    bins     = 2*bins;
+    map      = new LN*[bins];
+    migrate_bins(rehash_step == 0 ? old_bins : rehash_step);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::migrate_bins(int n) {
+    //Relink (not copy) each node into map bin migrated or migrated+old_bins; then drop the old trailer
+    for (; n > 0 && migrated < old_bins; --n, ++migrated) {
+        map[migrated]          = new LN();
+        map[migrated+old_bins] = new LN();
+        LN* p = old_map[migrated];
+        while (p->next != nullptr) {
+            LN* to_move = p;
+            p = p->next;
+            LN*& front = map[compress(to_move->hashed,bins)];
+            to_move->next = front;
+            front = to_move;
         }
-        map = new_map;
+        delete p;
+    }
+    ++mod_count;
+
+    if (migrated == old_bins) {
+        delete [] old_map;
+        old_map  = nullptr;
+        old_bins = 0;
+        migrated = 0;
     }
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::delete_hash_table (LN**& ht, int bins) {
+    for (int i = 0; i < bins; ++i)
+        for (LN* p = ht[i]; p != nullptr; ) {
+            LN* to_delete = p;
+            p = p->next;
+            delete to_delete;
+        }
+    delete [] ht;
+    ht = nullptr;
 }
 
 
@@ -556,8 +818,8 @@ void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
 //
 //Iterator class definitions
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::Iterator::advance_cursors(){
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::Iterator::advance_cursors(){
     //not trailer node and contains at least one element
     if (current.second != nullptr && current.second->next != nullptr && current.second->next->next != nullptr) {
         current.second = current.second->next;
@@ -565,10 +827,10 @@ void HashMap<KEY,T,thash>::Iterator::advance_cursors(){
     }
         //it's trailer node so we move to other bins higher than first one
     else
-        for (int i = current.first + 1; i < ref_map->bins; ++i)
-            if (ref_map->map[i]->next != nullptr) {
+        for (int i = current.first + 1; i < ref_map->bins+ref_map->old_bins; ++i)
+            if (ref_map->bin_at(i)->next != nullptr) {
                 current.first = i;
-                current.second = ref_map->map[i];
+                current.second = ref_map->bin_at(i);
                 return;
             }
         //ran out of bins to check so we set (bin = -1,LN* ptr =  nullptr)
@@ -578,8 +840,8 @@ void HashMap<KEY,T,thash>::Iterator::advance_cursors(){
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::Iterator::Iterator(HashMap<KEY,T,thash>* iterate_over, bool from_begin)
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::Iterator::Iterator(HashMap<KEY,T,thash,HASH>* iterate_over, bool from_begin)
 : ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
     current = Cursor(-1, nullptr);
     if (from_begin)
@@ -588,13 +850,13 @@ HashMap<KEY,T,thash>::Iterator::Iterator(HashMap<KEY,T,thash>* iterate_over, boo
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::Iterator::~Iterator()
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::Iterator::~Iterator()
 {}
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::Iterator::erase() -> Entry {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto HashMap<KEY,T,thash,HASH>::Iterator::erase() -> Entry {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::erase");
     if (!can_erase)
@@ -617,13 +879,13 @@ auto HashMap<KEY,T,thash>::Iterator::erase() -> Entry {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::string HashMap<KEY,T,thash>::Iterator::str() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string HashMap<KEY,T,thash,HASH>::Iterator::str() const {
 
 }
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto  HashMap<KEY,T,thash>::Iterator::operator ++ () -> HashMap<KEY,T,thash>::Iterator& {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto  HashMap<KEY,T,thash,HASH>::Iterator::operator ++ () -> HashMap<KEY,T,thash,HASH>::Iterator& {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator ++");
 
@@ -639,8 +901,8 @@ auto  HashMap<KEY,T,thash>::Iterator::operator ++ () -> HashMap<KEY,T,thash>::It
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto  HashMap<KEY,T,thash>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash>::Iterator {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto  HashMap<KEY,T,thash,HASH>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash,HASH>::Iterator {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator ++(int)");
 
@@ -658,8 +920,8 @@ auto  HashMap<KEY,T,thash>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash>:
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::Iterator::operator == (const HashMap<KEY,T,thash>::Iterator& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::Iterator::operator == (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
     if (rhsASI == 0)
         throw IteratorTypeError("HashMap::Iterator::operator ==");
@@ -672,8 +934,8 @@ bool HashMap<KEY,T,thash>::Iterator::operator == (const HashMap<KEY,T,thash>::It
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::Iterator::operator != (const HashMap<KEY,T,thash>::Iterator& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::Iterator::operator != (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
     if (rhsASI == 0)
         throw IteratorTypeError("HashMap::Iterator::operator !=");
@@ -686,8 +948,8 @@ bool HashMap<KEY,T,thash>::Iterator::operator != (const HashMap<KEY,T,thash>::It
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-pair<KEY,T>& HashMap<KEY,T,thash>::Iterator::operator *() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+pair<KEY,T>& HashMap<KEY,T,thash,HASH>::Iterator::operator *() const {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator *");
     if (!can_erase || current.second == nullptr)
@@ -697,8 +959,8 @@ pair<KEY,T>& HashMap<KEY,T,thash>::Iterator::operator *() const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-pair<KEY,T>* HashMap<KEY,T,thash>::Iterator::operator ->() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+pair<KEY,T>* HashMap<KEY,T,thash,HASH>::Iterator::operator ->() const {
     if (expected_mod_count != ref_map->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator ->");
     if (!can_erase || current.second == nullptr)
@@ -11,7 +11,10 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
 #include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
 #include "pair.hpp"
 
 
@@ -24,12 +27,26 @@ template<class T>
 int undefinedhash (const T& a) {return 0;}
 #endif /* undefinedhashdefined */
 
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
 //Instantiate the templated class supplying thash(a): produces a hash value for a.
 //If thash is defaulted to undefinedhash in the template, then a constructor must supply chash.
 //If both thash and chash are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-undefinedhash value supplied by thash/chash is stored in the instance variable hash.
-template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
+//Alternatively, leave thash defaulted and supply a stateless functor type HASH (e.g., std::hash<T>, or a
+//  lambda's type in C++20): HASH()(...) is then called directly, so it can be inlined (as is a
+//  thash template argument); only a chash supplied at run time is called through the pointer hash.
+//Supplying both thash and HASH is a compile-time error.
+template<class T, int (*thash)(const T& a) = undefinedhash<T>, class HASH = undefinedfunctor> class HashSet {
   public:
     typedef int (*hashfunc) (const T& a);
 
@@ -38,7 +55,8 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
 
     HashSet (double the_load_threshold = 1.0, int (*chash)(const T& a) = undefinedhash<T>);
     explicit HashSet (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const T& k) = undefinedhash<T>);
-    HashSet (const HashSet<T,thash>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = undefinedhash<T>);
+    HashSet (const HashSet<T,thash,HASH>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = undefinedhash<T>);
+    HashSet (HashSet<T,thash,HASH>&& to_move);   //O(1): takes to_move's table, leaving it empty
     explicit HashSet (const std::initializer_list<T>& il, double the_load_threshold = 1.0, int (*chash)(const T& a) = undefinedhash<T>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -59,9 +77,14 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
 
     //Commands
     int  insert (const T& element);
+    int  insert (T&& element);
     int  erase  (const T& element);
     void clear  ();
 
+    //Inserts T(args...), constructed directly in its list node (which is discarded if already contained)
+    template <class... Args>
+    int emplace (Args&&... args);
+
     //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
 
     template <class Iterable>
@@ -75,16 +98,17 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
 
 
     //Operators
-    HashSet<T,thash>& operator = (const HashSet<T,thash>& rhs);
-    bool operator == (const HashSet<T,thash>& rhs) const;
-    bool operator != (const HashSet<T,thash>& rhs) const;
-    bool operator <= (const HashSet<T,thash>& rhs) const;
-    bool operator <  (const HashSet<T,thash>& rhs) const;
-    bool operator >= (const HashSet<T,thash>& rhs) const;
-    bool operator >  (const HashSet<T,thash>& rhs) const;
+    HashSet<T,thash,HASH>& operator = (const HashSet<T,thash,HASH>& rhs);
+    HashSet<T,thash,HASH>& operator = (HashSet<T,thash,HASH>&& rhs);   //O(1): swaps tables with rhs
+    bool operator == (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator != (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator <= (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator <  (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator >= (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator >  (const HashSet<T,thash,HASH>& rhs) const;
 
-    template<class T2, int (*hash2)(const T2& a)>
-    friend std::ostream& operator << (std::ostream& outs, const HashSet<T2,hash2>& s);
+    template<class T2, int (*hash2)(const T2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const HashSet<T2,hash2,HASH2>& s);
 
 
 
@@ -96,27 +120,27 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
       public:
         typedef pair<int,LN*> Cursor;
 
-        //Private constructor called in begin/end, which are friends of HashSet<T,thash>
+        //Private constructor called in begin/end, which are friends of HashSet<T,thash,HASH>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HashSet<T,thash>::Iterator& operator ++ ();
-        HashSet<T,thash>::Iterator  operator ++ (int);
-        bool operator == (const HashSet<T,thash>::Iterator& rhs) const;
-        bool operator != (const HashSet<T,thash>::Iterator& rhs) const;
+        HashSet<T,thash,HASH>::Iterator& operator ++ ();
+        HashSet<T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const HashSet<T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const HashSet<T,thash,HASH>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HashSet<T,thash,HASH>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator HashSet<T,thash>::begin () const;
-        friend Iterator HashSet<T,thash>::end   () const;
+        friend Iterator HashSet<T,thash,HASH>::begin () const;
+        friend Iterator HashSet<T,thash,HASH>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
         Cursor              current; //Bin Index and Cursor; stops if LN* == nullptr
-        HashSet<T,thash>*   ref_set;
+        HashSet<T,thash,HASH>*   ref_set;
         int                 expected_mod_count;
         bool                can_erase = true;
 
@@ -124,7 +148,7 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
         void advance_cursors();
 
         //Called in friends begin/end
-        Iterator(HashSet<T,thash>* iterate_over, bool from_begin);
+        Iterator(HashSet<T,thash,HASH>* iterate_over, bool from_begin);
     };
 
 
@@ -136,10 +160,16 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
     class LN {
       public:
         LN ()                      {}
-        LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        LN (const LN& ln)          : value(ln.value), hashed(ln.hashed), next(ln.next){}
+        LN (const T& v, int h, LN* n = nullptr) : value(v), hashed(h), next(n){}
+        LN (T&& v,      int h, LN* n = nullptr) : value(std::move(v)), hashed(h), next(n){}
+        template <class... Args>
+        explicit LN (LN* n, Args&&... args) : value(std::forward<Args>(args)...), next(n){}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(LN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(LN)>::deallocate(p);}
 
         T   value;
+        int hashed = 0;        //Cached hash_mix(value): rehashing never calls hash, and chain walks compare it first
         LN* next   = nullptr;
     };
 
@@ -148,18 +178,29 @@ public:
 private:
   LN** set      = nullptr;   //Pointer to array of pointers: each bin stores a list with a trailer node
   double load_threshold;     //used/bins <= load_threshold
-  int bins      = 1;         //# bins in array (should start >= 1 so hash_compress doesn't % 0)
+  int bins      = 1;         //# bins in array (always a power of 2, so compress masks instead of %)
   int used      = 0;         //Cache for number of key->value pairs in the hash table
   int mod_count = 0;         //For sensing concurrent modification
 
+  static_assert(std::is_same<HASH,undefinedfunctor>::value || thash == (hashfunc)undefinedhash<T>,
+                "HashSet: supply thash or HASH, not both");
+  static hashfunc template_hash ();                      //functor_hash if HASH is supplied, else thash (undefinedhash if neither)
+  static int functor_hash  (const T& a);
+  int hash_of (const T& a) const;   //hash(a), called directly when thash/HASH fixes it at compile time
+
 
   //Helper methods
   int   hash_compress        (const T& key)              const;  //hash function ranged to [0,bins-1]
+  int   hash_mix             (const T& element)          const;  //hash function with its bits mixed (so masking keeps them all)
+  int   compress             (int hashed)                const;  //already-mixed hash ranged to [0,bins-1] (bins a power of 2)
+  static int power_of_two    (int n);                            //Smallest power of 2 >= n (and >= 1)
   LN*   find_element         (const T& element)          const;  //Returns reference to element's node or nullptr
+  LN*&  find_link            (int hashed, const T& element) const; //Returns reference to the pointer to element's node (or to its bin's trailer)
   LN*   copy_list            (LN*   l)                   const;  //Copy the elements in a bin (order irrelevant)
   LN**  copy_hash_table      (LN** ht, int bins)         const;  //Copy the bins/keys/values in ht tree (order in bins irrelevant)
 
-  void  ensure_load_threshold(int new_used);                     //Reallocate if load_threshold > load_threshold
+  void  ensure_load_threshold(int new_used);                     //Reallocate (relinking nodes) if used/bins > load_threshold
+  int   add_node             (LN* to_add);                       //Link in to_add (not already contained; hashed set), growing if needed
   void  delete_hash_table    (LN**& ht, int bins);               //Deallocate all LN in ht (and the ht itself; ht == nullptr)
 };
 
@@ -173,50 +214,50 @@ private:
 //
 //Destructor/Constructors
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::~HashSet() {
-    delete [] set;
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::~HashSet() {
+    delete_hash_table(set,bins);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(double the_load_threshold, int (*chash)(const T& element))
-:hash(thash != (hashfunc)undefinedhash<T> ? thash : chash)
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(double the_load_threshold, int (*chash)(const T& element))
+:hash(template_hash() != (hashfunc)undefinedhash<T> ? template_hash() : chash)
 {
     if (hash == (hashfunc)undefinedhash<T>)
         throw TemplateFunctionError("HashSet::default constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && template_hash() != chash)
         throw TemplateFunctionError("HashSet::default constructor: both specified and different");
     set = new LN*[bins];
     set[0]=new LN;
-    load_threshold=1;
+    load_threshold = the_load_threshold;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element))
-: hash(thash != (hashfunc)undefinedhash<T> ? thash : chash), bins(initial_bins)
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element))
+: hash(template_hash() != (hashfunc)undefinedhash<T> ? template_hash() : chash), bins(power_of_two(initial_bins))
 {
     if (hash == (hashfunc)undefinedhash<T>)
         throw TemplateFunctionError("HashSet::length constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && template_hash() != chash)
         throw TemplateFunctionError("HashSet::length constructor: both specified and different");
 
-    bins = initial_bins;
     set = new LN*[bins];
     for(int i=0; i<bins; i++ ){
         set[i] = new LN;
     }
+    load_threshold = the_load_threshold;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(const HashSet<T,thash>& to_copy, double the_load_threshold, int (*chash)(const T& element))
-: hash(to_copy.hash), used(to_copy.used), bins(to_copy.bins)
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(const HashSet<T,thash,HASH>& to_copy, double the_load_threshold, int (*chash)(const T& element))
+: hash(to_copy.hash), load_threshold(to_copy.load_threshold), bins(to_copy.bins)
 {
     if (hash == (hashfunc)undefinedhash<T>)
         hash = to_copy.hash;
-    if (thash != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && template_hash() != chash)
         throw TemplateFunctionError("HashSet::copy constructor: both specified and different");
 
     set = new LN*[bins];
@@ -226,7 +267,6 @@ HashSet<T,thash>::HashSet(const HashSet<T,thash>& to_copy, double the_load_thres
             set[i] = copy_list(to_copy.set[i]);
     }
     else {
-        set = new LN*[bins];
         for (int i = 0; i < bins; ++i)
             set[i] = new LN();
         for (int i = 0; i < to_copy.bins; ++i)
@@ -237,37 +277,51 @@ HashSet<T,thash>::HashSet(const HashSet<T,thash>& to_copy, double the_load_thres
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element))
-: hash(thash != (hashfunc)undefinedhash<T> ? thash : chash), bins(il.size())
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(HashSet<T,thash,HASH>&& to_move)
+: hash(to_move.hash), set(to_move.set), load_threshold(to_move.load_threshold), bins(to_move.bins), used(to_move.used)
+{
+    to_move.bins = 1;
+    to_move.set  = new LN*[1];
+    to_move.set[0] = new LN();
+    to_move.used = 0;
+    ++to_move.mod_count;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element))
+: hash(template_hash() != (hashfunc)undefinedhash<T> ? template_hash() : chash), bins(power_of_two(il.size()))
 {
     if (hash == (hashfunc)undefinedhash<T>)
         throw TemplateFunctionError("HashSet::initializer_list constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && template_hash() != chash)
         throw TemplateFunctionError("HashSet::initializer_list constructor: both specified and different");
 
     set = new LN*[bins];
     for (int i = 0; i<bins; ++i)
         set[i] = new LN();
+    load_threshold = the_load_threshold;
 
     for (const T& entry : il)
         insert(entry);
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-HashSet<T,thash>::HashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a))
-: hash(thash != (hashfunc)undefinedhash<T> ? thash : chash), bins(i.size())
+HashSet<T,thash,HASH>::HashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a))
+: hash(template_hash() != (hashfunc)undefinedhash<T> ? template_hash() : chash), bins(power_of_two(i.size()))
 {
     if (hash == (hashfunc)undefinedhash<T>)
         throw TemplateFunctionError("HashSet::Iterable constructor: neither specified");
-    if (thash != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && thash != chash)
+    if (template_hash() != (hashfunc)undefinedhash<T> && chash != (hashfunc)undefinedhash<T> && template_hash() != chash)
         throw TemplateFunctionError("HashSet::Iterable constructor: both specified and different");
 
     set = new LN*[bins];
     for (int i = 0; i<bins; ++i)
         set[i] = new LN();
+    load_threshold = the_load_threshold;
 
     for (const T& entry : i)
         insert(entry);
@@ -278,33 +332,26 @@ HashSet<T,thash>::HashSet(const Iterable& i, double the_load_threshold, int (*ch
 //
 //Queries
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::empty() const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::empty() const {
     return used==0;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::size() const {
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::size() const {
     return used;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::contains (const T& element) const {
-    for(int i=0; i<bins; i++) {
-        for (LN *p = set[i]; p->next != nullptr; p = p->next) {
-            if (p->value == element) {
-                return true;
-            }
-        }
-    }
-    return false;
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::contains (const T& element) const {
+    return find_element(element) != nullptr;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::string HashSet<T,thash>::str() const {
+template<class T, int (*thash)(const T& a), class HASH>
+std::string HashSet<T,thash,HASH>::str() const {
     std::stringstream temp;
     for(int i=0; i<bins; i++){
         temp << " " << i << " : [";
@@ -318,9 +365,9 @@ std::string HashSet<T,thash>::str() const {
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template <class Iterable>
-bool HashSet<T,thash>::contains_all(const Iterable& i) const {
+bool HashSet<T,thash,HASH>::contains_all(const Iterable& i) const {
     for(T& p:i){
         if(!contains(p))
             return false;
@@ -333,61 +380,69 @@ bool HashSet<T,thash>::contains_all(const Iterable& i) const {
 //
 //Commands
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::insert(const T& element) {
-    //std::cout << "before : " << str() << std::endl;
-    if(contains(element)){
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::insert(const T& element) {
+    //Hash once: if the table grows, the same hash value is recompressed
+    int hashed = hash_mix(element);
+    if(find_link(hashed,element)->next != nullptr){
         return 0;
     }
-    used++;
-    ensure_load_threshold(used);
-    set[hash_compress(element)]=new LN(element,set[hash_compress(element)]);
-    //std::cout << "after : " << str() << std::endl;
-    mod_count++;
-    return 1;
+    return add_node(new LN(element,hashed));
 }
 
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::erase(const T& element) {
-    if(!contains(element))
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::insert(T&& element) {
+    int hashed = hash_mix(element);
+    if(find_link(hashed,element)->next != nullptr){
         return 0;
-    LN* prev=set[hash_compress(element)];
-    if(prev->value==element){
-        set[hash_compress(element)]=prev->next;
-        delete prev;
     }
-    else {
-        for (LN *p = set[hash_compress(element)]->next; p->next != nullptr; p = p->next) {
-            if(p->value==element){
-                LN* to_delete=p;
-                prev->next=p->next;
-                delete to_delete;
-                break;
-            }
-            prev=prev->next;
-        }
+    return add_node(new LN(std::move(element),hashed));
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+template<class... Args>
+int HashSet<T,thash,HASH>::emplace(Args&&... args) {
+    //The value must exist before it can be hashed or compared, so build its node first
+    LN* to_add = new LN(nullptr, std::forward<Args>(args)...);
+    to_add->hashed = hash_mix(to_add->value);
+    if(find_link(to_add->hashed,to_add->value)->next != nullptr){
+        delete to_add;
+        return 0;
     }
+    return add_node(to_add);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::erase(const T& element) {
+    LN*& link = find_link(hash_mix(element),element);
+    if(link->next == nullptr)
+        return 0;
+    LN* to_delete = link;
+    link = to_delete->next;
+    delete to_delete;
     used --;
     mod_count++;
     return 1;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::clear() {
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::clear() {
+    delete_hash_table(set,bins);
     bins=1;
     set = new LN*[bins];
     set[0]=new LN;
     used=0;
     mod_count++;
-    load_threshold=1;
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-int HashSet<T,thash>::insert_all(const Iterable& i) {
+int HashSet<T,thash,HASH>::insert_all(const Iterable& i) {
     int count=0;
     for(T& p:i){
         count+=insert(p);
@@ -396,9 +451,9 @@ int HashSet<T,thash>::insert_all(const Iterable& i) {
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-int HashSet<T,thash>::erase_all(const Iterable& i) {
+int HashSet<T,thash,HASH>::erase_all(const Iterable& i) {
     int count=0;
     for(T& p:i){
         count+=erase(p);
@@ -407,11 +462,11 @@ int HashSet<T,thash>::erase_all(const Iterable& i) {
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-int HashSet<T,thash>::retain_all(const Iterable& i) {
-    HashSet<T,thash> temp1(i);
-    HashSet<T,thash> temp2;
+int HashSet<T,thash,HASH>::retain_all(const Iterable& i) {
+    HashSet<T,thash,HASH> temp1(i);
+    HashSet<T,thash,HASH> temp2;
     for(T& p: *this){
         if(temp1.contains(p)){
             temp2.insert(p);
@@ -427,8 +482,8 @@ int HashSet<T,thash>::retain_all(const Iterable& i) {
 //
 //Operators
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>& HashSet<T,thash>::operator = (const HashSet<T,thash>& rhs) {
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>& HashSet<T,thash,HASH>::operator = (const HashSet<T,thash,HASH>& rhs) {
     if (this == &rhs)
         return *this;
     clear();
@@ -442,8 +497,23 @@ HashSet<T,thash>& HashSet<T,thash>::operator = (const HashSet<T,thash>& rhs) {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator == (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>& HashSet<T,thash,HASH>::operator = (HashSet<T,thash,HASH>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(hash,           rhs.hash);
+    std::swap(set,            rhs.set);
+    std::swap(load_threshold, rhs.load_threshold);
+    std::swap(bins,           rhs.bins);
+    std::swap(used,           rhs.used);
+    mod_count++;
+    rhs.mod_count++;
+    return *this;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator == (const HashSet<T,thash,HASH>& rhs) const {
     if (this == &rhs)
         return true;
     if (used != rhs.size())
@@ -460,41 +530,41 @@ bool HashSet<T,thash>::operator == (const HashSet<T,thash>& rhs) const {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator != (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator != (const HashSet<T,thash,HASH>& rhs) const {
     return !(*this == rhs);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator <= (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator <= (const HashSet<T,thash,HASH>& rhs) const {
     return used < rhs.used || used == rhs.used;
 }
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator < (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator < (const HashSet<T,thash,HASH>& rhs) const {
     return used < rhs.used;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator >= (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator >= (const HashSet<T,thash,HASH>& rhs) const {
     return used > rhs.used || used == rhs.used;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator > (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator > (const HashSet<T,thash,HASH>& rhs) const {
     return used > rhs.used;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>& s) {
+template<class T, int (*thash)(const T& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const HashSet<T,thash,HASH>& s) {
     outs << "set[";
     int count =0;
     for (int i = 0; i < s.bins; ++i)
-        for (typename HashSet<T,thash>::LN* p = s.set[i]; p->next != nullptr; p = p->next){
+        for (typename HashSet<T,thash,HASH>::LN* p = s.set[i]; p->next != nullptr; p = p->next){
             if (count++ == 0)
                 outs << "" ;
             else
@@ -511,17 +581,17 @@ std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>& s) {
 //
 //Iterator constructors
 
-template<class T, int (*thash)(const T& a)>
-auto HashSet<T,thash>::begin () const -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class HASH>
+auto HashSet<T,thash,HASH>::begin () const -> HashSet<T,thash,HASH>::Iterator {
     //std::cout << "begin" << std::endl;
-    return Iterator(const_cast<HashSet<T,thash>*>(this),true);
+    return Iterator(const_cast<HashSet<T,thash,HASH>*>(this),true);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class HASH>
+auto HashSet<T,thash,HASH>::end () const -> HashSet<T,thash,HASH>::Iterator {
    // std::cout << "end" << std::endl;
-    return Iterator(const_cast<HashSet<T,thash>*>(this),false);
+    return Iterator(const_cast<HashSet<T,thash,HASH>*>(this),false);
 }
 
 
@@ -529,51 +599,140 @@ auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
 //
 //Private helper methods
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::hash_compress (const T& element) const {
-    return std::abs(thash(element))%bins;
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::hashfunc HashSet<T,thash,HASH>::template_hash () {
+    return !std::is_same<HASH,undefinedfunctor>::value ? functor_hash : thash;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::functor_hash (const T& a) {
+    return (int)HASH()(a);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::hash_of (const T& a) const {
+    if (!std::is_same<HASH,undefinedfunctor>::value)
+        return (int)HASH()(a);
+    if (thash != (hashfunc)undefinedhash<T>)
+        return thash(a);
+    return hash(a);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN* HashSet<T,thash>::find_element (const T& element) const {
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::hash_compress (const T& element) const {
+    return compress(hash_mix(element));
 }
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN* HashSet<T,thash>::copy_list (LN* l) const {
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::hash_mix (const T& element) const {
+    //murmur3's 32-bit finalizer: a bijection, so cached/compared values stay exact
+    unsigned int h = (unsigned int)hash_of(element);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return (int)h;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::compress (int hashed) const {
+    return hashed & (bins-1);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::power_of_two (int n) {
+    int p = 1;
+    while (p < n)
+        p *= 2;
+    return p;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN* HashSet<T,thash,HASH>::find_element (const T& element) const {
+    LN* p = find_link(hash_mix(element),element);
+    return p->next != nullptr ? p : nullptr;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN*& HashSet<T,thash,HASH>::find_link (int hashed, const T& element) const {
+    LN** link = &set[compress(hashed)];
+    while ((*link)->next != nullptr && !((*link)->hashed == hashed && (*link)->value == element))
+        link = &(*link)->next;
+    return *link;
+}
+
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN* HashSet<T,thash,HASH>::copy_list (LN* l) const {
     if (l == nullptr)
         return nullptr;
     else
-        return new LN(l->value, copy_list(l->next));
+        return new LN(l->value, l->hashed, copy_list(l->next));
 }
 
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN** HashSet<T,thash>::copy_hash_table (LN** ht, int bins) const {
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN** HashSet<T,thash,HASH>::copy_hash_table (LN** ht, int bins) const {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::ensure_load_threshold(int new_used) {
-    if(new_used/bins > load_threshold){
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::ensure_load_threshold(int new_used) {
+    if((double)new_used/bins > load_threshold){
         int old_bins = bins;
         bins = 2*bins;
         LN** new_set = new LN*[bins];
         for(int i=0; i<bins; i++ ){
             new_set[i] = new LN;
         }
+        //Relink (not copy) each node, then free the old trailers and array
         for(int i=0; i< old_bins; i++){
-            for(LN* p=set[i]; p->next!= nullptr; p=p->next){
-                new_set[hash_compress(p->value)]=new LN(p->value, new_set[hash_compress(p->value)]);
+            LN* p=set[i];
+            while(p->next!= nullptr){
+                LN* to_move=p;
+                p=p->next;
+                int bin=compress(to_move->hashed);
+                to_move->next=new_set[bin];
+                new_set[bin]=to_move;
             }
+            delete p;
         }
+        delete [] set;
         set=new_set;
     }
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::delete_hash_table (LN**& ht, int bins) {
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::add_node(LN* to_add) {
+    used++;
+    ensure_load_threshold(used);
+    int bin = compress(to_add->hashed);
+    to_add->next = set[bin];
+    set[bin] = to_add;
+    mod_count++;
+    return 1;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::delete_hash_table (LN**& ht, int bins) {
+    for (int i = 0; i < bins; ++i)
+        for (LN* p = ht[i]; p != nullptr; ) {
+            LN* to_delete = p;
+            p = p->next;
+            delete to_delete;
+        }
+    delete [] ht;
+    ht = nullptr;
 }
 
 
@@ -585,8 +744,8 @@ void HashSet<T,thash>::delete_hash_table (LN**& ht, int bins) {
 //
 //Iterator class definitions
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::Iterator::advance_cursors() {
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::Iterator::advance_cursors() {
    // std::cout << "advance cursors" << std::endl;
     if (current.second != nullptr && current.second->next != nullptr && current.second->next->next != nullptr) {
         current.second = current.second->next;
@@ -606,8 +765,8 @@ void HashSet<T,thash>::Iterator::advance_cursors() {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::Iterator::Iterator(HashSet<T,thash>* iterate_over, bool begin)
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::Iterator::Iterator(HashSet<T,thash,HASH>* iterate_over, bool begin)
         : ref_set(iterate_over), expected_mod_count(ref_set->mod_count) {
     //std::cout << "iterate_over" << std::endl;
     current = Cursor(-1, nullptr);
@@ -616,13 +775,13 @@ HashSet<T,thash>::Iterator::Iterator(HashSet<T,thash>* iterate_over, bool begin)
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::Iterator::~Iterator()
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::Iterator::~Iterator()
 {}
 
 
-template<class T, int (*thash)(const T& a)>
-T HashSet<T,thash>::Iterator::erase() {
+template<class T, int (*thash)(const T& a), class HASH>
+T HashSet<T,thash,HASH>::Iterator::erase() {
    // std::cout << "erase" << std::endl;
     if (expected_mod_count != ref_set->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::erase");
@@ -646,14 +805,14 @@ T HashSet<T,thash>::Iterator::erase() {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::string HashSet<T,thash>::Iterator::str() const {
+template<class T, int (*thash)(const T& a), class HASH>
+std::string HashSet<T,thash,HASH>::Iterator::str() const {
     //std::cout << "str" << std::endl;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto  HashSet<T,thash>::Iterator::operator ++ () -> HashSet<T,thash>::Iterator& {
+template<class T, int (*thash)(const T& a), class HASH>
+auto  HashSet<T,thash,HASH>::Iterator::operator ++ () -> HashSet<T,thash,HASH>::Iterator& {
     //std::cout << "++()" << std::endl;
     if (expected_mod_count != ref_set->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator ++");
@@ -670,8 +829,8 @@ auto  HashSet<T,thash>::Iterator::operator ++ () -> HashSet<T,thash>::Iterator&
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto  HashSet<T,thash>::Iterator::operator ++ (int) -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class HASH>
+auto  HashSet<T,thash,HASH>::Iterator::operator ++ (int) -> HashSet<T,thash,HASH>::Iterator {
     //std::cout << "++(int)" << std::endl;
     if (expected_mod_count != ref_set->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator ++(int)");
@@ -690,8 +849,8 @@ auto  HashSet<T,thash>::Iterator::operator ++ (int) -> HashSet<T,thash>::Iterato
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::Iterator::operator == (const HashSet<T,thash>::Iterator& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::Iterator::operator == (const HashSet<T,thash,HASH>::Iterator& rhs) const {
    // std::cout << "==" << std::endl;
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
     if (rhsASI == 0)
@@ -705,8 +864,8 @@ bool HashSet<T,thash>::Iterator::operator == (const HashSet<T,thash>::Iterator&
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::Iterator::operator != (const HashSet<T,thash>::Iterator& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::Iterator::operator != (const HashSet<T,thash,HASH>::Iterator& rhs) const {
    // std::cout << "!=" << std::endl;
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
     if (rhsASI == 0)
@@ -719,8 +878,8 @@ bool HashSet<T,thash>::Iterator::operator != (const HashSet<T,thash>::Iterator&
     return current.second != rhsASI->current.second;
 }
 
-template<class T, int (*thash)(const T& a)>
-T& HashSet<T,thash>::Iterator::operator *() const {
+template<class T, int (*thash)(const T& a), class HASH>
+T& HashSet<T,thash,HASH>::Iterator::operator *() const {
    // std::cout << "*()" << std::endl;
     if (expected_mod_count != ref_set->mod_count)
         throw ConcurrentModificationError("HashMap::Iterator::operator *");
@@ -730,8 +889,8 @@ T& HashSet<T,thash>::Iterator::operator *() const {
     return current.second->value;
 }
 
-template<class T, int (*thash)(const T& a)>
-T* HashSet<T,thash>::Iterator::operator ->() const {
+template<class T, int (*thash)(const T& a), class HASH>
+T* HashSet<T,thash,HASH>::Iterator::operator ->() const {
     std::cout << "()" << std::endl;
 }
 
@@ -11,8 +11,11 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <algorithm>            //std::max, std::min, std::sort
 #include "ics_exceptions.hpp"
-#include <utility>              //For std::swap function
+#include <type_traits>          //std::is_same
+#include <utility>              //For std::swap, std::move, std::forward functions
+#include <vector>               //Iterator's frontier
 #include "array_stack.hpp"      //See operator <<
 
 
@@ -25,12 +28,55 @@ template<class T>
 bool undefinedgt (const T& a, const T& b) {return false;}
 #endif /* undefinedgtdefined */
 
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
 //Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
 //If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
 //If both tgt and cgt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
-template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class HeapPriorityQueue {
+//Alternatively, leave tgt defaulted and supply a stateless functor type GT (e.g., std::greater<T>, or a
+//  lambda's type in C++20): GT()(...) is then called directly, so it can be inlined (as is a
+//  tgt template argument); only a cgt supplied at run time is called through the pointer gt.
+//Supplying both tgt and GT is a compile-time error.
+//arity is the number of children per node (2: a binary heap). A larger arity makes the heap
+//  shallower (log_arity N levels, so percolate_up compares less) and puts a node's children
+//  side by side in the array, at the cost of arity-1 compares per level in percolate_down;
+//  4 is usually fastest for large queues.
+//If addressable is true, enqueue/emplace return a handle naming the new element for as long as it
+//  stays in the queue: update(h,value) changes its priority (e.g., decrease-key), erase(h) removes
+//  it and contains(h) checks for it, all O(log N) through a handle->position index that sifting
+//  keeps up to date. A handle names a slot in that index (the low 24 bits) and the slot's
+//  generation (the 6 bits above): a slot freed when its element leaves the queue (or clear) is
+//  reused with the next generation, so a stale handle is rejected (contains is false; update/erase
+//  raise KeyError) rather than naming the slot's new element, until the slot has been reused 64
+//  times. At most 2^24 slots are issued (else IcsError). Calling these on a queue that is not
+//  addressable is a compile-time error.
+//If stable is true, values of equal priority are dequeued (and iterated) in the order they were
+//  enqueued (merge counts as enqueuing other's values after this queue's; update keeps a value's
+//  place). Each value is tagged with a 32-bit sequence number that breaks ties; the numbers are
+//  kept in a parallel array, so the values' array is not padded, and are renumbered 0..size()-1
+//  (in the same order) in the rare event that they run out.
+//If bounded is true, the queue keeps only the capacity() highest values it is offered (e.g., the
+//  best 1,000 of 100M candidates) in an array of that length, which never grows: the length
+//  constructor's initial_length is the capacity (the initializer_list/Iterable constructors use
+//  the number of values they start with; see set_capacity). A capacity must be at least 1, so a
+//  bounded queue has no default constructor, and a capacity of 0 (or starting from no values)
+//  raises IcsError, as does enqueuing into a queue that was moved from, rather than silently
+//  dropping every value. The heap is inverted, so its root is the LOWEST value kept: once
+//  full, enqueue/emplace reject (returning 0) a value no higher than it in O(1), and otherwise
+//  replace it and percolate down in O(log capacity). peek, dequeue, the Iterator, top_k and
+//  dequeue_batch therefore go lowest first; drain_sorted returns the values highest first.
+//  A bounded queue cannot also be addressable.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>, class GT = undefinedfunctor, int arity = 2, bool addressable = false, bool stable = false, bool bounded = false> class HeapPriorityQueue {
   public:
     typedef bool (*gtfunc) (const T& a, const T& b);
         
@@ -39,7 +85,8 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
 
     HeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
     explicit HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
-    HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    HeapPriorityQueue(const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    HeapPriorityQueue(HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&& to_move);   //O(1): takes to_move's array, leaving it empty
     explicit HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -51,66 +98,137 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
     bool empty      () const;
     int  size       () const;
     T&   peek       () const;
+    bool contains   (int h) const;   //Addressable only: whether h is the handle of an element in the queue
+    std::vector<T> top_k (int k) const;   //The (up to) k highest values, highest first: O(k log k)
+    int  capacity   () const;    //Bounded only: the most values kept
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
 
     //Commands
+    //enqueue/emplace return 1 (the number of elements added) or, if addressable, the new element's handle
     int  enqueue (const T& element);
+    int  enqueue (T&& element);
     T    dequeue ();
     void clear   ();
 
+    //Dequeues the (up to) k highest values into out (e.g., std::back_inserter(v)), highest first;
+    //  returns how many
+    template <class OutputIterator>
+    int  dequeue_batch (int k, OutputIterator out);
+
+    //Dequeues every value, returning them highest first (even if bounded): O(N log N)
+    std::vector<T> drain_sorted ();
+
+    //Bounded only: keep at most k >= 1 values from now on (else IcsError), first dequeuing the
+    //  lowest values over k
+    void set_capacity (int k);
+
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    //enqueue_all and merge append all the values and then restore the heap (see sift_appended)
     template <class Iterable>
     int enqueue_all (const Iterable& i);
+    int merge       (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& other);
+    int merge       (HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&& other);   //Moves other's values, leaving it empty
+
+    //Enqueues T(args...), moved into the first unused array slot
+    template <class... Args>
+    int emplace (Args&&... args);
+
+    //Addressable only: h must be a handle from enqueue/emplace still in the queue (else KeyError)
+    void update (int h, const T& element);   //Replace h's value, then percolate it up or down: O(log N)
+    T    erase  (int h);                     //Remove and return h's value: O(log N)
 
 
     //Operators
-    HeapPriorityQueue<T,tgt>& operator = (const HeapPriorityQueue<T,tgt>& rhs);
-    bool operator == (const HeapPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const HeapPriorityQueue<T,tgt>& rhs) const;
+    HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& operator = (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& rhs);
+    HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& operator = (HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&& rhs);   //O(1): swaps arrays with rhs
+    bool operator == (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& rhs) const;
+    bool operator != (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class GT2, int arity2, bool addressable2, bool stable2, bool bounded2>
+    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2,GT2,arity2,addressable2,stable2,bounded2>& pq);
 
 
 
+    //Iterator yields the values in priority order without copying the queue: it keeps a small heap
+    //  of the indexes in pq not yet yielded whose parents have been (its frontier), ordered by their
+    //  values in pq, so reaching the k-th value is O(k log k) time and O(k*arity) space. Equal values
+    //  are yielded lower index first (or by sequence number, if stable), a strict order in which pq is
+    //  also a heap: so a value has been yielded iff it comes before the current one, and erase (which
+    //  must know that of the last value, as it fills the erased one's place) is O(log N + log F) for a
+    //  frontier of F indexes.
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HeapPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        HeapPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
+        HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& operator ++ ();
+        HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator  operator ++ (int);
+        bool operator == (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& rhs) const;
+        bool operator != (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
 
-        friend Iterator HeapPriorityQueue<T,tgt>::begin () const;
-        friend Iterator HeapPriorityQueue<T,tgt>::end   () const;
+        friend Iterator HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::begin () const;
+        friend Iterator HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::end   () const;
 
       private:
-        //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        HeapPriorityQueue<T,tgt>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
-        HeapPriorityQueue<T,tgt>* ref_pq;
+        //If can_erase is false, the value has been removed from ref_pq (++ does nothing);
+        //  either way the highest index in frontier is the next value to yield
+        std::vector<int>          frontier;           //Heap of indexes in ref_pq->pq, by their values (see Lower)
+        HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* ref_pq;
         int                       expected_mod_count;
         bool                      can_erase = true;
 
+        struct Lower {                                //Orders frontier for std::push_heap/pop_heap: a after b
+          HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* q;
+          bool operator () (int a, int b) const {return q->before(b,a) || (!stable && b < a && !q->before(a,b));}
+        };
+        void advance      ();                         //Replace frontier's highest index by its children
+        void add_children (int i);                    //Push i's children onto frontier
+        void drop_stale   ();                         //Pop indexes >= used (left by erase) off frontier's top
+        bool yielded      (int i) const;              //Whether pq[i] is the current value or was yielded before it
+
         //Called in friends begin/end
-        //These constructors have different initializers (see it(...) in first one)
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin);    // Called by begin
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over);                     // Called by end
+        Iterator(HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* iterate_over, bool from_begin);
+    };
+
+
+    //UnorderedIterator walks pq in array (not priority) order: O(1) per step and no allocation.
+    //  It cannot erase; use it when the order does not matter (e.g., searching or summing).
+    class UnorderedIterator {
+      public:
+        //Private constructor called in unordered_begin/unordered_end
+        HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator& operator ++ ();
+        HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator  operator ++ (int);
+        bool operator == (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator& rhs) const;
+        bool operator != (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend UnorderedIterator HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::unordered_begin () const;
+        friend UnorderedIterator HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::unordered_end   () const;
+
+      private:
+        HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* ref_pq;
+        int                       current;            //Index in ref_pq->pq
+        int                       expected_mod_count;
+
+        UnorderedIterator(HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* iterate_over, int initial);
     };
 
 
     Iterator begin () const;
     Iterator end   () const;
 
+    UnorderedIterator unordered_begin () const;
+    UnorderedIterator unordered_end   () const;
+
 
   private:
     bool (*gt) (const T& a, const T& b); //The gt used by enqueue (from template or constructor)
@@ -118,17 +236,54 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
     int length    = 0;                   //Physical length of array: must be >= .size()
     int used      = 0;                   //Amount of array used:  invariant: 0 <= used <= length
     int mod_count = 0;                   //For sensing concurrent modification
+    int* handle_of  = nullptr;           //If addressable: handle_of[i] is the handle of pq[i] (i < used)
+    int* position   = nullptr;           //If addressable: position[slot_of(h)] is h's index in pq, or < 0 if its slot is free
+    int next_handle = 0;                 //If addressable: slots 0..next_handle-1 have been issued
+    int free_handle = -1;                //If addressable: first free handle (the rest chained via position[slot_of(h)] == -2-next)
+    static const int slot_bits       = 24;   //A handle is generation << slot_bits | slot
+    static const int generation_bits = 6;    //Keeps handles < 2^30, so -2-next fits in an int
+    unsigned int* sequence = nullptr;    //If stable: sequence[i] is pq[i]'s sequence number (i < used)
+    unsigned int next_sequence = 0;      //If stable: the number for the next value enqueued
+
+    static_assert(std::is_same<GT,undefinedfunctor>::value || tgt == (gtfunc)undefinedgt<T>,
+                  "HeapPriorityQueue: supply tgt or GT, not both");
+    static_assert(arity >= 2, "HeapPriorityQueue: arity must be at least 2");
+    static_assert(!(bounded && addressable), "HeapPriorityQueue: a bounded queue cannot be addressable");
+    static gtfunc template_gt ();                      //functor_gt if GT is supplied, else tgt (undefinedgt if neither)
+    static bool functor_gt  (const T& a, const T& b);
+    bool higher (const T& a, const T& b) const;   //gt(a,b), called directly when tgt/GT fixes it at compile time
+    bool before (const T& a, unsigned int sa, const T& b, unsigned int sb) const;   //higher(a,b), ties broken by sequence number if stable; inverted if bounded
+    bool before (const T& a, unsigned int sa, int j) const;                         //a (with sequence number sa) before pq[j]
+    bool before (int i, int j) const;                                               //pq[i] before pq[j]
 
 
     //Helper methods
-    void ensure_length  (int new_length);
+    void ensure_length  (int new_length);     //Grow pq to at least new_length (exactly, if bounded)
+    void reallocate     (int new_length);     //Move the values (and index) into arrays of new_length >= used
+    int  replace_root   ();                   //Bounded: re-sift the value just stored at pq[0], and count it
+    int  add_last       ();                   //Percolate up the value just stored at pq[used], and count it
+    void store_last     (const T& element);   //pq[used] = element, growing pq first (element may be in pq)
+    void append         ();                   //Count the value just stored at pq[used], without sifting it
+    void sift_appended  (int first);          //Restore the heap after appending pq[first..used-1]
+    void remove_at      (int i);              //Fill pq[i] (already moved out) with the last value and re-sift it
+    void allocate_index ();                   //Allocate handle_of/position (if addressable) and sequence (if stable) for length values
+    int  issue_handle   (int i);              //Give pq[i] a new (or freed) handle; returns it
+    void release_handle (int h);
+    int  handle_at      (int i) const;        //handle_of[i] if addressable, else 0
+    static int slot_of  (int h);              //h's index in position
+    void issue_sequence (int i);              //If stable: give pq[i] the next sequence number
+    void renumber       ();                   //Replace the sequence numbers by 0..used-1, in the same order
+    std::vector<int> by_sequence () const;    //If stable: indexes 0..used-1 in enqueue order (else empty)
+    unsigned int sequence_at (int i) const;   //sequence[i] if stable, else 0
+    void place          (int i, T&& value, int h, unsigned int s);   //pq[i] = value, recording h/s as for add_last
     int  left_child     (int i) const;         //Useful abstractions for heaps as arrays
-    int  right_child    (int i) const;
+    int  right_child    (int i) const;         //Children of i are left_child(i)..right_child(i)
     int  parent         (int i) const;
     bool is_root        (int i) const;
     bool in_heap        (int i) const;
-    void percolate_up   (int i);
+    void percolate_up   (int i);              //Both move a hole instead of swapping: one move per level
     void percolate_down (int i);
+    int  bounce_down    (int i);              //Move the hole at i to a leaf along higher children; returns its index
     void heapify        ();                   // Percolate down all value is array (from indexes used-1 to 0): O(N)
   };
 
@@ -142,74 +297,121 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::~HeapPriorityQueue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::~HeapPriorityQueue() {
     delete[] pq;
+    delete[] handle_of;
+    delete[] position;
+    delete[] sequence;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
-        : gt(tgt != (bool (*)(const T& a, const T& b))undefinedgt<T> ? tgt : cgt) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
+        : gt(template_gt() != (bool (*)(const T& a, const T& b))undefinedgt<T> ? template_gt() : cgt) {
     if (gt == (gtfunc)undefinedgt<T>)
         throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
-    if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
         throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 
+    static_assert(!bounded, "HeapPriorityQueue: a bounded queue needs a capacity (use the length constructor)");
+
     pq = new T[length];
+    allocate_index();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
-: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), length(initial_length)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
+: gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt), length(initial_length)
 {
     if (gt == (gtfunc)undefinedgt<T>)
         throw TemplateFunctionError("ArrayPriorityQueue::length constructor: neither specified");
-    if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
         throw TemplateFunctionError("ArrayPriorityQueue::length constructor: both specified and different");
+    if (bounded && length < 1)
+        throw IcsError("HeapPriorityQueue::length constructor: a bounded queue's capacity must be at least 1");
 
     if (length < 0)
         length = 0;
     pq = new T[length];
+    allocate_index();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
-    : gt(to_copy.gt), used(to_copy.used), length(to_copy.length)//gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& to_copy, bool (*cgt)(const T& a, const T& b))
+    : gt(to_copy.gt), used(to_copy.used), length(to_copy.length)//gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
 {
         //std::cout << "copy" << std::endl;
         if (gt == (gtfunc)undefinedgt<T>)
             gt = to_copy.gt;//throw TemplateFunctionError("ArrayPriorityQueue::copy constructor: neither specified");
-        if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+        if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
             throw TemplateFunctionError("ArrayPriorityQueue::copy constructor: both specified and different");
 
         pq = new T[length];
+        allocate_index();
 
         if (gt == to_copy.gt) {
             used = to_copy.used;
             for (int i=0; i<to_copy.used; ++i)
                 pq[i] = to_copy.pq[i];
-        }else
+            if (addressable) {
+                std::copy(to_copy.handle_of, to_copy.handle_of+used,               handle_of);
+                std::copy(to_copy.position,  to_copy.position+to_copy.next_handle, position);
+                next_handle = to_copy.next_handle;
+                free_handle = to_copy.free_handle;
+            }
+            if (stable) {
+                std::copy(to_copy.sequence, to_copy.sequence+used, sequence);
+                next_sequence = to_copy.next_sequence;
+            }
+        }else {
+            used = 0;
             for (int i=0; i<to_copy.used; ++i)
                 enqueue(to_copy.pq[i]);
+        }
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
-:gt(tgt != (gtfunc)undefinedgt<T> ? tgt: cgt), length(il.size())
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::HeapPriorityQueue(HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&& to_move)
+: gt(to_move.gt), pq(to_move.pq), length(to_move.length), used(to_move.used),
+  handle_of(to_move.handle_of), position(to_move.position), next_handle(to_move.next_handle), free_handle(to_move.free_handle),
+  sequence(to_move.sequence), next_sequence(to_move.next_sequence)
+{
+    to_move.pq     = new T[0];
+    to_move.length = 0;
+    to_move.used   = 0;
+    to_move.handle_of   = to_move.position = nullptr;
+    to_move.next_handle = 0;
+    to_move.free_handle = -1;
+    to_move.sequence    = nullptr;
+    to_move.next_sequence = 0;
+    to_move.allocate_index();
+    ++to_move.mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+:gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt(): cgt), length(il.size())
 {
     if (gt == (gtfunc)undefinedgt<T>)
         throw TemplateFunctionError("HeapPriorityQueue::length constructor: neither specified");
-    if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
         throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: both specified and different");
+    if (bounded && length < 1)
+        throw IcsError("HeapPriorityQueue::initializer_list constructor: a bounded queue's capacity must be at least 1");
 
     int i = 0;
     pq = new T[length];
+    allocate_index();
     for (auto& value: il) {
         pq[i] = value;
+        if (addressable)
+            issue_handle(i);
+        issue_sequence(i);
         ++i;
     }
     used = length;
@@ -219,20 +421,26 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
 template<class Iterable>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
-:gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), length(i.size())
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+:gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt), length(i.size())
 {
     if (gt == (gtfunc)undefinedgt<T>)
         throw TemplateFunctionError("HeapPriorityQueue::length constructor: neither specified");
-    if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
         throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: both specified and different");
+    if (bounded && length < 1)
+        throw IcsError("HeapPriorityQueue::Iterable constructor: a bounded queue's capacity must be at least 1");
 
     int j = 0;
     pq = new T[length];
+    allocate_index();
     for (auto& value: i) {
         pq[j] = value;
+        if (addressable)
+            issue_handle(j);
+        issue_sequence(j);
         ++j;
     }
     used = length;
@@ -245,20 +453,20 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::empty() const {
     return used==0;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::size() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::size() const {
     return used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T& HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::peek () const {
     //std::cout << "here" << std::endl;
     if (empty())
         throw EmptyError("HeapPriorityQueue::peek");
@@ -267,8 +475,35 @@ T& HeapPriorityQueue<T,tgt>::peek () const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::contains (int h) const {
+    static_assert(addressable, "HeapPriorityQueue::contains requires an addressable HeapPriorityQueue");
+    if (h < 0 || slot_of(h) >= next_handle)
+        return false;
+    int i = position[slot_of(h)];
+    return i >= 0 && handle_of[i] == h;   //A stale handle's slot is free or has a later generation
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::capacity () const {
+    static_assert(bounded, "HeapPriorityQueue::capacity requires a bounded HeapPriorityQueue");
+    return length;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+std::vector<T> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::top_k (int k) const {
+    std::vector<T> answer;
+    answer.reserve(std::max(0,std::min(k,used)));
+    for (Iterator i = begin(); (int)answer.size() < k && i != end(); ++i)
+        answer.push_back(*i);
+    return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+std::string HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::str() const {
     std::ostringstream answer;
     answer << "HeapPriorityQueue[";
 
@@ -287,66 +522,266 @@ std::string HeapPriorityQueue<T,tgt>::str() const {
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::enqueue(const T& element) {
+    if (bounded && used == length) {
+        if (used == 0)
+            throw IcsError("HeapPriorityQueue::enqueue: bounded queue has no capacity (moved from?)");
+        if (!higher(element,pq[0]))
+            return 0;
+        pq[0] = element;
+        return replace_root();
+    }
+    store_last(element);
+    return add_last();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::enqueue(T&& element) {
+    if (bounded && used == length) {
+        if (used == 0)
+            throw IcsError("HeapPriorityQueue::enqueue: bounded queue has no capacity (moved from?)");
+        if (!higher(element,pq[0]))
+            return 0;
+        pq[0] = std::move(element);
+        return replace_root();
+    }
     ensure_length(used+1);
-    pq[used]=element;
-    percolate_up(used);
-    used++;
-    ++mod_count;
-    return 1;
+    pq[used]=std::move(element);
+    return add_last();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::dequeue() {
-    T value=pq[0];
-    std::swap(pq[0],pq[used-1]);
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::dequeue() {
+    if (empty())
+        throw EmptyError("HeapPriorityQueue::dequeue");
+    //Floyd's "bounce": the last value almost always belongs near the bottom, so sift the
+    //  root's hole all the way down without comparing to it, then percolate it up from there
+    T value=std::move(pq[0]);
+    if (addressable)
+        release_handle(handle_of[0]);
     used--;
-    percolate_down(0);
+    if (used > 0) {
+        int hole = bounce_down(0);
+        place(hole, std::move(pq[used]), handle_at(used), sequence_at(used));
+        percolate_up(hole);
+    }
     ++mod_count;
     return value;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::clear() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::clear() {
+    if (addressable)                     //Keep the slots, so their handles' generations advance
+        for (int i = 0; i < used; ++i)
+            release_handle(handle_of[i]);
     used = 0;
+    next_sequence = 0;
     ++mod_count;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+template <class OutputIterator>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::dequeue_batch (int k, OutputIterator out) {
+    k = std::max(0,std::min(k,used));
+    for (int j = 0; j < k; ++j)
+        *out++ = dequeue();
+    return k;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+std::vector<T> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::drain_sorted () {
+    int n = used;
+    std::vector<T> answer(n);
+    for (int j = 0; j < n; ++j)
+        answer[bounded ? n-1-j : j] = dequeue();   //A bounded queue dequeues lowest first
+    return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::set_capacity (int k) {
+    static_assert(bounded, "HeapPriorityQueue::set_capacity requires a bounded HeapPriorityQueue");
+    if (k < 1)
+        throw IcsError("HeapPriorityQueue::set_capacity: a bounded queue's capacity must be at least 1");
+    while (used > k)
+        dequeue();
+    reallocate(k);
+    ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
 template <class Iterable>
-int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
-    int count = 0;
-    for (const T& v : i)
-        count += enqueue(v);
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::enqueue_all (const Iterable& i) {
+    if (bounded) {
+        int count = 0;
+        for (const T& v : i)
+            count += enqueue(v);
+        return count;
+    }
+    int first = used;
+    for (const T& v : i) {
+        store_last(v);
+        append();
+    }
+    sift_appended(first);
+    return used-first;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::merge (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& other) {
+    int first = used, count = other.used;   //other may be *this
+    std::vector<int> order = other.by_sequence();   //If stable, append in other's enqueue order
+    if (bounded) {
+        std::vector<T> values;
+        values.reserve(count);
+        for (int j = 0; j < count; ++j)
+            values.push_back(other.pq[stable ? order[j] : j]);
+        count = 0;
+        for (T& v : values)
+            count += enqueue(std::move(v));
+        return count;
+    }
+    ensure_length(used+count);
+    for (int j = 0; j < count; ++j) {
+        pq[used] = other.pq[stable ? order[j] : j];
+        append();
+    }
+    sift_appended(first);
     return count;
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::merge (HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&& other) {
+    if (this == &other)
+        return merge(static_cast<const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&>(other));
+    if (bounded) {
+        int count = merge(static_cast<const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&>(other));
+        other.clear();
+        return count;
+    }
+    int first = used;
+    ensure_length(used+other.used);
+    std::vector<int> order = other.by_sequence();   //If stable, append in other's enqueue order
+    for (int j = 0; j < other.used; ++j) {
+        pq[used] = std::move(other.pq[stable ? order[j] : j]);
+        append();
+    }
+    other.clear();
+    sift_appended(first);
+    return used-first;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+template <class... Args>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::emplace (Args&&... args) {
+    if (bounded && used == length)
+        return enqueue(T(std::forward<Args>(args)...));
+    ensure_length(used+1);
+    pq[used]=T(std::forward<Args>(args)...);
+    return add_last();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::update (int h, const T& element) {
+    static_assert(addressable, "HeapPriorityQueue::update requires an addressable HeapPriorityQueue");
+    if (!contains(h)) {
+        std::ostringstream answer;
+        answer << "HeapPriorityQueue::update: handle(" << h << ") not in queue";
+        throw KeyError(answer.str());
+    }
+    int  i  = position[slot_of(h)];
+    bool up = higher(element,pq[i]);     //Keeps its sequence number, so an equal value stays put
+    pq[i] = element;
+    if (up)
+        percolate_up(i);
+    else
+        percolate_down(i);
+    ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::erase (int h) {
+    static_assert(addressable, "HeapPriorityQueue::erase requires an addressable HeapPriorityQueue");
+    if (!contains(h)) {
+        std::ostringstream answer;
+        answer << "HeapPriorityQueue::erase: handle(" << h << ") not in queue";
+        throw KeyError(answer.str());
+    }
+    int i = position[slot_of(h)];
+    T value = std::move(pq[i]);
+    release_handle(h);
+    remove_at(i);
+    return value;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriorityQueue<T,tgt>& rhs) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::operator = (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& rhs) {
     //std::cout << "assignment" << std::endl;
     if (this == &rhs)
         return *this;
     gt = rhs.gt;
-    this->ensure_length(rhs.used);
+    if (bounded) {                       //Take rhs's capacity
+        used = 0;
+        reallocate(rhs.length);
+    }
+    this->ensure_length(addressable ? rhs.next_handle : rhs.used);
     used = rhs.used;
     for (int i = 0; i < used; ++i)
         pq[i] = rhs.pq[i];
+    if (addressable) {
+        std::copy(rhs.handle_of, rhs.handle_of+used,           handle_of);
+        std::copy(rhs.position,  rhs.position+rhs.next_handle, position);
+        next_handle = rhs.next_handle;
+        free_handle = rhs.free_handle;
+    }
+    if (stable) {
+        std::copy(rhs.sequence, rhs.sequence+used, sequence);
+        next_sequence = rhs.next_sequence;
+    }
     ++mod_count;
     return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::operator = (HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(gt,     rhs.gt);
+    std::swap(pq,     rhs.pq);
+    std::swap(length, rhs.length);
+    std::swap(used,   rhs.used);
+    std::swap(handle_of,   rhs.handle_of);
+    std::swap(position,    rhs.position);
+    std::swap(next_handle, rhs.next_handle);
+    std::swap(free_handle, rhs.free_handle);
+    std::swap(sequence,      rhs.sequence);
+    std::swap(next_sequence, rhs.next_sequence);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::operator == (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& rhs) const {
     //std::cout <<  "check1" << std::endl;
     if (this == &rhs)
         return true;
@@ -354,8 +789,15 @@ bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs)
         return false;
     if (used != rhs.used)
         return false;
-    ics::HeapPriorityQueue<T,tgt>::Iterator temp=rhs.begin();
-    for(ics::HeapPriorityQueue<T,tgt>::Iterator p=begin(); p!=end(); ++p){
+    //A copy (or a queue built by the same operations) has the same array: check that in O(N)
+    //  before comparing the values in priority order
+    int i = 0;
+    while (i < used && pq[i] == rhs.pq[i])
+        ++i;
+    if (i == used)
+        return true;
+    ics::HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator temp=rhs.begin();
+    for(ics::HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator p=begin(); p!=end(); ++p){
         if(*p!=*temp){
             return false;
         }
@@ -366,16 +808,22 @@ bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator != (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::operator != (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& rhs) const {
     return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p){
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>& p){
     outs << "priority_queue[";
-    if (!p.empty()){
+    if (bounded) {                       //Its Iterator already goes lowest first
+        bool first = true;
+        for (auto i : p) {
+            outs << (first ? "" : ",") << i;
+            first = false;
+        }
+    }else if (!p.empty()){
         ArrayStack<T> newStack;
         for (auto i : p)
             newStack.push(i);
@@ -394,17 +842,29 @@ std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p
 //
 //Iterator constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::begin () const -> HeapPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::begin () const -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator {
     //std::cout << "begin" << std::endl;
-    return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this), true);
+    return Iterator(const_cast<HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>*>(this), true);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::end () const -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator {
     //std::cout << "end" << std::endl;
-    return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this));
+    return Iterator(const_cast<HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>*>(this), false);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::unordered_begin () const -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator {
+    return UnorderedIterator(const_cast<HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>*>(this), 0);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::unordered_end () const -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator {
+    return UnorderedIterator(const_cast<HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>*>(this), used);
 }
 
 
@@ -412,91 +872,345 @@ auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterato
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::ensure_length(int new_length) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+typename HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::gtfunc HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::template_gt () {
+    return !std::is_same<GT,undefinedfunctor>::value ? functor_gt : tgt;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::functor_gt (const T& a, const T& b) {
+    return GT()(a,b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::higher (const T& a, const T& b) const {
+    if (!std::is_same<GT,undefinedfunctor>::value)
+        return GT()(a,b);
+    if (tgt != (gtfunc)undefinedgt<T>)
+        return tgt(a,b);
+    return gt(a,b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::before (const T& a, unsigned int sa, const T& b, unsigned int sb) const {
+    if (bounded)                         //Inverted: lower values (and later of equals) first
+        return higher(b,a) || (stable && sb < sa && !higher(a,b));
+    if (higher(a,b))
+        return true;
+    return stable && sa < sb && !higher(b,a);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::before (const T& a, unsigned int sa, int j) const {
+    return before(a, sa, pq[j], sequence_at(j));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::before (int i, int j) const {
+    return before(pq[i], sequence_at(i), pq[j], sequence_at(j));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::ensure_length(int new_length) {
     if (length >= new_length)
         return;
+    reallocate(bounded ? new_length : std::max(new_length,2*length));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::reallocate(int new_length) {
     T* old_pq = pq;
-    length = std::max(new_length,2*length);
+    length = new_length;
     pq = new T[length];
     for (int i=0; i<used; ++i)
-        pq[i] = old_pq[i];
+        pq[i] = std::move(old_pq[i]);
     delete[] old_pq;
+
+    int* old_handle_of = handle_of;
+    int* old_position  = position;
+    unsigned int* old_sequence = sequence;
+    allocate_index();
+    if (addressable) {
+        std::copy(old_handle_of, old_handle_of+used,        handle_of);
+        std::copy(old_position,  old_position+next_handle,  position);
+        delete[] old_handle_of;
+        delete[] old_position;
+    }
+    if (stable) {
+        std::copy(old_sequence, old_sequence+used, sequence);
+        delete[] old_sequence;
+    }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::add_last() {
+    int answer = addressable ? issue_handle(used) : 1;
+    issue_sequence(used);
+    percolate_up(used);
+    used++;
+    ++mod_count;
+    return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::replace_root() {
+    issue_sequence(0);
+    percolate_down(0);
+    ++mod_count;
+    return 1;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::left_child(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::store_last(const T& element) {
+    if (used < length) {
+        pq[used] = element;
+        return;
+    }
+    T copy(element);
+    ensure_length(used+1);
+    pq[used] = std::move(copy);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::append() {
+    if (addressable)
+        issue_handle(used);
+    issue_sequence(used);
+    used++;
+    ++mod_count;     //Iterating over this queue while appending to it throws ConcurrentModificationError
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::sift_appended(int first) {
+    //Percolating each new value up is O(1) on average (random priorities) but O(log N) if they
+    //  keep outranking the queue; heapify is always O(N), which measures faster only once at
+    //  least as many values are new as were already in the queue
+    if (used-first >= first) {
+        heapify();
+        return;
+    }
+    for (int i = first; i < used; ++i)
+        percolate_up(i);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::remove_at(int i) {
+    used--;
+    if (i != used) {
+        place(i, std::move(pq[used]), handle_at(used), sequence_at(used));
+        if (!is_root(i) && before(i,parent(i)))
+            percolate_up(i);
+        else
+            percolate_down(i);
+    }
+    ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::allocate_index() {
+    if (addressable) {
+        handle_of = new int[length];
+        position  = new int[length];
+    }
+    if (stable)
+        sequence = new unsigned int[length];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::issue_handle(int i) {
+    //Fewer slots are issued than values fit in pq, so a new slot always fits in position
+    int h;
+    if (free_handle >= 0) {
+        h = free_handle;
+        free_handle = -2-position[slot_of(h)];
+    }else {
+        if (next_handle == 1 << slot_bits)
+            throw IcsError("HeapPriorityQueue::enqueue: more than 2^24 addressable elements");
+        h = next_handle++;
+    }
+    handle_of[i]          = h;
+    position[slot_of(h)]  = i;
+    return h;
+}
+
+
+//Frees h's slot, chaining the handle for the slot's next generation onto free_handle
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::release_handle(int h) {
+    position[slot_of(h)] = -2-free_handle;
+    free_handle = (h + (1 << slot_bits)) & ((1 << (slot_bits+generation_bits)) - 1);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::handle_at(int i) const {
+    return addressable ? handle_of[i] : 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::slot_of(int h) {
+    return h & ((1 << slot_bits) - 1);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::issue_sequence(int i) {
+    if (!stable)
+        return;
+    if (next_sequence == ~0u)
+        renumber();
+    sequence[i] = next_sequence++;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::renumber() {
+    //Ranks preserve the order of the sequence numbers, so the heap ordering property still holds
+    std::vector<int> order = by_sequence();
+    for (int rank = 0; rank < used; ++rank)
+        sequence[order[rank]] = rank;
+    next_sequence = used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+std::vector<int> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::by_sequence() const {
+    std::vector<int> answer;
+    if (!stable)
+        return answer;
+    answer.resize(used);
+    for (int i = 0; i < used; ++i)
+        answer[i] = i;
+    std::sort(answer.begin(), answer.end(), [this] (int i, int j) {return sequence[i] < sequence[j];});
+    return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+unsigned int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::sequence_at(int i) const {
+    return stable ? sequence[i] : 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::place(int i, T&& value, int h, unsigned int s) {
+    pq[i] = std::move(value);
+    if (addressable) {
+        handle_of[i]         = h;
+        position[slot_of(h)] = i;
+    }
+    if (stable)
+        sequence[i] = s;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::left_child(int i) const
 {
-    return(2*i+1);
+    return(arity*i+1);
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::right_child(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::right_child(int i) const
 {
-    return(2*i+2);
+    return(arity*i+arity);
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::parent(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::parent(int i) const
 {
-    return (i-1)/2;
+    return (i-1)/arity;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::is_root(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::is_root(int i) const
 {
     return i==0;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::in_heap(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::in_heap(int i) const
 {
     return i < used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_up(int i) {
-    //std::cout<< "check1: " <<  i << std::endl;
-    int N=i;
-    while(N!=0){
-        //std::cout<< "check2: " <<  pq[N] << " : " << pq[parent(N)] << " : " << gt(pq[N],pq[parent(N)]) <<std::endl;
-        if(gt(pq[N],pq[parent(N)])){
-            std::swap(pq[parent(N)],pq[N]);
-        }
-        N=parent(N);
-    }
-    return;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::percolate_up(int i) {
+    if (is_root(i) || !before(i,parent(i)))
+        return;
+    int h   = handle_at(i);
+    unsigned int s = sequence_at(i);
+    T value = std::move(pq[i]);
+    do {
+        place(i, std::move(pq[parent(i)]), handle_at(parent(i)), sequence_at(parent(i)));
+        i = parent(i);
+    } while (!is_root(i) && before(value,s,parent(i)));
+    place(i, std::move(value), h, s);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
-    int deepest_child;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::percolate_down(int i) {
+    if (!in_heap(left_child(i)))
+        return;
+    int h   = handle_at(i);
+    unsigned int s = sequence_at(i);
+    T value = std::move(pq[i]);
     int l = left_child(i);
     while (in_heap(l)){
-        int r = right_child(i);
-
-        if (!in_heap(r) || gt(pq[l], pq[r]))
-            deepest_child = l;
-        else
-            deepest_child = r;
-
-        if (gt(pq[i],pq[deepest_child]))
+        //Highest-priority child (the last of equals, as for a binary heap)
+        int r = std::min(right_child(i), used-1);
+        int deepest_child = l;
+        for (int c = l+1; c <= r; ++c)
+            if (!before(deepest_child, c))
+                deepest_child = c;
+
+        if (before(value,s,deepest_child))
             break;
-        else
-            std::swap(pq[deepest_child], pq[i]);
+        place(i, std::move(pq[deepest_child]), handle_at(deepest_child), sequence_at(deepest_child));
         i = deepest_child;
         l = left_child(i);
     }
+    place(i, std::move(value), h, s);
+}
 
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+int HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::bounce_down(int i) {
+    for (int l = left_child(i); in_heap(l); l = left_child(i)) {
+        int r = std::min(right_child(i), used-1);
+        int deepest_child = l;
+        for (int c = l+1; c <= r; ++c)
+            if (!before(deepest_child, c))
+                deepest_child = c;
+        place(i, std::move(pq[deepest_child]), handle_at(deepest_child), sequence_at(deepest_child));
+        i = deepest_child;
+    }
+    return i;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::heapify() {
-for (int i = used-1; i >= 0; --i)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::heapify() {
+//Leaves are already heaps: start at the last internal node
+for (int i = used > 1 ? parent(used-1) : -1; i >= 0; --i)
     percolate_down(i);
 
 }
@@ -506,150 +1220,274 @@ for (int i = used-1; i >= 0; --i)
 //
 //Iterator class definitions
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool tgt_nullptr)
-       :ref_pq(iterate_over), it(*iterate_over)
-{
-    //it = *ref_pq;
-    //std::cout << "Initial 1" << std::endl;
-    expected_mod_count=ref_pq->mod_count;
-}
-
-
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::Iterator(HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* iterate_over, bool from_begin)
+       :ref_pq(iterate_over)
 {
+    expected_mod_count = ref_pq->mod_count;
+    if (from_begin && !ref_pq->empty())
+        frontier.push_back(0);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::~Iterator()
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::~Iterator()
 {}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::Iterator::erase() {
-    //std::cout << "erase" << std::endl;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::erase() {
     if (expected_mod_count != ref_pq->mod_count)
         throw ConcurrentModificationError("HeapPriorityQueue::Iterator::erase");
     if (!can_erase)
-        throw CannotEraseError("ArrayPriorityQueue::Iterator::erase Iterator cursor already erased");
+        throw CannotEraseError("HeapPriorityQueue::Iterator::erase Iterator cursor already erased");
+    if (frontier.empty())
+        throw CannotEraseError("HeapPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
 
     can_erase = false;
-    T to_return = it.dequeue();
-    for(int i=0; i<ref_pq->size(); i++){
-        if(ref_pq->pq[i]==to_return){
-            std::swap(ref_pq->pq[i],ref_pq->pq[ref_pq->used-1]);
-            ref_pq->used--;
-            ref_pq->percolate_down(i);
-        }
+    HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* q = ref_pq;
+    int  i    = frontier.front();
+    int  last = q->used-1;
+    bool last_yielded  = yielded(last);
+    bool last_frontier = !last_yielded && q->parent(last) != i && yielded(q->parent(last));
+    T to_return = std::move(q->pq[i]);
+    if (addressable)
+        q->release_handle(q->handle_of[i]);
+
+    //Take i off frontier before any value moves, so frontier stays a heap
+    std::pop_heap(frontier.begin(), frontier.end(), Lower{q});
+    frontier.pop_back();
+    q->used--;
+    if (i == last)
+        ;
+    else if (!last_yielded) {
+        //pq[last] is not yet yielded, so it is no higher than i's (yielded) parent: it fills i
+        //  and percolates down inside i's subtree, which holds only values not yet yielded; i
+        //  goes back on frontier. If last is on frontier too, its value is copied, not moved, so
+        //  its (now stale) index keeps its place there until drop_stale pops it
+        if (last_frontier)
+            q->place(i, T(q->pq[last]), q->handle_at(last), q->sequence_at(last));
+        else
+            q->place(i, std::move(q->pq[last]), q->handle_at(last), q->sequence_at(last));
+        q->percolate_down(i);
+        frontier.push_back(i);
+        std::push_heap(frontier.begin(), frontier.end(), Lower{q});
+    }else {
+        //pq[last] was yielded, so it is at least as high as everything in i's subtree: it fills
+        //  i and can only percolate up (past yielded values); i now holds a yielded value
+        q->place(i, std::move(q->pq[last]), q->handle_at(last), q->sequence_at(last));
+        q->percolate_up(i);
+        add_children(i);
     }
+    drop_stale();
+    ++q->mod_count;
 
-    expected_mod_count = ref_pq->mod_count;
+    expected_mod_count = q->mod_count;
     return to_return;
-
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+std::string HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_pq->str() << "/frontier[";
+    for (int i=0; i<(int)frontier.size(); ++i)
+        answer << (i == 0 ? "" : ",") << frontier[i];
+    answer << "]/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+    return answer.str();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt>::Iterator& {
-    //std::cout << "++()" << std::endl;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& {
     if (expected_mod_count != ref_pq->mod_count)
         throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++");
 
-    if(it.size()==0){
+    if (frontier.empty())
         return *this;
-    }
-    if(can_erase){
-        it.dequeue();
-    }
-    else{
-        can_erase=true;
-    }
+    if (can_erase)
+        advance();
+    else
+        can_erase = true;
     return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt>::Iterator {
-    //std::cout << "++(int)" << std::endl;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator {
     if (expected_mod_count != ref_pq->mod_count)
         throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++(int)");
-    if(it.size()==0){
+
+    if (frontier.empty())
         return *this;
-    }
     Iterator to_return(*this);
-    if(can_erase){
-        it.dequeue();
-    }
-    else{
-        can_erase=true;
-    }
+    if (can_erase)
+        advance();
+    else
+        can_erase = true;
     return to_return;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
-    //std::cout << "==" << std::endl;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::operator == (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& rhs) const {
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
-//    if (expected_mod_count != ref_pq->mod_count)
-//        throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ==");
-//    if (rhsASI == 0)
-//        throw IteratorTypeError("HeapPriorityQueue::Iterator::operator ==");
-//    if (ref_pq != rhsASI->ref_pq)
-//        throw ComparingDifferentIteratorsError("HeapPriorityQueue::Iterator::operator ==");
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ==");
+    if (rhsASI == 0)
+        throw IteratorTypeError("HeapPriorityQueue::Iterator::operator ==");
+    if (ref_pq != rhsASI->ref_pq)
+        throw ComparingDifferentIteratorsError("HeapPriorityQueue::Iterator::operator ==");
+
+    if (frontier.empty() || rhsASI->frontier.empty())
+        return frontier.empty() == rhsASI->frontier.empty();
+    return frontier.front() == rhsASI->frontier.front();
+}
 
-    return it.size() == rhsASI->it.size();
 
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::operator != (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator& rhs) const {
+    return !(*this == rhs);
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T& HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::operator *() const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
+    if (!can_erase || frontier.empty()) {
+        std::ostringstream where;
+        where << " when size = " << ref_pq->size();
+        throw IteratorPositionIllegal("HeapPriorityQueue::Iterator::operator * Iterator illegal: "+where.str());
+    }
+    return ref_pq->pq[frontier.front()];
+}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
-    //std::cout << "!=" << std::endl;
-    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
-//    if (expected_mod_count != ref_pq->mod_count)
-//        throw ConcurrentModificationError("ArrayPriorityQueue::Iterator::operator !=");
-//    if (rhsASI == 0)
-//        throw IteratorTypeError("HeapPriorityQueue::Iterator::operator !=");
-//    if (ref_pq != rhsASI->ref_pq)
-//        throw ComparingDifferentIteratorsError("HeapPriorityQueue::Iterator::operator !=");
-    return it.size() != rhsASI->it.size();;
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T* HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::operator ->() const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ->");
+    if (!can_erase || frontier.empty()) {
+        std::ostringstream where;
+        where << " when size = " << ref_pq->size();
+        throw IteratorPositionIllegal("HeapPriorityQueue::Iterator::operator -> Iterator illegal: "+where.str());
+    }
+    return &ref_pq->pq[frontier.front()];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::advance() {
+    int i = frontier.front();
+    std::pop_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+    frontier.pop_back();
+    add_children(i);
+    drop_stale();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::add_children(int i) {
+    int r = std::min(ref_pq->right_child(i), ref_pq->used-1);
+    for (int c = ref_pq->left_child(i); c <= r; ++c) {
+        frontier.push_back(c);
+        std::push_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+    }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+void HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::drop_stale() {
+    while (!frontier.empty() && frontier.front() >= ref_pq->used) {
+        std::pop_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+        frontier.pop_back();
+    }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::Iterator::yielded(int i) const {
+    int current = frontier.front();
+    return i == current || Lower{ref_pq}(current, i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//UnorderedIterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::UnorderedIterator(HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>* iterate_over, int initial)
+       :ref_pq(iterate_over), current(initial)
+{
+    expected_mod_count = ref_pq->mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::operator ++ () -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator& {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("HeapPriorityQueue::UnorderedIterator::operator ++");
+
+    if (current < ref_pq->used)
+        ++current;
+    return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+auto HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::operator ++ (int) -> HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("HeapPriorityQueue::UnorderedIterator::operator ++(int)");
+
+    UnorderedIterator to_return(*this);
+    if (current < ref_pq->used)
+        ++current;
+    return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::operator == (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator& rhs) const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("HeapPriorityQueue::UnorderedIterator::operator ==");
+    if (ref_pq != rhs.ref_pq)
+        throw ComparingDifferentIteratorsError("HeapPriorityQueue::UnorderedIterator::operator ==");
+
+    return current == rhs.current;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+bool HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::operator != (const HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator& rhs) const {
+    return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
-    //std::cout << "*()" << std::endl;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T& HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::operator *() const {
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayPriorityQueue::Iterator::operator *");
-    if (!can_erase) {
-//        std::ostringstream where;
-//        where << current << " when size = " << ref_pq->size();
-        throw IteratorPositionIllegal("HeapPriorityQueue::Iterator::operator * Iterator illegal: ");
+        throw ConcurrentModificationError("HeapPriorityQueue::UnorderedIterator::operator *");
+    if (current >= ref_pq->used) {
+        std::ostringstream where;
+        where << current << " when size = " << ref_pq->size();
+        throw IteratorPositionIllegal("HeapPriorityQueue::UnorderedIterator::operator * Iterator illegal: "+where.str());
     }
-    return it.peek();
+    return ref_pq->pq[current];
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
-    //std::cout << "()" << std::endl;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT, int arity, bool addressable, bool stable, bool bounded>
+T* HeapPriorityQueue<T,tgt,GT,arity,addressable,stable,bounded>::UnorderedIterator::operator ->() const {
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayPriorityQueue::Iterator::operator *");
-    if (!can_erase) {
-//        std::ostringstream where;
-//        where << current << " when size = " << ref_pq->size();
-        throw IteratorPositionIllegal("HeapPriorityQueue::Iterator::operator -> Iterator illegal: ");
+        throw ConcurrentModificationError("HeapPriorityQueue::UnorderedIterator::operator ->");
+    if (current >= ref_pq->used) {
+        std::ostringstream where;
+        where << current << " when size = " << ref_pq->size();
+        throw IteratorPositionIllegal("HeapPriorityQueue::UnorderedIterator::operator -> Iterator illegal: "+where.str());
     }
-    return &it.peek();
+    return &ref_pq->pq[current];
 }
 
 }
@@ -6,7 +6,11 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
+#include <algorithm>            //std::max
 #include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
 #include "array_stack.hpp"      //See operator <<
 
 
@@ -19,18 +23,41 @@ template<class T>
 bool undefinedgt (const T& a, const T& b) {return false;}
 #endif /* undefinedgtdefined */
 
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
 //Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
 //If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
 //If both tgt and cgt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
-template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class LinkedPriorityQueue {
+//Alternatively, leave tgt defaulted and supply a stateless functor type GT (e.g., std::greater<T>, or a
+//  lambda's type in C++20): GT()(...) is then called directly, so it can be inlined (as is a
+//  tgt template argument); only a cgt supplied at run time is called through the pointer gt.
+//Supplying both tgt and GT is a compile-time error.
+//The values are kept in a linked list in priority order, values of equal priority in the order
+//  they were enqueued (so iteration and dequeue are stable). The list is the bottom of a skip
+//  list: each node also has an index node at level 1 with probability 1/4, at level 2 with
+//  probability 1/16, ..., and enqueue searches down through these levels, so it is expected
+//  O(log N). dequeue unlinks the front node (and its index nodes, which are at the front of their
+//  levels): expected O(1).
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>, class GT = undefinedfunctor> class LinkedPriorityQueue {
   public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
     //Destructor/Constructors
     ~LinkedPriorityQueue();
 
     LinkedPriorityQueue          (bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
-    LinkedPriorityQueue          (const LinkedPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    LinkedPriorityQueue          (const LinkedPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    LinkedPriorityQueue          (LinkedPriorityQueue<T,tgt,GT>&& to_move);   //O(1): takes to_move's list, leaving it empty
     explicit LinkedPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -47,6 +74,7 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
 
     //Commands
     int  enqueue (const T& element);
+    int  enqueue (T&& element);
     T    dequeue ();
     void clear   ();
 
@@ -54,14 +82,19 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
     template <class Iterable>
     int enqueue_all (const Iterable& i);
 
+    //Enqueues T(args...), constructed directly in its list node
+    template <class... Args>
+    int emplace (Args&&... args);
+
 
     //Operators
-    LinkedPriorityQueue<T,tgt>& operator = (const LinkedPriorityQueue<T,tgt>& rhs);
-    bool operator == (const LinkedPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const LinkedPriorityQueue<T,tgt>& rhs) const;
+    LinkedPriorityQueue<T,tgt,GT>& operator = (const LinkedPriorityQueue<T,tgt,GT>& rhs);
+    LinkedPriorityQueue<T,tgt,GT>& operator = (LinkedPriorityQueue<T,tgt,GT>&& rhs);   //O(1): swaps lists with rhs
+    bool operator == (const LinkedPriorityQueue<T,tgt,GT>& rhs) const;
+    bool operator != (const LinkedPriorityQueue<T,tgt,GT>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class GT2>
+    friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T2,gt2,GT2>& pq);
 
 
 
@@ -71,33 +104,33 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
   public:
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of LinkedPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of LinkedPriorityQueue<T,tgt,GT>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        LinkedPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        LinkedPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const;
+        LinkedPriorityQueue<T,tgt,GT>::Iterator& operator ++ ();
+        LinkedPriorityQueue<T,tgt,GT>::Iterator  operator ++ (int);
+        bool operator == (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
+        bool operator != (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt,GT>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator LinkedPriorityQueue<T,tgt>::begin () const;
-        friend Iterator LinkedPriorityQueue<T,tgt>::end   () const;
+        friend Iterator LinkedPriorityQueue<T,tgt,GT>::begin () const;
+        friend Iterator LinkedPriorityQueue<T,tgt,GT>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
         LN*             prev;            //prev should be initalized to the header
-        LN*             current;         //current == prev->next
-        LinkedPriorityQueue<T,tgt>* ref_pq;
+        LN*             current;         //current == prev->next; nullptr at the end
+        LinkedPriorityQueue<T,tgt,GT>* ref_pq;
         int             expected_mod_count;
         bool            can_erase = true;
 
         //Called in friends begin/end
-        Iterator(LinkedPriorityQueue<T,tgt>* iterate_over, LN* initial);
+        Iterator(LinkedPriorityQueue<T,tgt,GT>* iterate_over, LN* initial);
     };
 
 
@@ -110,20 +143,55 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
       public:
         LN ()                      {}
         LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        LN (const T& v, LN* n = nullptr) : value(v), next(n){}
+        LN (T&& v,      LN* n = nullptr) : value(std::move(v)), next(n){}
+        template <class... Args>
+        explicit LN (LN* n, Args&&... args) : value(std::forward<Args>(args)...), next(n){}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(LN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(LN)>::deallocate(p);}
 
         T   value;
         LN* next = nullptr;
     };
 
+    //Index node: node's place in one level of the skip list; down is node's index node one level
+    //  lower (nullptr at level 1, whose index nodes lead straight to the list)
+    class IN {
+      public:
+        IN (LN* n, IN* r, IN* d) : node(n), right(r), down(d){}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(IN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(IN)>::deallocate(p);}
+
+        LN* node;
+        IN* right;
+        IN* down;
+    };
+
+    static const int max_levels = 16;    //4^16 nodes expected before a level-16 index node: more than an int counts
+
 
     bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
     LN* front     =  new LN();
+    IN* header[max_levels];              //header[l] heads level l+1 (its node is front); only levels are allocated
+    int levels    =  0;
+    unsigned int seed = 2463534242u;     //For choosing the levels of each new node's index nodes
     int used      =  0;                  //Cache the number of values in linked list
     int mod_count =  0;                  //For sensing concurrent modification
 
+    static_assert(std::is_same<GT,undefinedfunctor>::value || tgt == (gtfunc)undefinedgt<T>,
+                  "LinkedPriorityQueue: supply tgt or GT, not both");
+    static gtfunc template_gt ();                      //functor_gt if GT is supplied, else tgt (undefinedgt if neither)
+    static bool functor_gt  (const T& a, const T& b);
+    bool higher (const T& a, const T& b) const;   //gt(a,b), called directly when tgt/GT fixes it at compile time
+
     //Helper methods
     void delete_list(LN*& front);        //Deallocate all LNs, and set front's argument to nullptr;
+    int  link       (LN* to_add);        //Link to_add in after every value with at least its priority
+    int  random_levels ();               //Levels for a new node's index nodes: k or more with probability 1/4^k
+    void add_level  ();                  //Allocate header[levels] and ++levels
+    void copy_list  (const LinkedPriorityQueue<T,tgt,GT>& source);  //Append copies of source's values (in order) to an empty queue, and index them
+    void unindex    (LN* to_remove);     //Unlink and deallocate to_remove's index nodes
+    void delete_index ();                //Deallocate all INs (including headers), and set levels to 0
 };
 
 
@@ -136,8 +204,9 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::~LinkedPriorityQueue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::~LinkedPriorityQueue() {
+    delete_index();
     LN* current = front;
     while( current != nullptr ) {
         LN* next = current->next;
@@ -148,18 +217,26 @@ LinkedPriorityQueue<T,tgt>::~LinkedPriorityQueue() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(bool (*cgt)(const T& a, const T& b))
-    :gt(tgt != undefinedgt<T> ? tgt : cgt)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(bool (*cgt)(const T& a, const T& b))
+    :gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
 {
+    if (gt == (gtfunc)undefinedgt<T>)
+        throw TemplateFunctionError("LinkedPriorityQueue::default constructor: neither specified");
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("LinkedPriorityQueue::default constructor: both specified and different");
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const LinkedPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(const LinkedPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b))
+    :gt(cgt != (gtfunc)undefinedgt<T> ? cgt : to_copy.gt)
 {
-    if((void *) cgt == (void *) tgt){
-        front=to_copy.front;
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("LinkedPriorityQueue::copy constructor: both specified and different");
+
+    if (gt == to_copy.gt){
+        copy_list(to_copy);
     }
     else{
         for (LN *p = to_copy.front->next; p != nullptr; p = p->next){
@@ -169,16 +246,43 @@ LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const LinkedPriorityQueue<T,tgt>
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(LinkedPriorityQueue<T,tgt,GT>&& to_move)
+    :gt(to_move.gt), front(to_move.front), levels(to_move.levels), used(to_move.used)
+{
+    for (int l = 0; l < levels; ++l)
+        header[l] = to_move.header[l];
+    to_move.front  = new LN();
+    to_move.levels = 0;
+    to_move.used   = 0;
+    ++to_move.mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+    :gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
 {
+    if (gt == (gtfunc)undefinedgt<T>)
+        throw TemplateFunctionError("LinkedPriorityQueue::initializer_list constructor: neither specified");
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("LinkedPriorityQueue::initializer_list constructor: both specified and different");
+
+    enqueue_all(il);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
 template<class Iterable>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+    :gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
 {
+    if (gt == (gtfunc)undefinedgt<T>)
+        throw TemplateFunctionError("LinkedPriorityQueue::Iterable constructor: neither specified");
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("LinkedPriorityQueue::Iterable constructor: both specified and different");
+
+    enqueue_all(i);
 }
 
 
@@ -186,26 +290,20 @@ LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const Iterable& i, bool (*cgt)(c
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::empty() const {
     return front->next == nullptr;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int LinkedPriorityQueue<T,tgt>::size() const {
-    int size=0;
-    if(front->next!= nullptr){
-        for (LN *p = front->next; p != nullptr; p = p->next){
-            size+=1;
-        }
-    }
-    return size;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::size() const {
+    return used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& LinkedPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& LinkedPriorityQueue<T,tgt,GT>::peek () const {
 
     if(front->next== nullptr){
         throw ics::EmptyError("Queue is Empty");
@@ -214,9 +312,14 @@ T& LinkedPriorityQueue<T,tgt>::peek () const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string LinkedPriorityQueue<T,tgt>::str() const {
-
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string LinkedPriorityQueue<T,tgt,GT>::str() const {
+    std::ostringstream answer;
+    answer << "LinkedPriorityQueue[";
+    for (LN *p = front->next; p != nullptr; p = p->next)
+        answer << p->value << (p->next == nullptr ? "" : "->");
+    answer << "](levels=" << levels << ",used=" << used << ",mod_count=" << mod_count << ")";
+    return answer.str();
 }
 
 
@@ -224,54 +327,63 @@ std::string LinkedPriorityQueue<T,tgt>::str() const {
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int LinkedPriorityQueue<T,tgt>::enqueue(const T& element) {
-    if(front->next== nullptr){
-        front->next=new LN(element);
-    }
-    else{
-        LN* temp;
-        bool check=false;
-        LN* q=front;
-        while(q->next!= nullptr){
-            if(gt(element,q->next->value)){
-                temp=q->next;
-                q->next=new LN(element);
-                q->next->next=temp;
-                check=true;
-                break;
-            }
-            q=q->next;
-        }
-        if(!check){
-            q->next=new LN(element);
-        }
-    }
-    return 1;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::enqueue(const T& element) {
+    return link(new LN(element));
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T LinkedPriorityQueue<T,tgt>::dequeue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::enqueue(T&& element) {
+    return link(new LN(std::move(element)));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T LinkedPriorityQueue<T,tgt,GT>::dequeue() {
     if (empty()==1){
-        throw EmptyError("ArrayQueue::dequeue");
+        throw EmptyError("LinkedPriorityQueue::dequeue");
+    }
+    LN* to_delete=front->next;
+    //to_delete's index nodes (if any) are first in levels 1, 2, ...
+    for (int l = 0; l < levels && header[l]->right != nullptr && header[l]->right->node == to_delete; ++l) {
+        IN* to_unlink = header[l]->right;
+        header[l]->right = to_unlink->right;
+        delete to_unlink;
     }
-    T val=front->next->value;
-    front->next=front->next->next;
+    T val=std::move(to_delete->value);
+    front->next=to_delete->next;
+    delete to_delete;
+    --used;
+    ++mod_count;
     return val;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void LinkedPriorityQueue<T,tgt>::clear() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::clear() {
+    delete_index();
     delete_list(front);
     front=new LN();
+    used=0;
+    ++mod_count;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
 template <class Iterable>
-int LinkedPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+int LinkedPriorityQueue<T,tgt,GT>::enqueue_all (const Iterable& i) {
+    int count = 0;
+    for (const T& v : i)
+        count += enqueue(v);
+    return count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+template <class... Args>
+int LinkedPriorityQueue<T,tgt,GT>::emplace (Args&&... args) {
+    return link(new LN(nullptr, std::forward<Args>(args)...));
 }
 
 
@@ -279,22 +391,37 @@ int LinkedPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>& LinkedPriorityQueue<T,tgt>::operator = (const LinkedPriorityQueue<T,tgt>& rhs) {
-    gt=rhs.gt;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>& LinkedPriorityQueue<T,tgt,GT>::operator = (const LinkedPriorityQueue<T,tgt,GT>& rhs) {
     if (this == &rhs){
         return *this;
     }
     clear();
-    for (LN *p = rhs.front->next; p != nullptr; p = p->next){
-        enqueue(p->value);
+    gt=rhs.gt;
+    copy_list(rhs);
+    return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>& LinkedPriorityQueue<T,tgt,GT>::operator = (LinkedPriorityQueue<T,tgt,GT>&& rhs) {
+    if (this == &rhs){
+        return *this;
     }
+    std::swap(gt,    rhs.gt);
+    std::swap(front, rhs.front);
+    for (int l = 0; l < std::max(levels,rhs.levels); ++l)   //header[l] for l >= levels is unset
+        std::swap(header[l], rhs.header[l]);
+    std::swap(levels, rhs.levels);
+    std::swap(used,  rhs.used);
+    ++mod_count;
+    ++rhs.mod_count;
     return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::operator == (const LinkedPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::operator == (const LinkedPriorityQueue<T,tgt,GT>& rhs) const {
     if((void *)gt != (void *)rhs.gt){
         return false;
     }
@@ -316,28 +443,23 @@ bool LinkedPriorityQueue<T,tgt>::operator == (const LinkedPriorityQueue<T,tgt>&
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::operator != (const LinkedPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::operator != (const LinkedPriorityQueue<T,tgt,GT>& rhs) const {
     return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt>& pq) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt,GT>& pq) {
     outs << "priority_queue[";
-    std::vector<T> t;
-    if(pq.size()!=0){
-        for (typename LinkedPriorityQueue<T,tgt>::LN* p = pq.front->next; p != nullptr; p = p->next){
-            t.push_back(p->value);
-        }
-    }
-    for (int i=t.size()-1; i>=0; i--){
-        if(i!= 0){
-            outs << t[i]+",";
-        }
-        else{
-            outs << t[i];
-        }
+    if (!pq.empty()) {
+        ArrayStack<T> reversed;
+        for (typename LinkedPriorityQueue<T,tgt,GT>::LN* p = pq.front->next; p != nullptr; p = p->next)
+            reversed.push(p->value);
+
+        outs << reversed.pop();
+        while (!reversed.empty())
+            outs << "," << reversed.pop();
     }
     outs << "]:highest";
     return outs;
@@ -349,15 +471,15 @@ std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt>&
 //Iterator constructors
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::begin () const -> LinkedPriorityQueue<T,tgt>::Iterator {
-    return Iterator(const_cast<LinkedPriorityQueue<T,tgt>*>(this),front);
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::begin () const -> LinkedPriorityQueue<T,tgt,GT>::Iterator {
+    return Iterator(const_cast<LinkedPriorityQueue<T,tgt,GT>*>(this),front->next);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::end () const -> LinkedPriorityQueue<T,tgt>::Iterator {
-    return Iterator(const_cast<LinkedPriorityQueue<T,tgt>*>(this), nullptr);
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::end () const -> LinkedPriorityQueue<T,tgt,GT>::Iterator {
+    return Iterator(const_cast<LinkedPriorityQueue<T,tgt,GT>*>(this), nullptr);
 }
 
 
@@ -365,8 +487,148 @@ auto LinkedPriorityQueue<T,tgt>::end () const -> LinkedPriorityQueue<T,tgt>::Ite
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void LinkedPriorityQueue<T,tgt>::delete_list(LN*& front) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+typename LinkedPriorityQueue<T,tgt,GT>::gtfunc LinkedPriorityQueue<T,tgt,GT>::template_gt () {
+    return !std::is_same<GT,undefinedfunctor>::value ? functor_gt : tgt;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::functor_gt (const T& a, const T& b) {
+    return GT()(a,b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::higher (const T& a, const T& b) const {
+    if (!std::is_same<GT,undefinedfunctor>::value)
+        return GT()(a,b);
+    if (tgt != (gtfunc)undefinedgt<T>)
+        return tgt(a,b);
+    return gt(a,b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::delete_list(LN*& front) {
+    while (front != nullptr) {
+        LN* to_delete = front;
+        front = front->next;
+        delete to_delete;
+    }
+}
+
+
+//Descend from the top level, moving right past every value with at least to_add's priority;
+//  update[l] is where that stopped on level l+1: to_add's index node there goes after it
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::link(LN* to_add) {
+    IN* update[max_levels];
+    LN* q=front;
+    if (levels > 0) {
+        IN* x = header[levels-1];
+        for (int l = levels-1; ; --l) {
+            while (x->right != nullptr && !higher(to_add->value,x->right->node->value))
+                x = x->right;
+            update[l] = x;
+            if (l == 0)
+                break;
+            x = x->down;
+        }
+        q = update[0]->node;
+    }
+    while(q->next!= nullptr && !higher(to_add->value,q->next->value)){
+        q=q->next;
+    }
+    to_add->next=q->next;
+    q->next=to_add;
+
+    int to_levels = random_levels();
+    while (levels < to_levels) {
+        add_level();
+        update[levels-1] = header[levels-1];
+    }
+    IN* below = nullptr;
+    for (int l = 0; l < to_levels; ++l)
+        below = update[l]->right = new IN(to_add, update[l]->right, below);
+
+    ++used;
+    ++mod_count;
+    return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::random_levels() {
+    seed ^= seed << 13;                  //xorshift
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    int answer = 0;
+    for (unsigned int bits = seed; (bits & 3) == 0 && answer < max_levels; bits >>= 2)
+        ++answer;
+    return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::add_level() {
+    header[levels] = new IN(front, nullptr, levels == 0 ? nullptr : header[levels-1]);
+    ++levels;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::copy_list(const LinkedPriorityQueue<T,tgt,GT>& source) {
+    IN* rear_index[max_levels];          //Last index node on each level
+    LN* rear=front;
+    for (LN *p = source.front->next; p != nullptr; p = p->next){
+        rear=rear->next=new LN(p->value);
+        ++used;
+        int to_levels = random_levels();
+        while (levels < to_levels) {
+            add_level();
+            rear_index[levels-1] = header[levels-1];
+        }
+        IN* below = nullptr;
+        for (int l = 0; l < to_levels; ++l)
+            below = rear_index[l] = rear_index[l]->right = new IN(rear, nullptr, below);
+    }
+}
+
+
+//On each level, move right past the values with higher priority than to_remove; its index node
+//  (if any) is among the following values of equal priority
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::unindex(LN* to_remove) {
+    if (levels == 0)
+        return;
+    IN* x = header[levels-1];
+    for (int l = levels-1; ; --l) {
+        while (x->right != nullptr && higher(x->right->node->value,to_remove->value))
+            x = x->right;
+        for (IN* y = x; y->right != nullptr && !higher(to_remove->value,y->right->node->value); y = y->right)
+            if (y->right->node == to_remove) {
+                IN* to_unlink = y->right;
+                y->right = to_unlink->right;
+                delete to_unlink;
+                break;
+            }
+        if (l == 0)
+            break;
+        x = x->down;
+    }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::delete_index() {
+    for (int l = 0; l < levels; ++l)
+        while (header[l] != nullptr) {
+            IN* to_delete = header[l];
+            header[l] = header[l]->right;
+            delete to_delete;
+        }
+    levels = 0;
 }
 
 
@@ -377,38 +639,63 @@ void LinkedPriorityQueue<T,tgt>::delete_list(LN*& front) {
 //
 //Iterator class definitions
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::Iterator::Iterator(LinkedPriorityQueue<T,tgt>* iterate_over, LN* initial)
-    :current(initial), ref_pq(iterate_over), expected_mod_count(ref_pq->mod_count)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::Iterator::Iterator(LinkedPriorityQueue<T,tgt,GT>* iterate_over, LN* initial)
+    :prev(iterate_over->front), current(initial), ref_pq(iterate_over), expected_mod_count(ref_pq->mod_count)
     {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::Iterator::~Iterator()
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::Iterator::~Iterator()
 {}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T LinkedPriorityQueue<T,tgt>::Iterator::erase() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T LinkedPriorityQueue<T,tgt,GT>::Iterator::erase() {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::erase");
     if (!can_erase)
-        throw CannotEraseError("ArrayQueue::Iterator::erase Iterator cursor already erased");
+        throw CannotEraseError("LinkedPriorityQueue::Iterator::erase Iterator cursor already erased");
+    if (current == nullptr)
+        throw CannotEraseError("LinkedPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+    can_erase = false;
+    LN* to_delete = current;
+    ref_pq->unindex(to_delete);
+    current = prev->next = to_delete->next;
+    T to_return = std::move(to_delete->value);
+    delete to_delete;
+    --ref_pq->used;
+    ++ref_pq->mod_count;
+
+    expected_mod_count = ref_pq->mod_count;
+    return to_return;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string LinkedPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string LinkedPriorityQueue<T,tgt,GT>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_pq->str() << "/current=";
+    if (current == nullptr)
+        answer << "nullptr";
+    else
+        answer << current->value;
+    answer << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+    return answer.str();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ () -> LinkedPriorityQueue<T,tgt>::Iterator& {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::Iterator::operator ++ () -> LinkedPriorityQueue<T,tgt,GT>::Iterator& {
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayQueue::Iterator::operator ++");
-    if(current->next==nullptr){
+        throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ++");
+    if(current==nullptr){
         return *this;
     }
     if (can_erase) {
+        prev=current;
         current=current->next;
     }
 
@@ -419,16 +706,17 @@ auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ () -> LinkedPriorityQueue
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> LinkedPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::Iterator::operator ++ (int) -> LinkedPriorityQueue<T,tgt,GT>::Iterator {
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayQueue::Iterator::operator ++(int)");
-    if (current->next == nullptr) {
+        throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ++(int)");
+    if (current == nullptr) {
 
         return *this;
     }
     Iterator to_return(*this);
     if (can_erase) {
+        prev=current;
         current=current->next;
     }
     else{
@@ -439,49 +727,42 @@ auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> LinkedPriorityQu
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::Iterator::operator == (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::Iterator::operator == (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
     const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
     if (rhsASI == 0)
-        throw IteratorTypeError("ArrayQueue::Iterator::operator ==");
+        throw IteratorTypeError("LinkedPriorityQueue::Iterator::operator ==");
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayQueue::Iterator::operator !=");
+        throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ==");
     if (ref_pq != rhsASI->ref_pq)
-        throw ComparingDifferentIteratorsError("ArrayQueue::Iterator::operator !=");
-    return current == rhsASI-> current->next;
+        throw ComparingDifferentIteratorsError("LinkedPriorityQueue::Iterator::operator ==");
+    return current == rhsASI-> current;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::Iterator::operator != (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const {
-    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
-    if (rhsASI == 0)
-        throw IteratorTypeError("ArrayQueue::Iterator::operator ==");
-    if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayQueue::Iterator::operator !=");
-    if (ref_pq != rhsASI->ref_pq)
-        throw ComparingDifferentIteratorsError("ArrayQueue::Iterator::operator !=");
-
-    if(current== nullptr){
-    }
-    return current != rhsASI-> current;
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::Iterator::operator != (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
+    return !(*this == rhs);
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& LinkedPriorityQueue<T,tgt>::Iterator::operator *() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& LinkedPriorityQueue<T,tgt,GT>::Iterator::operator *() const {
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayQueue::Iterator::operator *");
-    if (!can_erase || current->next== nullptr) {
-        throw IteratorPositionIllegal("LinkedQueue::Iterator::operator * Iterator illegal: ");
+        throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator *");
+    if (!can_erase || current== nullptr) {
+        throw IteratorPositionIllegal("LinkedPriorityQueue::Iterator::operator * Iterator illegal: ");
     }
-    return current->next->value;
+    return current->value;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* LinkedPriorityQueue<T,tgt>::Iterator::operator ->() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T* LinkedPriorityQueue<T,tgt,GT>::Iterator::operator ->() const {
     if (expected_mod_count != ref_pq->mod_count)
-        throw ConcurrentModificationError("ArrayQueue::Iterator::operator ->");
-    return &current->next->value;
+        throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ->");
+    if (!can_erase || current== nullptr) {
+        throw IteratorPositionIllegal("LinkedPriorityQueue::Iterator::operator -> Iterator illegal: ");
+    }
+    return &current->value;
 }
 
 
@@ -6,7 +6,9 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <utility>              //std::move, std::forward
 #include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
 
 
 namespace ics {
@@ -19,6 +21,7 @@ template<class T> class LinkedQueue {
 
     LinkedQueue          ();
     LinkedQueue          (const LinkedQueue<T>& to_copy);
+    LinkedQueue          (LinkedQueue<T>&& to_move);      //O(1): takes to_move's list, leaving it empty
     explicit LinkedQueue (const std::initializer_list<T>& il);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -35,6 +38,7 @@ template<class T> class LinkedQueue {
 
     //Commands
     int  enqueue (const T& element);
+    int  enqueue (T&& element);
     T    dequeue ();
     void clear   ();
 
@@ -42,9 +46,14 @@ template<class T> class LinkedQueue {
     template <class Iterable>
     int enqueue_all (const Iterable& i);
 
+    //Enqueues T(args...), constructed directly in its list node
+    template <class... Args>
+    int emplace (Args&&... args);
+
 
     //Operators
     LinkedQueue<T>& operator = (const LinkedQueue<T>& rhs);
+    LinkedQueue<T>& operator = (LinkedQueue<T>&& rhs);   //O(1): takes rhs's list, leaving it empty
     bool operator == (const LinkedQueue<T>& rhs) const;
     bool operator != (const LinkedQueue<T>& rhs) const;
 
@@ -98,7 +107,12 @@ template<class T> class LinkedQueue {
       public:
         LN ()                      {}
         LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        LN (const T& v, LN* n = nullptr) : value(v), next(n){}
+        LN (T&& v,      LN* n = nullptr) : value(std::move(v)), next(n){}
+        template <class... Args>
+        explicit LN (LN* n, Args&&... args) : value(std::forward<Args>(args)...), next(n){}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(LN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(LN)>::deallocate(p);}
 
         T   value;
         LN* next = nullptr;
@@ -112,6 +126,7 @@ template<class T> class LinkedQueue {
 
     //Helper methods
     void delete_list(LN*& front);  //Deallocate all LNs, and set front's argument to nullptr;
+    int  append     (LN* to_add);  //Link to_add in at the rear
 };
 
 
@@ -148,6 +163,16 @@ LinkedQueue<T>::LinkedQueue(const LinkedQueue<T>& to_copy) {
 }
 
 
+template<class T>
+LinkedQueue<T>::LinkedQueue(LinkedQueue<T>&& to_move)
+: front(to_move.front), rear(to_move.rear), used(to_move.used)
+{
+    to_move.front = to_move.rear = nullptr;
+    to_move.used  = 0;
+    ++to_move.mod_count;
+}
+
+
 template<class T>
 LinkedQueue<T>::LinkedQueue(const std::initializer_list<T>& il) {
     enqueue_all(il);
@@ -203,17 +228,13 @@ std::string LinkedQueue<T>::str() const {
 
 template<class T>
 int LinkedQueue<T>::enqueue(const T& element) {
+    return append(new LN(element));
+}
 
-    if(front == nullptr){
-        front = rear = new LN(element);
-    }
-    else
-    {
-        rear->next = new LN(element);
-        rear = rear-> next;
-    }
-    ++mod_count;
-    return 1;
+
+template<class T>
+int LinkedQueue<T>::enqueue(T&& element) {
+    return append(new LN(std::move(element)));
 }
 
 
@@ -222,8 +243,13 @@ T LinkedQueue<T>::dequeue() {
     if (empty()==1){
         throw EmptyError("ArrayQueue::dequeue");
     }
-    T val=front->value;
+    T val=std::move(front->value);
+    LN* to_delete=front;
     front=front->next;
+    if(front==nullptr){
+        rear=nullptr;
+    }
+    delete to_delete;
     ++mod_count;
     return val;
 }
@@ -231,7 +257,7 @@ T LinkedQueue<T>::dequeue() {
 
 template<class T>
 void LinkedQueue<T>::clear() {
-    front= nullptr;
+    delete_list(front);
     rear=nullptr;
     ++mod_count;
 }
@@ -248,6 +274,13 @@ int LinkedQueue<T>::enqueue_all(const Iterable& i) {
 }
 
 
+template<class T>
+template<class... Args>
+int LinkedQueue<T>::emplace(Args&&... args) {
+    return append(new LN(nullptr, std::forward<Args>(args)...));
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Operators
@@ -266,6 +299,23 @@ LinkedQueue<T>& LinkedQueue<T>::operator = (const LinkedQueue<T>& rhs) {
 }
 
 
+template<class T>
+LinkedQueue<T>& LinkedQueue<T>::operator = (LinkedQueue<T>&& rhs) {
+    if (this == &rhs){
+        return *this;
+    }
+    delete_list(front);
+    front = rhs.front;
+    rear  = rhs.rear;
+    used  = rhs.used;
+    rhs.front = rhs.rear = nullptr;
+    rhs.used  = 0;
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
 template<class T>
 bool LinkedQueue<T>::operator == (const LinkedQueue<T>& rhs) const {
     if(this->size() != rhs.size()){
@@ -332,7 +382,26 @@ auto LinkedQueue<T>::end () const -> LinkedQueue<T>::Iterator {
 
 template<class T>
 void LinkedQueue<T>::delete_list(LN*& front) {
-    std::cout << "delete_list" << std::endl;
+    while (front != nullptr) {
+        LN* to_delete = front;
+        front = front->next;
+        delete to_delete;
+    }
+}
+
+
+template<class T>
+int LinkedQueue<T>::append(LN* to_add) {
+    if(front == nullptr){
+        front = rear = to_add;
+    }
+    else
+    {
+        rear->next = to_add;
+        rear = rear->next;
+    }
+    ++mod_count;
+    return 1;
 }
 
 
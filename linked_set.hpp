@@ -6,7 +6,9 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <utility>              //std::move, std::forward, std::swap
 #include "ics_exceptions.hpp"
+#include "node_pool.hpp"       //Node allocation
 
 
 namespace ics {
@@ -20,6 +22,7 @@ template<class T> class LinkedSet {
     LinkedSet          ();
     explicit LinkedSet (int initialLength);
     LinkedSet          (const LinkedSet<T>& to_copy);
+    LinkedSet          (LinkedSet<T>&& to_move);          //O(1): takes to_move's list, leaving it empty
     explicit LinkedSet (const std::initializer_list<T>& il);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -40,6 +43,7 @@ template<class T> class LinkedSet {
 
     //Commands
     int  insert (const T& element);
+    int  insert (T&& element);
     int  erase  (const T& element);
     void clear  ();
 
@@ -54,9 +58,14 @@ template<class T> class LinkedSet {
     template<class Iterable>
     int retain_all(const Iterable& i);
 
+    //Inserts T(args...), constructed directly in its list node (deleted if already contained)
+    template <class... Args>
+    int emplace (Args&&... args);
+
 
     //Operators
     LinkedSet<T>& operator = (const LinkedSet<T>& rhs);
+    LinkedSet<T>& operator = (LinkedSet<T>&& rhs);       //O(1): takes rhs's list, leaving it empty
     bool operator == (const LinkedSet<T>& rhs) const;
     bool operator != (const LinkedSet<T>& rhs) const;
     bool operator <= (const LinkedSet<T>& rhs) const;
@@ -113,7 +122,12 @@ template<class T> class LinkedSet {
       public:
         LN ()                      {}
         LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        LN (const T& v, LN* n = nullptr) : value(v), next(n){}
+        LN (T&& v,      LN* n = nullptr) : value(std::move(v)), next(n){}
+        template <class... Args>
+        explicit LN (LN* n, Args&&... args) : value(std::forward<Args>(args)...), next(n){}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(LN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(LN)>::deallocate(p);}
 
         T   value;
         LN* next   = nullptr;
@@ -128,6 +142,7 @@ template<class T> class LinkedSet {
     //Helper methods
     int  erase_at   (LN* p);
     void delete_list(LN*& front);  //Deallocate all LNs (but trailer), and set front's argument to trailer;
+    int  append     (LN* to_add);  //Link to_add (not contained) in at the end of the list
 };
 
 
@@ -164,6 +179,15 @@ LinkedSet<T>::LinkedSet(const LinkedSet<T>& to_copy) : used(to_copy.used) {
 }
 
 
+template<class T>
+LinkedSet<T>::LinkedSet(LinkedSet<T>&& to_move) {
+    std::swap(front,   to_move.front);
+    std::swap(trailer, to_move.trailer);
+    std::swap(used,    to_move.used);
+    ++to_move.mod_count;
+}
+
+
 template<class T>
 LinkedSet<T>::LinkedSet(const std::initializer_list<T>& il) {
    insert_all(il);
@@ -247,10 +271,16 @@ int LinkedSet<T>::insert(const T& element) {
     if(contains(element)){
         return 0;
     }
-    front->next=new LN(element);
-    front=front->next;
-    used+=1;
-    return 1;
+    return append(new LN(element));
+}
+
+
+template<class T>
+int LinkedSet<T>::insert(T&& element) {
+    if(contains(element)){
+        return 0;
+    }
+    return append(new LN(std::move(element)));
 }
 
 
@@ -260,8 +290,12 @@ int LinkedSet<T>::erase(const T& element) {
         if(p->next->value==element){
             LN* to_delete = p->next;
             p->next=p->next->next;
+            if(to_delete==front){
+                front=p;
+            }
             delete to_delete;
             used-=1;
+            ++mod_count;
 
             return 1;
         }
@@ -273,10 +307,9 @@ int LinkedSet<T>::erase(const T& element) {
 
 template<class T>
 void LinkedSet<T>::clear() {
-    front = new LN();
-    trailer  = front;
+    delete_list(front);
     used = 0;
-
+    ++mod_count;
 }
 
 
@@ -310,6 +343,18 @@ int LinkedSet<T>::retain_all(const Iterable& i) {
 }
 
 
+template<class T>
+template<class... Args>
+int LinkedSet<T>::emplace(Args&&... args) {
+    LN* to_add = new LN(nullptr, std::forward<Args>(args)...);
+    if(contains(to_add->value)){
+        delete to_add;
+        return 0;
+    }
+    return append(to_add);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Operators
@@ -327,6 +372,20 @@ LinkedSet<T>& LinkedSet<T>::operator = (const LinkedSet<T>& rhs) {
 }
 
 
+template<class T>
+LinkedSet<T>& LinkedSet<T>::operator = (LinkedSet<T>&& rhs) {
+    if (this == &rhs){
+        return *this;
+    }
+    clear();
+    std::swap(front,   rhs.front);
+    std::swap(trailer, rhs.trailer);
+    std::swap(used,    rhs.used);
+    ++rhs.mod_count;
+    return *this;
+}
+
+
 template<class T>
 bool LinkedSet<T>::operator == (const LinkedSet<T>& rhs) const {
     if(size()!=rhs.size()){
@@ -432,6 +491,23 @@ int LinkedSet<T>::erase_at(LN* p) {
 
 template<class T>
 void LinkedSet<T>::delete_list(LN*& front) {
+    for (LN* p = trailer->next; p != nullptr; ) {
+        LN* to_delete = p;
+        p = p->next;
+        delete to_delete;
+    }
+    trailer->next = nullptr;
+    front = trailer;
+}
+
+
+template<class T>
+int LinkedSet<T>::append(LN* to_add) {
+    front->next = to_add;
+    front = to_add;
+    used += 1;
+    ++mod_count;
+    return 1;
 }
 
 
@@ -0,0 +1,185 @@
+#ifndef NODE_POOL_HPP_
+#define NODE_POOL_HPP_
+
+#include <cstddef>
+#include <new>
+#include <mutex>
+
+
+namespace ics {
+
+
+//NodePool<size> hands out fixed-size blocks for the list/tree nodes (LN/TN) of the
+//  linked containers, so allocating a node is popping a free list instead of a
+//  call to the global allocator. A node class opts in by defining its class-scope
+//    static void* operator new    (std::size_t) {return NodePool<sizeof(LN)>::allocate();}
+//    static void  operator delete (void* p)     {NodePool<sizeof(LN)>::deallocate(p);}
+//  so all node classes of the same size share one pool.
+//Blocks are carved from large slabs. Each thread caches free blocks in its own free
+//  list (no locking); a block freed on another thread joins that thread's cache. A
+//  cache holding more than two slabs' worth of blocks spills one batch (a slab's worth)
+//  into a shared pool, which a thread whose cache runs dry refills from before carving
+//  a new slab; an exiting thread spills its whole cache. So blocks freed by a consumer
+//  thread are reused by the producer thread, and a pool's footprint is the high-water
+//  mark of live nodes of its size plus at most two slabs per thread. Slabs themselves
+//  are never returned to the system (a node may outlive the thread that allocated it).
+//Define ICS_NO_NODE_POOL before including to send every node back to ::operator new
+//  (e.g., to compare against the global allocator).
+template<std::size_t size> class NodePool {
+  public:
+    static void* allocate   ();
+    static void  deallocate (void* p);
+
+  private:
+    union Block {
+      struct {
+        Block*       next;                 //While free: next block in its free list/batch
+        Block*       next_batch;           //While the head of a batch in the shared pool: the next batch
+      } link;
+      std::max_align_t align;
+      char           storage[size];
+    };
+
+    //Spills this thread's cache into the shared pool when the thread exits
+    struct CacheFlusher {
+      ~CacheFlusher() {spill(free_count);}
+    };
+
+    static const int slab_bytes      = 64*1024;
+    static const int blocks_per_slab = sizeof(Block) < slab_bytes/64 ? slab_bytes/sizeof(Block) : 64;
+    static const int cache_limit     = 2*blocks_per_slab;
+
+    static thread_local Block*       free_list;
+    static thread_local int          free_count;
+    static thread_local bool         flusher_registered;
+    static thread_local CacheFlusher flusher;
+
+    static std::mutex pool_lock;           //Guards shared_batches
+    static Block*     shared_batches;
+
+    //Helper methods
+    static void refill          ();        //Take a batch from the shared pool, or carve a new slab, onto free_list
+    static void spill           (int n);   //Move the first n blocks of free_list into the shared pool as one batch
+    static void register_thread ();        //Construct this thread's flusher
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//NodePool class and related definitions
+
+template<std::size_t size>
+thread_local typename NodePool<size>::Block* NodePool<size>::free_list = nullptr;
+
+template<std::size_t size>
+thread_local int NodePool<size>::free_count = 0;
+
+template<std::size_t size>
+thread_local bool NodePool<size>::flusher_registered = false;
+
+template<std::size_t size>
+thread_local typename NodePool<size>::CacheFlusher NodePool<size>::flusher;
+
+template<std::size_t size>
+std::mutex NodePool<size>::pool_lock;
+
+template<std::size_t size>
+typename NodePool<size>::Block* NodePool<size>::shared_batches = nullptr;
+
+
+template<std::size_t size>
+void* NodePool<size>::allocate() {
+#ifdef ICS_NO_NODE_POOL
+    return ::operator new(sizeof(Block));
+#else
+    if (free_list == nullptr)
+        refill();
+    Block* b  = free_list;
+    free_list = b->link.next;
+    --free_count;
+    return b;
+#endif
+}
+
+
+template<std::size_t size>
+void NodePool<size>::deallocate(void* p) {
+    if (p == nullptr)
+        return;
+#ifdef ICS_NO_NODE_POOL
+    ::operator delete(p);
+#else
+    Block* b    = static_cast<Block*>(p);
+    b->link.next = free_list;
+    free_list   = b;
+    if (++free_count > cache_limit)
+        spill(blocks_per_slab);
+    else if (!flusher_registered)
+        register_thread();
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<std::size_t size>
+void NodePool<size>::refill() {
+    if (!flusher_registered)
+        register_thread();
+
+    {
+        std::lock_guard<std::mutex> lock(pool_lock);
+        if (shared_batches != nullptr) {
+            free_list      = shared_batches;
+            shared_batches = shared_batches->link.next_batch;
+        }
+    }
+    if (free_list != nullptr) {
+        free_count = 0;
+        for (Block* b = free_list; b != nullptr; b = b->link.next)
+            ++free_count;
+        return;
+    }
+
+    Block* slab = static_cast<Block*>(::operator new(blocks_per_slab*sizeof(Block)));
+    for (int i = 0; i < blocks_per_slab-1; ++i)
+        slab[i].link.next = &slab[i+1];
+    slab[blocks_per_slab-1].link.next = nullptr;
+    free_list  = slab;
+    free_count = blocks_per_slab;
+}
+
+
+template<std::size_t size>
+void NodePool<size>::spill(int n) {
+    if (n == 0)
+        return;
+
+    Block* batch = free_list;
+    Block* last  = free_list;
+    for (int i = 1; i < n; ++i)
+        last = last->link.next;
+    free_list       = last->link.next;
+    free_count     -= n;
+    last->link.next = nullptr;
+
+    std::lock_guard<std::mutex> lock(pool_lock);
+    batch->link.next_batch = shared_batches;
+    shared_batches         = batch;
+}
+
+
+template<std::size_t size>
+void NodePool<size>::register_thread() {
+    flusher_registered = true;
+    (void)&flusher;                        //odr-use: constructs it (and schedules its destructor) in this thread
+}
+
+}
+
+#endif /* NODE_POOL_HPP_ */
@@ -0,0 +1,969 @@
+#ifndef OPEN_HASH_MAP_HPP_
+#define OPEN_HASH_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <cstdint>
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
+#include "ics_exceptions.hpp"
+#include "pair.hpp"
+#ifdef __SSE2__
+#include <emmintrin.h>          //For 16-byte control group matching
+#endif
+
+
+namespace ics {
+
+
+#ifndef undefinedhashdefined
+#define undefinedhashdefined
+template<class T>
+int undefinedhash (const T& a) {return 0;}
+#endif /* undefinedhashdefined */
+
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
+//An open-addressing alternative to HashMap with the same public interface.
+//Entries live directly in one array of slots; a parallel array of control bytes
+//  records for each slot whether it is EMPTY, DELETED, or FULL (and then the low
+//  7 bits of the key's hash). Lookups scan control bytes a group (16 slots) at a
+//  time, using SSE2 when available, and only compare keys whose 7 hash bits match.
+//The number of slots is always a power of 2 (>= group_width) and at most
+//  load_threshold (never more than 7/8) of them are ever FULL or DELETED.
+//Each FULL slot also keeps its key's hash(key) in a third array, so hash is called once per
+//  put/operator[]/emplace (whose probe for the key also finds the slot to claim) and never again
+//  for that key: growing, copying, assigning and comparing (==) maps with the same hash reuse it.
+//
+//Instantiate the templated class supplying thash(a): produces a hash value for a.
+//If thash is defaulted to undefinedhash in the template, then a constructor must supply chash.
+//If both thash and chash are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedhash value supplied by thash/chash is stored in the instance variable hash.
+//Alternatively, leave thash defaulted and supply a stateless functor type HASH (e.g., std::hash<KEY>, or a
+//  lambda's type in C++20): HASH()(...) is then called directly, so it can be inlined (as is a
+//  thash template argument); only a chash supplied at run time is called through the pointer hash.
+//Supplying both thash and HASH is a compile-time error.
+template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>, class HASH = undefinedfunctor> class OpenHashMap {
+  public:
+    typedef ics::pair<KEY,T>   Entry;
+    typedef int (*hashfunc) (const KEY& a);
+
+    //Destructor/Constructors
+    ~OpenHashMap ();
+
+    OpenHashMap          (double the_load_threshold = 0.875, int (*chash)(const KEY& a) = undefinedhash<KEY>);
+    explicit OpenHashMap (int initial_bins, double the_load_threshold = 0.875, int (*chash)(const KEY& k) = undefinedhash<KEY>);
+    OpenHashMap          (const OpenHashMap<KEY,T,thash,HASH>& to_copy, double the_load_threshold = 0.875, int (*chash)(const KEY& a) = undefinedhash<KEY>);
+    OpenHashMap          (OpenHashMap<KEY,T,thash,HASH>&& to_move);   //O(1): takes to_move's table, leaving it empty
+    explicit OpenHashMap (const std::initializer_list<Entry>& il, double the_load_threshold = 0.875, int (*chash)(const KEY& a) = undefinedhash<KEY>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit OpenHashMap (const Iterable& i, double the_load_threshold = 0.875, int (*chash)(const KEY& a) = undefinedhash<KEY>);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool has_key    (const KEY& key) const;
+    bool has_value  (const T& value) const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    T    put   (const KEY& key, const T& value);
+    T    put   (const KEY& key, T&& value);
+    T    erase (const KEY& key);
+    void clear ();
+
+    //Like put, but the value is T(args...) moved into key's slot; returns a reference to it
+    template <class... Args>
+    T&   emplace (const KEY& key, Args&&... args);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int put_all(const Iterable& i);
+
+
+    //Operators
+
+    T&       operator [] (const KEY&);
+    const T& operator [] (const KEY&) const;
+    OpenHashMap<KEY,T,thash,HASH>& operator = (const OpenHashMap<KEY,T,thash,HASH>& rhs);
+    OpenHashMap<KEY,T,thash,HASH>& operator = (OpenHashMap<KEY,T,thash,HASH>&& rhs);   //O(1): swaps tables with rhs
+    bool operator == (const OpenHashMap<KEY,T,thash,HASH>& rhs) const;
+    bool operator != (const OpenHashMap<KEY,T,thash,HASH>& rhs) const;
+
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const OpenHashMap<KEY2,T2,hash2,HASH2>& m);
+
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of OpenHashMap<T>
+        ~Iterator();
+        Entry       erase();
+        std::string str  () const;
+        OpenHashMap<KEY,T,thash,HASH>::Iterator& operator ++ ();
+        OpenHashMap<KEY,T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const OpenHashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const OpenHashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
+        Entry& operator *  () const;
+        Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const OpenHashMap<KEY,T,thash,HASH>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator OpenHashMap<KEY,T,thash,HASH>::begin () const;
+        friend Iterator OpenHashMap<KEY,T,thash,HASH>::end   () const;
+
+      private:
+        //If can_erase is false, current's slot was erased (must ++ to reach the next one)
+        int                       current;  //Slot index; stops at -1 (beyond the last FULL slot)
+        OpenHashMap<KEY,T,thash,HASH>* ref_map;
+        int                       expected_mod_count;
+        bool                      can_erase = true;
+
+        //Helper methods
+        void advance_cursor();
+
+        //Called in friends begin/end
+        Iterator(OpenHashMap<KEY,T,thash,HASH>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    //Control byte values: FULL slots store the low 7 bits of the hash (0..127)
+    static const signed char EMPTY       = -128;
+    static const signed char DELETED     = -2;
+    static const int         group_width = 16;
+
+    int (*hash)(const KEY& k);   //Hashing function used (from template or constructor)
+    signed char* ctrl = nullptr; //bins+group_width control bytes; the last group_width mirror the first
+    Entry* slots      = nullptr; //bins slots, meaningful only where ctrl is FULL
+    std::uint32_t* hashes = nullptr; //bins hash(key) values, meaningful only where ctrl is FULL
+    double load_threshold;       //(used+deleted)/bins <= load_threshold
+    int bins      = group_width; //# slots in array (always a power of 2)
+    int used      = 0;           //Cache for number of key->value pairs in the hash table
+    int deleted   = 0;           //# DELETED control bytes (tombstones) still in the table
+    int mod_count = 0;           //For sensing concurrent modification
+
+    static_assert(std::is_same<HASH,undefinedfunctor>::value || thash == (hashfunc)undefinedhash<KEY>,
+                  "OpenHashMap: supply thash or HASH, not both");
+    static hashfunc template_hash ();                      //functor_hash if HASH is supplied, else thash (undefinedhash if neither)
+    static int functor_hash  (const KEY& a);
+    int hash_of (const KEY& a) const;   //hash(a), called directly when thash/HASH fixes it at compile time
+
+
+    //Helper methods
+    static std::uint64_t mix   (std::uint32_t hashed);                //hash(key) spread over 64 bits
+    int   find_key             (const KEY& key)               const;  //Returns key's slot index or -1
+    int   find_key             (const KEY& key, std::uint32_t hashed, int* free_slot) const;  //Also sets *free_slot (if not
+                                                                      //  nullptr) to the first EMPTY/DELETED slot probed
+    int   find_free            (std::uint64_t h)              const;  //Returns first EMPTY/DELETED slot on h's probe sequence
+    void  set_ctrl             (int i, signed char c);                //Set control byte (and its mirror)
+    void  allocate_table       (int new_bins);                        //Allocate all-EMPTY ctrl/slots/hashes of new_bins
+    void  delete_table         ();
+    void  copy_table           (const OpenHashMap<KEY,T,thash,HASH>& from);   //Fill the (unallocated) table with from's entries
+    void  rehash               (int new_bins);                        //Move all FULL slots into a table of new_bins
+    int   take_free            (std::uint32_t hashed, int i = -1);    //FULL free slot i (default: the first on hashed's probe
+                                                                      //  sequence) for hashed, without a load check; returns i
+    int   claim_slot           (const KEY& key, std::uint32_t hashed, int free_slot);   //Make a FULL slot for absent key
+                                                                      //  (value T()) found by find_key; returns its index
+
+    bool  ensure_load_threshold(int new_used);                        //Reallocate (returning true) if (new_used+deleted)/bins > load_threshold
+
+    static unsigned int match       (const signed char* group, signed char c); //Bit i set iff group[i] == c
+    static unsigned int match_free  (const signed char* group);               //Bit i set iff group[i] is EMPTY/DELETED
+    static int          lowest_bit  (unsigned int mask);
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//OpenHashMap class and related definitions
+
+//Destructor/Constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::~OpenHashMap() {
+    delete_table();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::OpenHashMap(double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash)
+{
+    if (hash == (hashfunc)undefinedhash<KEY>)
+        throw TemplateFunctionError("OpenHashMap::default constructor: neither specified");
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
+        throw TemplateFunctionError("OpenHashMap::default constructor: both specified and different");
+
+    load_threshold = the_load_threshold > 0 && the_load_threshold < 0.875 ? the_load_threshold : 0.875;
+    allocate_table(group_width);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::OpenHashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash)
+{
+    if (hash == (hashfunc)undefinedhash<KEY>)
+        throw TemplateFunctionError("OpenHashMap::length constructor: neither specified");
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
+        throw TemplateFunctionError("OpenHashMap::length constructor: both specified and different");
+
+    load_threshold = the_load_threshold > 0 && the_load_threshold < 0.875 ? the_load_threshold : 0.875;
+    int new_bins = group_width;
+    while (new_bins < initial_bins)
+        new_bins *= 2;
+    allocate_table(new_bins);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::OpenHashMap(const OpenHashMap<KEY,T,thash,HASH>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash)
+{
+    if (hash == (hashfunc)undefinedhash<KEY>)
+        hash = to_copy.hash;
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
+        throw TemplateFunctionError("OpenHashMap::copy constructor: both specified and different");
+
+    load_threshold = the_load_threshold > 0 && the_load_threshold < 0.875 ? the_load_threshold : 0.875;
+    copy_table(to_copy);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::OpenHashMap(OpenHashMap<KEY,T,thash,HASH>&& to_move)
+: hash(to_move.hash), ctrl(to_move.ctrl), slots(to_move.slots), hashes(to_move.hashes), load_threshold(to_move.load_threshold),
+  bins(to_move.bins), used(to_move.used), deleted(to_move.deleted)
+{
+    to_move.allocate_table(group_width);
+    to_move.used    = 0;
+    to_move.deleted = 0;
+    ++to_move.mod_count;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::OpenHashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash)
+{
+    if (hash == (hashfunc)undefinedhash<KEY>)
+        throw TemplateFunctionError("OpenHashMap::initializer_list constructor: neither specified");
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
+        throw TemplateFunctionError("OpenHashMap::initializer_list constructor: both specified and different");
+
+    load_threshold = the_load_threshold > 0 && the_load_threshold < 0.875 ? the_load_threshold : 0.875;
+    allocate_table(group_width);
+    ensure_load_threshold(il.size());
+    for (const Entry& entry : il)
+        put(entry.first,entry.second);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+template <class Iterable>
+OpenHashMap<KEY,T,thash,HASH>::OpenHashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k))
+: hash(template_hash() != (hashfunc)undefinedhash<KEY> ? template_hash() : chash)
+{
+    if (hash == (hashfunc)undefinedhash<KEY>)
+        throw TemplateFunctionError("OpenHashMap::Iterable constructor: neither specified");
+    if (template_hash() != (hashfunc)undefinedhash<KEY> && chash != (hashfunc)undefinedhash<KEY> && template_hash() != chash)
+        throw TemplateFunctionError("OpenHashMap::Iterable constructor: both specified and different");
+
+    load_threshold = the_load_threshold > 0 && the_load_threshold < 0.875 ? the_load_threshold : 0.875;
+    allocate_table(group_width);
+    ensure_load_threshold(i.size());
+    for (const Entry& entry : i)
+        put(entry.first,entry.second);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::empty() const {
+    return used == 0;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::size() const {
+    return used;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::has_key (const KEY& key) const {
+    return find_key(key) != -1;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::has_value (const T& value) const {
+    for (int i = 0; i < bins; ++i)
+        if (ctrl[i] >= 0 && slots[i].second == value)
+            return true;
+    return false;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string OpenHashMap<KEY,T,thash,HASH>::str() const {
+    std::ostringstream answer;
+    answer << "OpenHashMap[";
+    for (int i = 0; i < bins; ++i) {
+        answer << " " << i << " : [";
+        if (ctrl[i] >= 0)
+            answer << '(' << slots[i].first << ',' << slots[i].second << ')';
+        else if (ctrl[i] == DELETED)
+            answer << "deleted";
+        answer << "]";
+    }
+    answer << "](bins=" << bins << ",used=" << used << ",deleted=" << deleted << ",mod_count=" << mod_count << ")";
+    return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T OpenHashMap<KEY,T,thash,HASH>::put(const KEY& key, const T& value) {
+    std::uint32_t hashed = hash_of(key);
+    int free_slot;
+    int i = find_key(key, hashed, &free_slot);
+    if (i != -1) {
+        T to_return = slots[i].second;
+        slots[i].second = value;
+        ++mod_count;
+        return to_return;
+    }
+
+    i = claim_slot(key, hashed, free_slot);
+    slots[i].second = value;
+    return value;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T OpenHashMap<KEY,T,thash,HASH>::put(const KEY& key, T&& value) {
+    std::uint32_t hashed = hash_of(key);
+    int free_slot;
+    int i = find_key(key, hashed, &free_slot);
+    if (i != -1) {
+        T to_return = std::move(slots[i].second);
+        slots[i].second = std::move(value);
+        ++mod_count;
+        return to_return;
+    }
+
+    i = claim_slot(key, hashed, free_slot);
+    slots[i].second = std::move(value);
+    return slots[i].second;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+template <class... Args>
+T& OpenHashMap<KEY,T,thash,HASH>::emplace(const KEY& key, Args&&... args) {
+    std::uint32_t hashed = hash_of(key);
+    int free_slot;
+    int i = find_key(key, hashed, &free_slot);
+    if (i != -1)
+        ++mod_count;
+    else
+        i = claim_slot(key, hashed, free_slot);
+    slots[i].second = T(std::forward<Args>(args)...);
+    return slots[i].second;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T OpenHashMap<KEY,T,thash,HASH>::erase(const KEY& key) {
+    int i = find_key(key);
+    if (i == -1) {
+        std::ostringstream answer;
+        answer << "OpenHashMap::erase: key(" << key << ") not in Map";
+        throw KeyError(answer.str());
+    }
+
+    T to_return = slots[i].second;
+    slots[i] = Entry();
+    set_ctrl(i, DELETED);
+    ++deleted;
+    --used;
+    ++mod_count;
+    return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::clear() {
+    delete_table();
+    allocate_table(group_width);
+    used    = 0;
+    deleted = 0;
+    ++mod_count;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+template<class Iterable>
+int OpenHashMap<KEY,T,thash,HASH>::put_all(const Iterable& i) {
+    int count = 0;
+    for (const Entry& m_entry : i) {
+        ++count;
+        put(m_entry.first, m_entry.second);
+    }
+
+    return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T& OpenHashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) {
+    std::uint32_t hashed = hash_of(key);
+    int free_slot;
+    int i = find_key(key, hashed, &free_slot);
+    if (i != -1)
+        return slots[i].second;
+
+    //claim_slot may rehash, replacing slots: index it only after the call
+    i = claim_slot(key, hashed, free_slot);
+    return slots[i].second;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+const T& OpenHashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) const {
+    int i = find_key(key);
+    if (i == -1) {
+        std::ostringstream answer;
+        answer << "OpenHashMap::operator []: key(" << key << ") not in Map";
+        throw KeyError(answer.str());
+    }
+    return slots[i].second;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>& OpenHashMap<KEY,T,thash,HASH>::operator = (const OpenHashMap<KEY,T,thash,HASH>& rhs) {
+    if (this == &rhs)
+        return *this;
+    delete_table();
+    hash = rhs.hash;
+    copy_table(rhs);
+    ++mod_count;
+    return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>& OpenHashMap<KEY,T,thash,HASH>::operator = (OpenHashMap<KEY,T,thash,HASH>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(hash,           rhs.hash);
+    std::swap(ctrl,           rhs.ctrl);
+    std::swap(slots,          rhs.slots);
+    std::swap(hashes,         rhs.hashes);
+    std::swap(load_threshold, rhs.load_threshold);
+    std::swap(bins,           rhs.bins);
+    std::swap(used,           rhs.used);
+    std::swap(deleted,        rhs.deleted);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::operator == (const OpenHashMap<KEY,T,thash,HASH>& rhs) const {
+    if (this == &rhs)
+        return true;
+    if (used != rhs.size())
+        return false;
+
+    //Reuse rhs's stored hashes when both maps hash alike
+    bool same_hash = hash == rhs.hash;
+    for (int i = 0; i < rhs.bins; ++i)
+        if (rhs.ctrl[i] >= 0) {
+            const KEY& key = rhs.slots[i].first;
+            int j = find_key(key, same_hash ? rhs.hashes[i] : (std::uint32_t)hash_of(key), nullptr);
+            if (j == -1 || slots[j].second != rhs.slots[i].second)
+                return false;
+        }
+    return true;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::operator != (const OpenHashMap<KEY,T,thash,HASH>& rhs) const {
+    return !(*this == rhs);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const OpenHashMap<KEY,T,thash,HASH>& m) {
+    outs << "map[";
+    int count = 0;
+    for (int i = 0; i < m.bins; ++i)
+        if (m.ctrl[i] >= 0) {
+            if (count++ != 0)
+                outs << ",";
+            outs << m.slots[i].first << "->" << m.slots[i].second;
+        }
+
+    outs << "]";
+    return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto OpenHashMap<KEY,T,thash,HASH>::begin () const -> OpenHashMap<KEY,T,thash,HASH>::Iterator {
+    return Iterator(const_cast<OpenHashMap<KEY,T,thash,HASH>*>(this),true);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto OpenHashMap<KEY,T,thash,HASH>::end () const -> OpenHashMap<KEY,T,thash,HASH>::Iterator {
+    return Iterator(const_cast<OpenHashMap<KEY,T,thash,HASH>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename OpenHashMap<KEY,T,thash,HASH>::hashfunc OpenHashMap<KEY,T,thash,HASH>::template_hash () {
+    return !std::is_same<HASH,undefinedfunctor>::value ? functor_hash : thash;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::functor_hash (const KEY& a) {
+    return (int)HASH()(a);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::hash_of (const KEY& a) const {
+    if (!std::is_same<HASH,undefinedfunctor>::value)
+        return (int)HASH()(a);
+    if (thash != (hashfunc)undefinedhash<KEY>)
+        return thash(a);
+    return hash(a);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::uint64_t OpenHashMap<KEY,T,thash,HASH>::mix (std::uint32_t hashed) {
+    //Fibonacci multiply then fold, so both the low 7 bits (stored in ctrl) and
+    //  the high bits (choosing the first group) depend on every bit of hash(key)
+    std::uint64_t h = (std::uint64_t)hashed * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::find_key (const KEY& key) const {
+    return find_key(key, hash_of(key), nullptr);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::find_key (const KEY& key, std::uint32_t hashed, int* free_slot) const {
+    std::uint64_t h     = mix(hashed);
+    signed char   h2    = (signed char)(h & 0x7F);
+    int           mask  = bins-1;
+    int           pos   = (int)(h >> 7) & mask;
+    if (free_slot != nullptr)
+        *free_slot = -1;
+
+    //Triangular probing over groups visits every group once before repeating;
+    //  the table always has an EMPTY slot, so the loop terminates (after passing the
+    //  first free slot, which is where find_free would put key)
+    for (int step = group_width; ; step += group_width) {
+        for (unsigned int m = match(ctrl+pos, h2); m != 0; m &= m-1) {
+            int i = (pos + lowest_bit(m)) & mask;
+            if (slots[i].first == key)
+                return i;
+        }
+        if (free_slot != nullptr && *free_slot == -1) {
+            unsigned int m = match_free(ctrl+pos);
+            if (m != 0)
+                *free_slot = (pos + lowest_bit(m)) & mask;
+        }
+        if (match(ctrl+pos, EMPTY) != 0)
+            return -1;
+        pos = (pos + step) & mask;
+    }
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::find_free (std::uint64_t h) const {
+    int mask = bins-1;
+    int pos  = (int)(h >> 7) & mask;
+    for (int step = group_width; ; step += group_width) {
+        unsigned int m = match_free(ctrl+pos);
+        if (m != 0)
+            return (pos + lowest_bit(m)) & mask;
+        pos = (pos + step) & mask;
+    }
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::set_ctrl (int i, signed char c) {
+    ctrl[i] = c;
+    if (i < group_width)
+        ctrl[bins+i] = c;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::allocate_table (int new_bins) {
+    bins   = new_bins;
+    ctrl   = new signed char[bins+group_width];
+    slots  = new Entry[bins];
+    hashes = new std::uint32_t[bins];
+    for (int i = 0; i < bins+group_width; ++i)
+        ctrl[i] = EMPTY;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::delete_table () {
+    delete [] ctrl;
+    delete [] slots;
+    delete [] hashes;
+    ctrl   = nullptr;
+    slots  = nullptr;
+    hashes = nullptr;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::copy_table (const OpenHashMap<KEY,T,thash,HASH>& from) {
+    //Copy the arrays verbatim if from's table also fits this load threshold; otherwise place
+    //  each entry (calling hash only if from's differs)
+    used    = 0;
+    deleted = 0;
+    if (hash == from.hash && from.used+from.deleted <= load_threshold*from.bins) {
+        allocate_table(from.bins);
+        used    = from.used;
+        deleted = from.deleted;
+        for (int i = 0; i < bins+group_width; ++i)
+            ctrl[i] = from.ctrl[i];
+        for (int i = 0; i < bins; ++i)
+            if (ctrl[i] >= 0) {
+                slots[i]  = from.slots[i];
+                hashes[i] = from.hashes[i];
+            }
+        return;
+    }
+
+    allocate_table(group_width);
+    ensure_load_threshold(from.used);
+    for (int i = 0; i < from.bins; ++i)
+        if (from.ctrl[i] >= 0) {
+            int j = take_free(hash == from.hash ? from.hashes[i] : (std::uint32_t)hash_of(from.slots[i].first));
+            slots[j] = from.slots[i];
+            ++used;
+        }
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::rehash (int new_bins) {
+    signed char*   old_ctrl   = ctrl;
+    Entry*         old_slots  = slots;
+    std::uint32_t* old_hashes = hashes;
+    int            old_bins   = bins;
+
+    allocate_table(new_bins);
+    deleted = 0;
+    for (int i = 0; i < old_bins; ++i)
+        if (old_ctrl[i] >= 0) {
+            int j = take_free(old_hashes[i]);
+            slots[j].first  = std::move(old_slots[i].first);
+            slots[j].second = std::move(old_slots[i].second);
+        }
+
+    delete [] old_ctrl;
+    delete [] old_slots;
+    delete [] old_hashes;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::take_free (std::uint32_t hashed, int i) {
+    std::uint64_t h = mix(hashed);
+    if (i == -1)
+        i = find_free(h);
+    if (ctrl[i] == DELETED)
+        --deleted;
+    set_ctrl(i, (signed char)(h & 0x7F));
+    hashes[i] = hashed;
+    return i;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::claim_slot (const KEY& key, std::uint32_t hashed, int free_slot) {
+    //Slots not FULL always hold a default Entry (see erase and allocate_table), so only first is set
+    //If the table was reallocated, free_slot was in the old one
+    int i = take_free(hashed, ensure_load_threshold(used+1) ? -1 : free_slot);
+    slots[i].first = key;
+    ++used;
+    ++mod_count;
+    return i;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::ensure_load_threshold(int new_used) {
+    if (new_used+deleted <= load_threshold*bins)
+        return false;
+
+    //Mostly tombstones: squeeze them out in place; otherwise double until new_used fits
+    int new_bins = bins;
+    if (new_used > load_threshold*bins/2)
+        while (new_used > load_threshold*new_bins)
+            new_bins *= 2;
+    rehash(new_bins);
+    return true;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+unsigned int OpenHashMap<KEY,T,thash,HASH>::match (const signed char* group, signed char c) {
+#ifdef __SSE2__
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), g));
+#else
+    unsigned int m = 0;
+    for (int i = 0; i < group_width; ++i)
+        if (group[i] == c)
+            m |= 1u << i;
+    return m;
+#endif
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+unsigned int OpenHashMap<KEY,T,thash,HASH>::match_free (const signed char* group) {
+    //EMPTY and DELETED are the only negative control bytes
+#ifdef __SSE2__
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return (unsigned int)_mm_movemask_epi8(g);
+#else
+    unsigned int m = 0;
+    for (int i = 0; i < group_width; ++i)
+        if (group[i] < 0)
+            m |= 1u << i;
+    return m;
+#endif
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int OpenHashMap<KEY,T,thash,HASH>::lowest_bit (unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int i = 0;
+    while ((mask & 1u) == 0) {
+        mask >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void OpenHashMap<KEY,T,thash,HASH>::Iterator::advance_cursor(){
+    for (int i = current+1; i < ref_map->bins; ++i)
+        if (ref_map->ctrl[i] >= 0) {
+            current = i;
+            return;
+        }
+    //ran out of slots to check so we set current = -1
+    current = -1;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::Iterator::Iterator(OpenHashMap<KEY,T,thash,HASH>* iterate_over, bool from_begin)
+: current(-1), ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
+    if (from_begin)
+        advance_cursor();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+OpenHashMap<KEY,T,thash,HASH>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto OpenHashMap<KEY,T,thash,HASH>::Iterator::erase() -> Entry {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::erase");
+    if (!can_erase)
+        throw CannotEraseError("OpenHashMap::Iterator::erase Iterator cursor already erased");
+    if (current == -1)
+        throw CannotEraseError("OpenHashMap::Iterator::erase Iterator cursor beyond data structure");
+
+    //Erasing never moves other entries, so current stays a valid cursor for ++
+    Entry to_return = ref_map->slots[current];
+    ref_map->slots[current] = Entry();
+    ref_map->set_ctrl(current, DELETED);
+    ++ref_map->deleted;
+
+    --ref_map->used;
+    ++ref_map->mod_count;
+    expected_mod_count = ref_map->mod_count;
+    can_erase = false;
+
+    return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string OpenHashMap<KEY,T,thash,HASH>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_map->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+    return answer.str();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto  OpenHashMap<KEY,T,thash,HASH>::Iterator::operator ++ () -> OpenHashMap<KEY,T,thash,HASH>::Iterator& {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::operator ++");
+
+    if (current == -1)
+        return *this;
+
+    advance_cursor();
+    can_erase = true;
+
+    return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto  OpenHashMap<KEY,T,thash,HASH>::Iterator::operator ++ (int) -> OpenHashMap<KEY,T,thash,HASH>::Iterator {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::operator ++(int)");
+
+    Iterator to_return(*this);
+
+    if (current == -1)
+        return to_return;
+
+    advance_cursor();
+    can_erase = true;
+
+    return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::Iterator::operator == (const OpenHashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
+    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+    if (rhsASI == 0)
+        throw IteratorTypeError("OpenHashMap::Iterator::operator ==");
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::operator ==");
+    if (ref_map != rhsASI->ref_map)
+        throw ComparingDifferentIteratorsError("OpenHashMap::Iterator::operator ==");
+
+    return current == rhsASI->current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool OpenHashMap<KEY,T,thash,HASH>::Iterator::operator != (const OpenHashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
+    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+    if (rhsASI == 0)
+        throw IteratorTypeError("OpenHashMap::Iterator::operator !=");
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::operator !=");
+    if (ref_map != rhsASI->ref_map)
+        throw ComparingDifferentIteratorsError("OpenHashMap::Iterator::operator !=");
+
+    return current != rhsASI->current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+pair<KEY,T>& OpenHashMap<KEY,T,thash,HASH>::Iterator::operator *() const {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::operator *");
+    if (!can_erase || current == -1)
+        throw IteratorPositionIllegal("OpenHashMap::Iterator::operator * Iterator illegal:");
+
+    return ref_map->slots[current];
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+pair<KEY,T>* OpenHashMap<KEY,T,thash,HASH>::Iterator::operator ->() const {
+    if (expected_mod_count != ref_map->mod_count)
+        throw ConcurrentModificationError("OpenHashMap::Iterator::operator ->");
+    if (!can_erase || current == -1)
+        throw IteratorPositionIllegal("OpenHashMap::Iterator::operator -> Iterator illegal:");
+
+    return &(ref_map->slots[current]);
+}
+
+}
+
+#endif /* OPEN_HASH_MAP_HPP_ */
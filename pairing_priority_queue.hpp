@@ -0,0 +1,772 @@
+#ifndef PAIRING_PRIORITY_QUEUE_HPP_
+#define PAIRING_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <algorithm>            //std::push_heap, std::pop_heap
+#include <vector>               //Iterator's frontier; copy_tree's work list
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
+#include "ics_exceptions.hpp"
+#include "node_pool.hpp"        //Node allocation
+#include "array_stack.hpp"      //See operator <<
+
+
+namespace ics {
+
+
+#ifndef undefinedgtdefined
+#define undefinedgtdefined
+template<class T>
+bool undefinedgt (const T& a, const T& b) {return false;}
+#endif /* undefinedgtdefined */
+
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
+//Alternatively, leave tgt defaulted and supply a stateless functor type GT (e.g., std::greater<T>, or a
+//  lambda's type in C++20): GT()(...) is then called directly, so it can be inlined (as is a
+//  tgt template argument); only a cgt supplied at run time is called through the pointer gt.
+//Supplying both tgt and GT is a compile-time error.
+//A pairing heap: a tree in which every node has at least the priority of its children. enqueue
+//  and merge (of a queue moved in) link two trees under the higher root: O(1). dequeue removes
+//  the root and pairs up its children, left to right, then links the pairs right to left:
+//  amortized O(log N).
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>, class GT = undefinedfunctor> class PairingPriorityQueue {
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    //Destructor/Constructors
+    ~PairingPriorityQueue();
+
+    PairingPriorityQueue          (bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    PairingPriorityQueue          (const PairingPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    PairingPriorityQueue          (PairingPriorityQueue<T,tgt,GT>&& to_move);   //O(1): takes to_move's tree, leaving it empty
+    explicit PairingPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit PairingPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    int  enqueue (T&& element);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+    //Enqueues T(args...), constructed directly in its node
+    template <class... Args>
+    int emplace (Args&&... args);
+
+    //Adds all of other's values (using this queue's gt); returns how many
+    int merge (const PairingPriorityQueue<T,tgt,GT>& other);   //O(M): copies other's tree
+    int merge (PairingPriorityQueue<T,tgt,GT>&& other);        //O(1): takes other's tree, leaving it empty
+
+
+    //Operators
+    PairingPriorityQueue<T,tgt,GT>& operator = (const PairingPriorityQueue<T,tgt,GT>& rhs);
+    PairingPriorityQueue<T,tgt,GT>& operator = (PairingPriorityQueue<T,tgt,GT>&& rhs);   //O(1): swaps trees with rhs
+    bool operator == (const PairingPriorityQueue<T,tgt,GT>& rhs) const;
+    bool operator != (const PairingPriorityQueue<T,tgt,GT>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class GT2>
+    friend std::ostream& operator << (std::ostream& outs, const PairingPriorityQueue<T2,gt2,GT2>& pq);
+
+
+
+  private:
+    class PN;
+
+  public:
+    //Iterator yields the values in priority order without changing the tree: it keeps a heap of
+    //  the nodes not yet yielded whose parents have been (its frontier). erase replaces the
+    //  current node by the pairing of its children: amortized O(log N).
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of PairingPriorityQueue<T,tgt,GT>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        PairingPriorityQueue<T,tgt,GT>::Iterator& operator ++ ();
+        PairingPriorityQueue<T,tgt,GT>::Iterator  operator ++ (int);
+        bool operator == (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
+        bool operator != (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const PairingPriorityQueue<T,tgt,GT>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator PairingPriorityQueue<T,tgt,GT>::begin () const;
+        friend Iterator PairingPriorityQueue<T,tgt,GT>::end   () const;
+
+      private:
+        //If can_erase is false, the value has been removed from ref_pq (++ does nothing);
+        //  either way the highest node in frontier is the next value to yield
+        std::vector<PN*>                frontier;      //Heap of nodes, by their values
+        PairingPriorityQueue<T,tgt,GT>* ref_pq;
+        int                             expected_mod_count;
+        bool                            can_erase = true;
+
+        struct Lower {                                 //Orders frontier for std::push_heap/pop_heap
+          PairingPriorityQueue<T,tgt,GT>* q;
+          bool operator () (PN* a, PN* b) const {return q->higher(b->value,a->value);}
+        };
+        void advance ();                               //Replace frontier's highest node by its children
+
+        //Called in friends begin/end
+        Iterator(PairingPriorityQueue<T,tgt,GT>* iterate_over, PN* initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class PN {
+      public:
+        PN ()                      {}
+        PN (const T& v)            : value(v) {}
+        PN (T&& v)                 : value(std::move(v)) {}
+        template <class... Args>
+        explicit PN (PN* ignored, Args&&... args) : value(std::forward<Args>(args)...) {}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(PN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(PN)>::deallocate(p);}
+
+        T   value;
+        PN* child = nullptr;             //Leftmost child
+        PN* next  = nullptr;             //Right sibling
+        PN* prev  = nullptr;             //Left sibling, or parent if this is the leftmost child
+    };
+
+
+    bool (*gt) (const T& a, const T& b); //The gt used by enqueue (from template or constructor)
+    PN* root      = nullptr;
+    int used      = 0;                   //Cache the number of values in the tree
+    int mod_count = 0;                   //For sensing concurrent modification
+
+    static_assert(std::is_same<GT,undefinedfunctor>::value || tgt == (gtfunc)undefinedgt<T>,
+                  "PairingPriorityQueue: supply tgt or GT, not both");
+    static gtfunc template_gt ();                      //functor_gt if GT is supplied, else tgt (undefinedgt if neither)
+    static bool functor_gt  (const T& a, const T& b);
+    bool higher (const T& a, const T& b) const;   //gt(a,b), called directly when tgt/GT fixes it at compile time
+
+    //Helper methods
+    int  add_node         (PN* to_add);           //Link to_add (a single node) with root, and count it
+    PN*  link             (PN* a, PN* b);         //Make the lower of roots a/b the leftmost child of the other; returns it
+    PN*  combine_siblings (PN* first);            //Two-pass pairing of first and its right siblings; returns one root
+    void delete_tree      (PN* first);            //Deallocate first, its right siblings, and all their descendants
+    PN*  copy_tree        (PN* source) const;     //Copy source (a root) and its descendants
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//PairingPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::~PairingPriorityQueue() {
+    delete_tree(root);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(bool (*cgt)(const T& a, const T& b))
+    :gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
+{
+    if (gt == (gtfunc)undefinedgt<T>)
+        throw TemplateFunctionError("PairingPriorityQueue::default constructor: neither specified");
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("PairingPriorityQueue::default constructor: both specified and different");
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(const PairingPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b))
+    :gt(cgt != (gtfunc)undefinedgt<T> ? cgt : to_copy.gt)
+{
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("PairingPriorityQueue::copy constructor: both specified and different");
+
+    if (gt == to_copy.gt) {
+        root = copy_tree(to_copy.root);
+        used = to_copy.used;
+    }else
+        for (const T& v : to_copy)
+            enqueue(v);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(PairingPriorityQueue<T,tgt,GT>&& to_move)
+    :gt(to_move.gt), root(to_move.root), used(to_move.used)
+{
+    to_move.root = nullptr;
+    to_move.used = 0;
+    ++to_move.mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+    :gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
+{
+    if (gt == (gtfunc)undefinedgt<T>)
+        throw TemplateFunctionError("PairingPriorityQueue::initializer_list constructor: neither specified");
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("PairingPriorityQueue::initializer_list constructor: both specified and different");
+
+    enqueue_all(il);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+template<class Iterable>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+    :gt(template_gt() != (gtfunc)undefinedgt<T> ? template_gt() : cgt)
+{
+    if (gt == (gtfunc)undefinedgt<T>)
+        throw TemplateFunctionError("PairingPriorityQueue::Iterable constructor: neither specified");
+    if (template_gt() != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && template_gt() != cgt)
+        throw TemplateFunctionError("PairingPriorityQueue::Iterable constructor: both specified and different");
+
+    enqueue_all(i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::empty() const {
+    return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::size() const {
+    return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& PairingPriorityQueue<T,tgt,GT>::peek () const {
+    if (empty())
+        throw EmptyError("PairingPriorityQueue::peek");
+    return root->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string PairingPriorityQueue<T,tgt,GT>::str() const {
+    std::ostringstream answer;
+    answer << "PairingPriorityQueue[";
+    if (root != nullptr) {
+        answer << "root:" << root->value << ",children:";
+        for (PN* c = root->child; c != nullptr; c = c->next)
+            answer << (c == root->child ? "" : ",") << c->value;
+    }
+    answer << "](used=" << used << ",mod_count=" << mod_count << ")";
+    return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::enqueue(const T& element) {
+    return add_node(new PN(element));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::enqueue(T&& element) {
+    return add_node(new PN(std::move(element)));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T PairingPriorityQueue<T,tgt,GT>::dequeue() {
+    if (empty())
+        throw EmptyError("PairingPriorityQueue::dequeue");
+
+    PN* to_delete = root;
+    T value = std::move(to_delete->value);
+    root = combine_siblings(to_delete->child);
+    delete to_delete;
+    --used;
+    ++mod_count;
+    return value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void PairingPriorityQueue<T,tgt,GT>::clear() {
+    delete_tree(root);
+    root = nullptr;
+    used = 0;
+    ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+template <class Iterable>
+int PairingPriorityQueue<T,tgt,GT>::enqueue_all (const Iterable& i) {
+    int count = 0;
+    for (const T& v : i)
+        count += enqueue(v);
+    return count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+template <class... Args>
+int PairingPriorityQueue<T,tgt,GT>::emplace (Args&&... args) {
+    return add_node(new PN(nullptr, std::forward<Args>(args)...));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::merge (const PairingPriorityQueue<T,tgt,GT>& other) {
+    int count = other.used;   //other may be *this
+    if (count == 0)
+        return 0;
+    root = link(root, copy_tree(other.root));
+    used += count;
+    ++mod_count;
+    return count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::merge (PairingPriorityQueue<T,tgt,GT>&& other) {
+    if (this == &other)
+        return merge(static_cast<const PairingPriorityQueue<T,tgt,GT>&>(other));
+    int count = other.used;
+    if (count == 0)
+        return 0;
+    root = link(root, other.root);
+    used += count;
+    other.root = nullptr;
+    other.used = 0;
+    ++mod_count;
+    ++other.mod_count;
+    return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>& PairingPriorityQueue<T,tgt,GT>::operator = (const PairingPriorityQueue<T,tgt,GT>& rhs) {
+    if (this == &rhs)
+        return *this;
+    clear();
+    gt   = rhs.gt;
+    root = copy_tree(rhs.root);
+    used = rhs.used;
+    return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>& PairingPriorityQueue<T,tgt,GT>::operator = (PairingPriorityQueue<T,tgt,GT>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(gt,   rhs.gt);
+    std::swap(root, rhs.root);
+    std::swap(used, rhs.used);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::operator == (const PairingPriorityQueue<T,tgt,GT>& rhs) const {
+    if (this == &rhs)
+        return true;
+    if ((void*)gt != (void*)rhs.gt)
+        return false;
+    if (used != rhs.used)
+        return false;
+    Iterator r = rhs.begin();
+    for (Iterator l = begin(); l != end(); ++l, ++r)
+        if (!(*l == *r))
+            return false;
+    return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::operator != (const PairingPriorityQueue<T,tgt,GT>& rhs) const {
+    return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::ostream& operator << (std::ostream& outs, const PairingPriorityQueue<T,tgt,GT>& pq) {
+    outs << "priority_queue[";
+    if (!pq.empty()) {
+        ArrayStack<T> reversed;
+        for (const T& v : pq)
+            reversed.push(v);
+
+        outs << reversed.pop();
+        while (!reversed.empty())
+            outs << "," << reversed.pop();
+    }
+    outs << "]:highest";
+    return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::begin () const -> PairingPriorityQueue<T,tgt,GT>::Iterator {
+    return Iterator(const_cast<PairingPriorityQueue<T,tgt,GT>*>(this), root);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::end () const -> PairingPriorityQueue<T,tgt,GT>::Iterator {
+    return Iterator(const_cast<PairingPriorityQueue<T,tgt,GT>*>(this), nullptr);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+typename PairingPriorityQueue<T,tgt,GT>::gtfunc PairingPriorityQueue<T,tgt,GT>::template_gt () {
+    return !std::is_same<GT,undefinedfunctor>::value ? functor_gt : tgt;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::functor_gt (const T& a, const T& b) {
+    return GT()(a,b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::higher (const T& a, const T& b) const {
+    if (!std::is_same<GT,undefinedfunctor>::value)
+        return GT()(a,b);
+    if (tgt != (gtfunc)undefinedgt<T>)
+        return tgt(a,b);
+    return gt(a,b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::add_node(PN* to_add) {
+    root = link(root, to_add);
+    ++used;
+    ++mod_count;
+    return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::link(PN* a, PN* b) -> PN* {
+    if (a == nullptr)
+        return b;
+    if (b == nullptr)
+        return a;
+    if (higher(b->value,a->value))     //On ties a stays the root
+        std::swap(a,b);
+    b->prev = a;
+    b->next = a->child;
+    if (a->child != nullptr)
+        a->child->prev = b;
+    a->child = b;
+    return a;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::combine_siblings(PN* first) -> PN* {
+    if (first == nullptr)
+        return nullptr;
+
+    //First pass (left to right): link siblings in pairs, stacking the results (via next)
+    PN* pairs = nullptr;
+    while (first != nullptr) {
+        PN* a = first;
+        PN* b = a->next;
+        first = (b == nullptr ? nullptr : b->next);
+        a->prev = a->next = nullptr;
+        if (b != nullptr)
+            b->prev = b->next = nullptr;
+        PN* linked = link(a,b);
+        linked->next = pairs;
+        pairs = linked;
+    }
+
+    //Second pass (right to left, popping the stack): link each pair into the result
+    PN* result = pairs;
+    pairs = pairs->next;
+    result->next = nullptr;
+    while (pairs != nullptr) {
+        PN* next_pair = pairs->next;
+        pairs->next = nullptr;
+        result = link(result, pairs);
+        pairs = next_pair;
+    }
+    result->prev = nullptr;
+    return result;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void PairingPriorityQueue<T,tgt,GT>::delete_tree(PN* first) {
+    //Splice each node's children in after it, so the whole tree becomes one sibling list
+    while (first != nullptr) {
+        if (first->child != nullptr) {
+            PN* last = first->child;
+            while (last->next != nullptr)
+                last = last->next;
+            last->next  = first->next;
+            first->next = first->child;
+        }
+        PN* to_delete = first;
+        first = first->next;
+        delete to_delete;
+    }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::copy_tree(PN* source) const -> PN* {
+    if (source == nullptr)
+        return nullptr;
+    PN* answer = new PN(source->value);
+    std::vector<std::pair<PN*,PN*>> to_copy{{source,answer}};   //(original, copy) whose children are not copied
+    while (!to_copy.empty()) {
+        PN* from = to_copy.back().first;
+        PN* to   = to_copy.back().second;
+        to_copy.pop_back();
+        PN* last = nullptr;
+        for (PN* c = from->child; c != nullptr; c = c->next) {
+            PN* copy = new PN(c->value);
+            if (last == nullptr) {
+                to->child  = copy;
+                copy->prev = to;
+            }else {
+                last->next = copy;
+                copy->prev = last;
+            }
+            last = copy;
+            to_copy.push_back(std::make_pair(c,copy));
+        }
+    }
+    return answer;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::Iterator::Iterator(PairingPriorityQueue<T,tgt,GT>* iterate_over, PN* initial)
+    :ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count)
+{
+    if (initial != nullptr)
+        frontier.push_back(initial);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::Iterator::~Iterator()
+{}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T PairingPriorityQueue<T,tgt,GT>::Iterator::erase() {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("PairingPriorityQueue::Iterator::erase");
+    if (!can_erase)
+        throw CannotEraseError("PairingPriorityQueue::Iterator::erase Iterator cursor already erased");
+    if (frontier.empty())
+        throw CannotEraseError("PairingPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+    can_erase = false;
+    PN* to_delete = frontier.front();
+    std::pop_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+    frontier.pop_back();
+
+    //The pairing of to_delete's children (none yet yielded) takes its place: they have no higher
+    //  priority than to_delete, so no more than its parent
+    PN* replacement = ref_pq->combine_siblings(to_delete->child);
+    PN* prev = to_delete->prev;
+    PN* next = to_delete->next;
+    if (replacement != nullptr) {
+        replacement->prev = prev;
+        replacement->next = next;
+        if (next != nullptr)
+            next->prev = replacement;
+        frontier.push_back(replacement);
+        std::push_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+    }else if (next != nullptr)
+        next->prev = prev;
+    PN* in_place = (replacement != nullptr ? replacement : next);
+    if (prev == nullptr)
+        ref_pq->root = in_place;
+    else if (prev->child == to_delete)
+        prev->child = in_place;
+    else
+        prev->next = in_place;
+
+    T to_return = std::move(to_delete->value);
+    delete to_delete;
+    --ref_pq->used;
+    ++ref_pq->mod_count;
+
+    expected_mod_count = ref_pq->mod_count;
+    return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string PairingPriorityQueue<T,tgt,GT>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_pq->str() << "/frontier size=" << frontier.size()
+           << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+    return answer.str();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::Iterator::operator ++ () -> PairingPriorityQueue<T,tgt,GT>::Iterator& {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ++");
+
+    if (frontier.empty())
+        return *this;
+    if (can_erase)
+        advance();
+    else
+        can_erase = true;
+    return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::Iterator::operator ++ (int) -> PairingPriorityQueue<T,tgt,GT>::Iterator {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ++(int)");
+
+    if (frontier.empty())
+        return *this;
+    Iterator to_return(*this);
+    if (can_erase)
+        advance();
+    else
+        can_erase = true;
+    return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::Iterator::operator == (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
+    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+    if (rhsASI == 0)
+        throw IteratorTypeError("PairingPriorityQueue::Iterator::operator ==");
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ==");
+    if (ref_pq != rhsASI->ref_pq)
+        throw ComparingDifferentIteratorsError("PairingPriorityQueue::Iterator::operator ==");
+
+    if (frontier.empty() || rhsASI->frontier.empty())
+        return frontier.empty() == rhsASI->frontier.empty();
+    return frontier.front() == rhsASI->frontier.front();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::Iterator::operator != (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
+    return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& PairingPriorityQueue<T,tgt,GT>::Iterator::operator *() const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator *");
+    if (!can_erase || frontier.empty())
+        throw IteratorPositionIllegal("PairingPriorityQueue::Iterator::operator * Iterator illegal: ");
+    return frontier.front()->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T* PairingPriorityQueue<T,tgt,GT>::Iterator::operator ->() const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ->");
+    if (!can_erase || frontier.empty())
+        throw IteratorPositionIllegal("PairingPriorityQueue::Iterator::operator -> Iterator illegal: ");
+    return &frontier.front()->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void PairingPriorityQueue<T,tgt,GT>::Iterator::advance() {
+    PN* n = frontier.front();
+    std::pop_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+    frontier.pop_back();
+    for (PN* c = n->child; c != nullptr; c = c->next) {
+        frontier.push_back(c);
+        std::push_heap(frontier.begin(), frontier.end(), Lower{ref_pq});
+    }
+}
+
+
+}
+
+#endif /* PAIRING_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,726 @@
+#ifndef RADIX_PRIORITY_QUEUE_HPP_
+#define RADIX_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <algorithm>            //std::stable_sort
+#include <vector>               //Buckets; Iterator's run of entries
+#include <type_traits>          //std::is_same
+#include <utility>              //std::move, std::forward, std::swap
+#include "ics_exceptions.hpp"
+#include "node_pool.hpp"        //Node allocation
+#include "array_stack.hpp"      //See operator <<
+
+
+namespace ics {
+
+
+#ifndef undefinedkeydefined
+#define undefinedkeydefined
+template<class T>
+unsigned long long undefinedkey (const T& a) {return 0;}
+#endif /* undefinedkeydefined */
+
+#ifndef undefinedfunctordefined
+#define undefinedfunctordefined
+//Default for the functor template parameters (GT/LT/HASH): none was supplied, so the
+//  function-pointer template parameter (or constructor argument) is used instead
+struct undefinedfunctor {
+  template<class... Args>
+  int operator () (const Args&...) const {return 0;}
+};
+#endif /* undefinedfunctordefined */
+
+//Instantiate the templated class supplying tkey(a): a's priority as an unsigned integer; the
+//  SMALLER the key, the HIGHER the priority (e.g., a distance in Dijkstra, a deadline in a timer).
+//If tkey is defaulted to undefinedkey in the template, then a constructor must supply ckey.
+//If both tkey and ckey are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedkey value supplied by tkey/ckey is stored in the instance variable key.
+//Alternatively, leave tkey defaulted and supply a stateless functor type KEY: KEY()(...) is then
+//  called directly, so it can be inlined (as is a tkey template argument).
+//Supplying both tkey and KEY is a compile-time error.
+//A radix heap: the queue must be monotone, so enqueue throws KeyError for a key smaller than the
+//  key last dequeued. A value whose key first differs from the last dequeued key in bit b-1 is
+//  kept in bucket b (bucket 0 holds keys equal to it), so lower buckets hold higher priorities.
+//  Buckets hold (key,node) entries; when bucket 0 empties, dequeue finds the smallest key in the
+//  next non-empty bucket and moves that bucket's entries into lower buckets (the nodes, and so
+//  the values, never move). An entry moves down at most 64 times, so enqueue is O(1) and dequeue
+//  is amortized O(log C) for keys spanning a range of C.
+template<class T, unsigned long long (*tkey)(const T& a) = undefinedkey<T>, class KEY = undefinedfunctor> class RadixPriorityQueue {
+  public:
+    typedef unsigned long long (*keyfunc) (const T& a);
+
+    //Destructor/Constructors
+    ~RadixPriorityQueue();
+
+    RadixPriorityQueue          (unsigned long long (*ckey)(const T& a) = undefinedkey<T>);
+    RadixPriorityQueue          (const RadixPriorityQueue<T,tkey,KEY>& to_copy, unsigned long long (*ckey)(const T& a) = undefinedkey<T>);
+    RadixPriorityQueue          (RadixPriorityQueue<T,tkey,KEY>&& to_move);   //O(1): takes to_move's buckets, leaving it empty
+    explicit RadixPriorityQueue (const std::initializer_list<T>& il, unsigned long long (*ckey)(const T& a) = undefinedkey<T>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit RadixPriorityQueue (const Iterable& i, unsigned long long (*ckey)(const T& a) = undefinedkey<T>);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    int  enqueue (T&& element);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+    //Enqueues T(args...), constructed directly in its node
+    template <class... Args>
+    int emplace (Args&&... args);
+
+
+    //Operators
+    RadixPriorityQueue<T,tkey,KEY>& operator = (const RadixPriorityQueue<T,tkey,KEY>& rhs);
+    RadixPriorityQueue<T,tkey,KEY>& operator = (RadixPriorityQueue<T,tkey,KEY>&& rhs);   //O(1): swaps buckets with rhs
+    bool operator == (const RadixPriorityQueue<T,tkey,KEY>& rhs) const;
+    bool operator != (const RadixPriorityQueue<T,tkey,KEY>& rhs) const;
+
+    template<class T2, unsigned long long (*key2)(const T2& a), class KEY2>
+    friend std::ostream& operator << (std::ostream& outs, const RadixPriorityQueue<T2,key2,KEY2>& pq);
+
+
+
+  private:
+    class LN;
+    typedef std::pair<unsigned long long,LN*> Entry;   //(key, node): a bucket's entries
+
+  public:
+    //Iterator yields the values in priority order without changing the buckets: it visits them
+    //  in order, sorting each one's entries by key (stably) when it reaches it. erase is O(size
+    //  of the current bucket).
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of RadixPriorityQueue<T,tkey,KEY>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        RadixPriorityQueue<T,tkey,KEY>::Iterator& operator ++ ();
+        RadixPriorityQueue<T,tkey,KEY>::Iterator  operator ++ (int);
+        bool operator == (const RadixPriorityQueue<T,tkey,KEY>::Iterator& rhs) const;
+        bool operator != (const RadixPriorityQueue<T,tkey,KEY>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const RadixPriorityQueue<T,tkey,KEY>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator RadixPriorityQueue<T,tkey,KEY>::begin () const;
+        friend Iterator RadixPriorityQueue<T,tkey,KEY>::end   () const;
+
+      private:
+        //If can_erase is false, run[current] has been removed from ref_pq (++ moves past it)
+        std::vector<Entry>              run;           //Entries of bucket[b], by key
+        int                             b;             //bucket_count at the end
+        int                             current;       //Index in run
+        RadixPriorityQueue<T,tkey,KEY>* ref_pq;
+        int                             expected_mod_count;
+        bool                            can_erase = true;
+
+        void load (int from);                          //Sort the first non-empty bucket >= from into run
+
+        //Called in friends begin/end
+        Iterator(RadixPriorityQueue<T,tkey,KEY>* iterate_over, int initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class LN {
+      public:
+        LN ()                      {}
+        LN (const T& v)            : value(v) {}
+        LN (T&& v)                 : value(std::move(v)) {}
+        template <class... Args>
+        explicit LN (LN* ignored, Args&&... args) : value(std::forward<Args>(args)...) {}
+        static void* operator new    (std::size_t)  {return NodePool<sizeof(LN)>::allocate();}
+        static void  operator delete (void* p)      {NodePool<sizeof(LN)>::deallocate(p);}
+
+        T                  value;
+        unsigned long long key;          //Cached key(value)
+    };
+
+    static const int bucket_count = 65;  //Bucket 0, and one for each bit in which a key may first differ from last
+
+    unsigned long long (*key) (const T& a);  //The key used by enqueue (from template or constructor)
+    std::vector<Entry> bucket[bucket_count];
+    unsigned long long last        = 0;      //Key last dequeued: every key in the queue is >= last
+    mutable LN*        min_cache   = nullptr;//Node with the smallest key when bucket[0] is empty (see peek)
+    int                used        = 0;      //Cache the number of values in the buckets
+    int                mod_count   = 0;      //For sensing concurrent modification
+
+    static_assert(std::is_same<KEY,undefinedfunctor>::value || tkey == (keyfunc)undefinedkey<T>,
+                  "RadixPriorityQueue: supply tkey or KEY, not both");
+    static keyfunc template_key ();                    //functor_key if KEY is supplied, else tkey (undefinedkey if neither)
+    static unsigned long long functor_key  (const T& a);
+    unsigned long long key_of (const T& a) const; //key(a), called directly when tkey/KEY fixes it at compile time
+
+    //Helper methods
+    static int bucket_of (unsigned long long k, unsigned long long last);
+    int  add_node     (LN* to_add);           //Check and cache to_add's key, then add it to its bucket
+    void unlink       (LN* to_unlink);        //Remove to_unlink's entry from its bucket: O(size of the bucket)
+    LN*  smallest     () const;               //Node with the smallest key (last in bucket[0] if any)
+    void redistribute ();                     //bucket[0] is empty: make last the smallest key and empty its bucket
+    void copy_buckets (const RadixPriorityQueue<T,tkey,KEY>& source);
+    void delete_buckets ();
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//RadixPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::~RadixPriorityQueue() {
+    delete_buckets();
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::RadixPriorityQueue(unsigned long long (*ckey)(const T& a))
+    :key(template_key() != (keyfunc)undefinedkey<T> ? template_key() : ckey)
+{
+    if (key == (keyfunc)undefinedkey<T>)
+        throw TemplateFunctionError("RadixPriorityQueue::default constructor: neither specified");
+    if (template_key() != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && template_key() != ckey)
+        throw TemplateFunctionError("RadixPriorityQueue::default constructor: both specified and different");
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::RadixPriorityQueue(const RadixPriorityQueue<T,tkey,KEY>& to_copy, unsigned long long (*ckey)(const T& a))
+    :key(ckey != (keyfunc)undefinedkey<T> ? ckey : to_copy.key)
+{
+    if (template_key() != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && template_key() != ckey)
+        throw TemplateFunctionError("RadixPriorityQueue::copy constructor: both specified and different");
+
+    if (key == to_copy.key)
+        copy_buckets(to_copy);
+    else
+        for (const T& v : to_copy)
+            enqueue(v);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::RadixPriorityQueue(RadixPriorityQueue<T,tkey,KEY>&& to_move)
+    :key(to_move.key)
+{
+    *this = std::move(to_move);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::RadixPriorityQueue(const std::initializer_list<T>& il, unsigned long long (*ckey)(const T& a))
+    :key(template_key() != (keyfunc)undefinedkey<T> ? template_key() : ckey)
+{
+    if (key == (keyfunc)undefinedkey<T>)
+        throw TemplateFunctionError("RadixPriorityQueue::initializer_list constructor: neither specified");
+    if (template_key() != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && template_key() != ckey)
+        throw TemplateFunctionError("RadixPriorityQueue::initializer_list constructor: both specified and different");
+
+    enqueue_all(il);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+template<class Iterable>
+RadixPriorityQueue<T,tkey,KEY>::RadixPriorityQueue(const Iterable& i, unsigned long long (*ckey)(const T& a))
+    :key(template_key() != (keyfunc)undefinedkey<T> ? template_key() : ckey)
+{
+    if (key == (keyfunc)undefinedkey<T>)
+        throw TemplateFunctionError("RadixPriorityQueue::Iterable constructor: neither specified");
+    if (template_key() != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && template_key() != ckey)
+        throw TemplateFunctionError("RadixPriorityQueue::Iterable constructor: both specified and different");
+
+    enqueue_all(i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+bool RadixPriorityQueue<T,tkey,KEY>::empty() const {
+    return used == 0;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+int RadixPriorityQueue<T,tkey,KEY>::size() const {
+    return used;
+}
+
+
+//Finding the smallest key outside bucket[0] scans a bucket, so remember it until it changes
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+T& RadixPriorityQueue<T,tkey,KEY>::peek () const {
+    if (empty())
+        throw EmptyError("RadixPriorityQueue::peek");
+    return smallest()->value;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+std::string RadixPriorityQueue<T,tkey,KEY>::str() const {
+    std::ostringstream answer;
+    answer << "RadixPriorityQueue[";
+    bool first = true;
+    for (int b = 0; b < bucket_count; ++b)
+        if (!bucket[b].empty()) {
+            answer << (first ? "" : ",") << b << ":[";
+            first = false;
+            for (std::size_t i = 0; i < bucket[b].size(); ++i)
+                answer << (i == 0 ? "" : ",") << bucket[b][i].second->value << "(" << bucket[b][i].first << ")";
+            answer << "]";
+        }
+    answer << "](last=" << last << ",used=" << used << ",mod_count=" << mod_count << ")";
+    return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+int RadixPriorityQueue<T,tkey,KEY>::enqueue(const T& element) {
+    return add_node(new LN(element));
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+int RadixPriorityQueue<T,tkey,KEY>::enqueue(T&& element) {
+    return add_node(new LN(std::move(element)));
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+T RadixPriorityQueue<T,tkey,KEY>::dequeue() {
+    if (empty())
+        throw EmptyError("RadixPriorityQueue::dequeue");
+
+    if (bucket[0].empty())
+        redistribute();
+    LN* to_delete = bucket[0].back().second;
+    bucket[0].pop_back();
+    if (to_delete == min_cache)
+        min_cache = nullptr;
+    T value = std::move(to_delete->value);
+    delete to_delete;
+    --used;
+    ++mod_count;
+    return value;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+void RadixPriorityQueue<T,tkey,KEY>::clear() {
+    delete_buckets();
+    last = 0;
+    used = 0;
+    ++mod_count;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+template <class Iterable>
+int RadixPriorityQueue<T,tkey,KEY>::enqueue_all (const Iterable& i) {
+    int count = 0;
+    for (const T& v : i)
+        count += enqueue(v);
+    return count;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+template <class... Args>
+int RadixPriorityQueue<T,tkey,KEY>::emplace (Args&&... args) {
+    return add_node(new LN(nullptr, std::forward<Args>(args)...));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>& RadixPriorityQueue<T,tkey,KEY>::operator = (const RadixPriorityQueue<T,tkey,KEY>& rhs) {
+    if (this == &rhs)
+        return *this;
+    clear();
+    key = rhs.key;
+    copy_buckets(rhs);
+    return *this;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>& RadixPriorityQueue<T,tkey,KEY>::operator = (RadixPriorityQueue<T,tkey,KEY>&& rhs) {
+    if (this == &rhs)
+        return *this;
+    std::swap(key,  rhs.key);
+    for (int b = 0; b < bucket_count; ++b)
+        std::swap(bucket[b], rhs.bucket[b]);
+    std::swap(last,      rhs.last);
+    std::swap(min_cache, rhs.min_cache);
+    std::swap(used,      rhs.used);
+    ++mod_count;
+    ++rhs.mod_count;
+    return *this;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+bool RadixPriorityQueue<T,tkey,KEY>::operator == (const RadixPriorityQueue<T,tkey,KEY>& rhs) const {
+    if (this == &rhs)
+        return true;
+    if ((void*)key != (void*)rhs.key)
+        return false;
+    if (used != rhs.used)
+        return false;
+    Iterator r = rhs.begin();
+    for (Iterator l = begin(); l != end(); ++l, ++r)
+        if (!(*l == *r))
+            return false;
+    return true;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+bool RadixPriorityQueue<T,tkey,KEY>::operator != (const RadixPriorityQueue<T,tkey,KEY>& rhs) const {
+    return !(*this == rhs);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+std::ostream& operator << (std::ostream& outs, const RadixPriorityQueue<T,tkey,KEY>& pq) {
+    outs << "priority_queue[";
+    if (!pq.empty()) {
+        ArrayStack<T> reversed;
+        for (const T& v : pq)
+            reversed.push(v);
+
+        outs << reversed.pop();
+        while (!reversed.empty())
+            outs << "," << reversed.pop();
+    }
+    outs << "]:highest";
+    return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+auto RadixPriorityQueue<T,tkey,KEY>::begin () const -> RadixPriorityQueue<T,tkey,KEY>::Iterator {
+    return Iterator(const_cast<RadixPriorityQueue<T,tkey,KEY>*>(this), 0);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+auto RadixPriorityQueue<T,tkey,KEY>::end () const -> RadixPriorityQueue<T,tkey,KEY>::Iterator {
+    return Iterator(const_cast<RadixPriorityQueue<T,tkey,KEY>*>(this), bucket_count);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+typename RadixPriorityQueue<T,tkey,KEY>::keyfunc RadixPriorityQueue<T,tkey,KEY>::template_key () {
+    return !std::is_same<KEY,undefinedfunctor>::value ? functor_key : tkey;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+unsigned long long RadixPriorityQueue<T,tkey,KEY>::functor_key (const T& a) {
+    return KEY()(a);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+unsigned long long RadixPriorityQueue<T,tkey,KEY>::key_of (const T& a) const {
+    if (!std::is_same<KEY,undefinedfunctor>::value)
+        return KEY()(a);
+    if (tkey != (keyfunc)undefinedkey<T>)
+        return tkey(a);
+    return key(a);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+int RadixPriorityQueue<T,tkey,KEY>::bucket_of (unsigned long long k, unsigned long long last) {
+    if (k == last)
+        return 0;
+#if defined(__GNUC__) || defined(__clang__)
+    return 64 - __builtin_clzll(k ^ last);
+#else
+    unsigned long long differ = k ^ last;
+    int b = 0;
+    while (differ != 0) {
+        differ >>= 1;
+        ++b;
+    }
+    return b;
+#endif
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+int RadixPriorityQueue<T,tkey,KEY>::add_node(LN* to_add) {
+    to_add->key = key_of(to_add->value);
+    if (to_add->key < last) {
+        std::ostringstream answer;
+        answer << "RadixPriorityQueue::enqueue: key(" << to_add->key << ") below last dequeued key(" << last << ")";
+        delete to_add;
+        throw KeyError(answer.str());
+    }
+    bucket[bucket_of(to_add->key,last)].push_back(Entry(to_add->key,to_add));
+    if (min_cache != nullptr && to_add->key < min_cache->key)
+        min_cache = to_add;
+    ++used;
+    ++mod_count;
+    return 1;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+void RadixPriorityQueue<T,tkey,KEY>::unlink(LN* to_unlink) {
+    std::vector<Entry>& in = bucket[bucket_of(to_unlink->key,last)];
+    int i = 0;
+    while (in[i].second != to_unlink)
+        ++i;
+    in[i] = in.back();
+    in.pop_back();
+    if (to_unlink == min_cache)
+        min_cache = nullptr;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+auto RadixPriorityQueue<T,tkey,KEY>::smallest() const -> LN* {
+    if (!bucket[0].empty())
+        return bucket[0].back().second;
+    if (min_cache == nullptr) {
+        int b = 1;
+        while (bucket[b].empty())
+            ++b;
+        const Entry* min = &bucket[b][0];
+        for (const Entry& e : bucket[b])
+            if (e.first < min->first)
+                min = &e;
+        min_cache = min->second;
+    }
+    return min_cache;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+void RadixPriorityQueue<T,tkey,KEY>::redistribute() {
+    int b = bucket_of(smallest()->key,last);   //The first non-empty bucket
+    last = min_cache->key;
+    min_cache = nullptr;
+
+    //Every key in bucket[b] now first differs from last in a lower bit (or not at all)
+    std::vector<Entry> to_move;
+    to_move.swap(bucket[b]);
+    for (const Entry& e : to_move)
+        bucket[bucket_of(e.first,last)].push_back(e);
+    to_move.clear();
+    bucket[b].swap(to_move);                   //Keep its capacity
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+void RadixPriorityQueue<T,tkey,KEY>::copy_buckets(const RadixPriorityQueue<T,tkey,KEY>& source) {
+    last = source.last;
+    for (int b = 0; b < bucket_count; ++b) {
+        bucket[b].reserve(source.bucket[b].size());
+        for (const Entry& e : source.bucket[b]) {
+            LN* copy = new LN(e.second->value);
+            copy->key = e.first;
+            bucket[b].push_back(Entry(e.first,copy));
+        }
+    }
+    used = source.used;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+void RadixPriorityQueue<T,tkey,KEY>::delete_buckets() {
+    for (int b = 0; b < bucket_count; ++b) {
+        for (const Entry& e : bucket[b])
+            delete e.second;
+        bucket[b].clear();
+    }
+    min_cache = nullptr;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::Iterator::Iterator(RadixPriorityQueue<T,tkey,KEY>* iterate_over, int initial)
+    :b(initial), current(0), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count)
+{
+    load(initial);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+RadixPriorityQueue<T,tkey,KEY>::Iterator::~Iterator()
+{}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+T RadixPriorityQueue<T,tkey,KEY>::Iterator::erase() {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("RadixPriorityQueue::Iterator::erase");
+    if (!can_erase)
+        throw CannotEraseError("RadixPriorityQueue::Iterator::erase Iterator cursor already erased");
+    if (b == bucket_count)
+        throw CannotEraseError("RadixPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+    can_erase = false;
+    LN* to_delete = run[current].second;
+    ref_pq->unlink(to_delete);
+    T to_return = std::move(to_delete->value);
+    delete to_delete;
+    --ref_pq->used;
+    ++ref_pq->mod_count;
+
+    expected_mod_count = ref_pq->mod_count;
+    return to_return;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+std::string RadixPriorityQueue<T,tkey,KEY>::Iterator::str() const {
+    std::ostringstream answer;
+    answer << ref_pq->str() << "/bucket=" << b << "/current=" << current << "/run size=" << run.size()
+           << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+    return answer.str();
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+auto RadixPriorityQueue<T,tkey,KEY>::Iterator::operator ++ () -> RadixPriorityQueue<T,tkey,KEY>::Iterator& {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("RadixPriorityQueue::Iterator::operator ++");
+
+    if (b == bucket_count)
+        return *this;
+    can_erase = true;
+    if (++current == (int)run.size())
+        load(b+1);
+    return *this;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+auto RadixPriorityQueue<T,tkey,KEY>::Iterator::operator ++ (int) -> RadixPriorityQueue<T,tkey,KEY>::Iterator {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("RadixPriorityQueue::Iterator::operator ++(int)");
+
+    if (b == bucket_count)
+        return *this;
+    Iterator to_return(*this);
+    can_erase = true;
+    if (++current == (int)run.size())
+        load(b+1);
+    return to_return;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+bool RadixPriorityQueue<T,tkey,KEY>::Iterator::operator == (const RadixPriorityQueue<T,tkey,KEY>::Iterator& rhs) const {
+    const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+    if (rhsASI == 0)
+        throw IteratorTypeError("RadixPriorityQueue::Iterator::operator ==");
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("RadixPriorityQueue::Iterator::operator ==");
+    if (ref_pq != rhsASI->ref_pq)
+        throw ComparingDifferentIteratorsError("RadixPriorityQueue::Iterator::operator ==");
+
+    return b == rhsASI->b && current == rhsASI->current;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+bool RadixPriorityQueue<T,tkey,KEY>::Iterator::operator != (const RadixPriorityQueue<T,tkey,KEY>::Iterator& rhs) const {
+    return !(*this == rhs);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+T& RadixPriorityQueue<T,tkey,KEY>::Iterator::operator *() const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("RadixPriorityQueue::Iterator::operator *");
+    if (!can_erase || b == bucket_count)
+        throw IteratorPositionIllegal("RadixPriorityQueue::Iterator::operator * Iterator illegal: ");
+    return run[current].second->value;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+T* RadixPriorityQueue<T,tkey,KEY>::Iterator::operator ->() const {
+    if (expected_mod_count != ref_pq->mod_count)
+        throw ConcurrentModificationError("RadixPriorityQueue::Iterator::operator ->");
+    if (!can_erase || b == bucket_count)
+        throw IteratorPositionIllegal("RadixPriorityQueue::Iterator::operator -> Iterator illegal: ");
+    return &run[current].second->value;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEY>
+void RadixPriorityQueue<T,tkey,KEY>::Iterator::load(int from) {
+    run.clear();
+    current = 0;
+    for (b = from; b < bucket_count && ref_pq->bucket[b].empty(); ++b)
+        ;
+    if (b == bucket_count)
+        return;
+    run = ref_pq->bucket[b];
+    std::stable_sort(run.begin(), run.end(), [] (const Entry& x, const Entry& y) {return x.first < y.first;});
+}
+
+
+}
+
+#endif /* RADIX_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,411 @@
+#include <pthread.h>
+#include <cmath>
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+#include <functional>
+#include "gtest/gtest.h"
+#include "bst_map.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+typedef ics::BSTMap<int,int,lt_int> IntMap;
+
+
+static std::vector<int> keys_in(const IntMap::Range& r) {
+  std::vector<int> keys;
+  for (const IntMap::Entry& e : r)
+    keys.push_back(e.first);
+  return keys;
+}
+
+
+TEST(BSTMap, range) {
+  IntMap m;
+  for (int i = 0; i < 10; ++i)
+    m.put(2*i, i);
+  ASSERT_EQ(std::vector<int>({4,6,8}), keys_in(m.range(3,10)));
+  ASSERT_EQ(std::vector<int>({}),      keys_in(m.range(5,5)));
+  ASSERT_EQ(std::vector<int>({}),      keys_in(m.range(10,3)));
+  ASSERT_EQ(std::vector<int>({}),      keys_in(m.range(100,3)));
+}
+
+
+//Yields the Entries "k00","k01",... (or in reverse order) by value, one temporary at a time
+class Generated {
+  public:
+    typedef ics::pair<std::string,int> Entry;
+    class Iterator {
+      public:
+        Iterator(int i, int n, bool reversed) : i(i), n(n), reversed(reversed) {}
+        Entry     operator *  () const {int k = reversed ? n-1-i : i; return Entry(std::string("k") + char('0'+k/10) + char('0'+k%10), k);}
+        Iterator& operator ++ ()       {++i; return *this;}
+        bool      operator != (const Iterator& rhs) const {return i != rhs.i;}
+      private:
+        int i, n;
+        bool reversed;
+    };
+    Generated(int n, bool reversed) : n(n), reversed(reversed) {}
+    Iterator begin () const {return Iterator(0,n,reversed);}
+    Iterator end   () const {return Iterator(n,n,reversed);}
+  private:
+    int n;
+    bool reversed;
+};
+
+static int comparisons = 0;
+bool lt_string(const std::string& a, const std::string& b) {++comparisons; return a < b;}
+
+
+TEST(BSTMap, put_all_sorted_from_by_value_iterable) {
+  for (bool reversed : {false, true}) {
+    ics::BSTMap<std::string,int,lt_string> m;
+    comparisons = 0;
+    ASSERT_EQ(50, m.put_all_sorted(Generated(50,reversed)));
+    ASSERT_EQ(50, m.size());
+    if (!reversed)
+      ASSERT_LT(comparisons, 2*50);   //Checked and built in O(N), not put one at a time
+    int k = 0;
+    for (const auto& e : m) {
+      ASSERT_EQ(k, e.second);
+      ++k;
+    }
+  }
+}
+
+
+TEST(BSTMap, functor_lt) {
+  ics::BSTMap<int,int,ics::undefinedlt<int>,true,true,std::less<int>> functor;
+  IntMap                                                            templated;
+  for (int i = 0; i < 5000; ++i) {
+    functor.put(i*7919%3000, i);
+    templated.put(i*7919%3000, i);
+  }
+  ASSERT_EQ(templated.size(), functor.size());
+  auto t = templated.begin();
+  for (const auto& e : functor) {
+    ASSERT_EQ(t->first,  e.first);
+    ASSERT_EQ(t->second, e.second);
+    ++t;
+  }
+  ASSERT_EQ(1500, functor.lower_bound(1500)->first);
+  ASSERT_EQ(1500, functor.rank(1500));
+}
+
+
+static int int_comparisons = 0;
+bool counted_lt_int(const int& a, const int& b) {++int_comparisons; return a < b;}
+
+//has_key makes one comparison per node above key's, so the deepest key gives the tree's height
+template<class Map>
+static int height_of(const Map& m, const std::vector<int>& keys) {
+  int height = 0;
+  for (int k : keys) {
+    int_comparisons = 0;
+    EXPECT_TRUE(m.has_key(k));
+    height = std::max(height, int_comparisons+1);
+  }
+  return height;
+}
+
+
+TEST(BSTMap, balanced_height_on_adversarial_input) {
+  const int n = 100000;
+  std::vector<int> ascending(n), descending(n), zigzag(n);
+  for (int i = 0; i < n; ++i) {
+    ascending[i]  = i+1;
+    descending[i] = n-i;
+    zigzag[i]     = i%2 == 0 ? 1+i/2 : n-i/2;
+  }
+  for (const std::vector<int>* keys : {&ascending, &descending, &zigzag}) {
+    ics::BSTMap<int,int,counted_lt_int,true> m;
+    for (int i = 0; i < n; ++i) {
+      m.put((*keys)[i], i);
+      if ((i&(i+1)) == 0 || i == n-1) {     //At sizes 2^j-1 and n
+        std::vector<int> so_far(keys->begin(), keys->begin()+i+1);
+        ASSERT_LE(height_of(m,so_far), 1.44*std::log2(i+1+2));
+      }
+    }
+    for (int i = 0; i < n; i += 2)
+      m.erase((*keys)[i]);
+    std::vector<int> left;
+    for (int i = 1; i < n; i += 2)
+      left.push_back((*keys)[i]);
+    ASSERT_LE(height_of(m,left), 1.44*std::log2(left.size()+2));
+  }
+
+  ics::BSTMap<int,int,counted_lt_int> unbalanced;   //Contrast: the same input makes a list
+  std::vector<int> small(ascending.begin(), ascending.begin()+1000);
+  for (int k : small)
+    unbalanced.put(k, k);
+  ASSERT_EQ(1000, height_of(unbalanced,small));
+}
+
+
+//Runs f on a thread with a 256KB stack, which a recursive walk of a 20,000-deep tree overflows
+static void* call(void* f) {(*static_cast<std::function<void()>*>(f))(); return nullptr;}
+static void on_small_stack(std::function<void()> f) {
+  pthread_attr_t attr;
+  pthread_t      thread;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, 256*1024);
+  ASSERT_EQ(0, pthread_create(&thread, &attr, call, &f));
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attr);
+}
+
+
+//Sorted puts make an unbalanced map a chain; building it is O(N^2), so N is kept to 20,000
+TEST(BSTMap, degenerate_tree_walks_are_iterative) {
+  const int n = 20000;
+  IntMap m;
+  for (int i = 0; i < n; ++i)
+    m.put(i, i);
+  on_small_stack([&m,n] () {
+    {
+      IntMap copy(m);
+      ASSERT_TRUE(copy == m);
+      copy.put(n-1, -1);
+      ASSERT_TRUE(copy != m);
+      IntMap assigned;
+      assigned = copy;
+      ASSERT_TRUE(assigned == copy);
+      ASSERT_FALSE(m.has_value(-1));
+      ASSERT_TRUE(assigned.has_value(-1));
+    }                                       //Destructors free both chains
+    std::string s = m.str();
+    ASSERT_EQ(0u, s.find("bst_map[\n" + std::string(128,'.') + "(depth 19999)19999->19999\n"));
+    ASSERT_NE(std::string::npos, s.find("\n0->0](used=20000,mod_count=20000)"));
+    ASSERT_LT(s.size(), 200u*n);            //O(N), though the deepest node is at depth N-1
+  });
+  int k = 0;
+  for (const IntMap::Entry& e : m)
+    ASSERT_EQ(k++, e.first);
+  ASSERT_EQ(n, k);
+
+  IntMap ascending, scattered;              //Same entries in differently shaped trees
+  for (int i = 0; i < 100; ++i) {
+    ascending.put(i, i);
+    scattered.put(i*37%100, i*37%100);
+  }
+  ASSERT_TRUE(ascending == scattered);
+  scattered[50] = -50;
+  ASSERT_TRUE(ascending != scattered);
+}
+
+
+TEST(BSTMap, put_all_sorted_merges_into_non_empty_map) {
+  typedef ics::BSTMap<int,int,counted_lt_int,true,true> RankedMap;
+  RankedMap m;
+  std::vector<int> all;                      //The keys put_all_sorted should leave, in order
+  for (int k = 0; k < 3000; ++k) {
+    if (k%2 == 0)
+      m.put(k, k);
+    if (k%2 == 0 || k%3 == 0)
+      all.push_back(k);
+  }
+  std::vector<RankedMap::Entry> thirds;
+  for (int k = 0; k < 3000; k += 3)
+    thirds.push_back(RankedMap::Entry(k,-k));
+
+  RankedMap::Iterator before = m.begin();
+  ASSERT_EQ(1000, m.put_all_sorted(thirds));
+  ASSERT_THROW(++before, ics::ConcurrentModificationError);
+  ASSERT_EQ((int)all.size(), m.size());
+  int j = 0;
+  for (const RankedMap::Entry& e : m) {
+    ASSERT_EQ(all[j], e.first);
+    ASSERT_EQ(e.first%3 == 0 ? -e.first : e.first, e.second);   //Values from thirds win
+    ASSERT_EQ(j, m.rank(e.first));
+    ASSERT_EQ(e.first, m.select(j)->first);
+    ++j;
+  }
+  ASSERT_LE(height_of(m,all), std::ceil(std::log2(all.size()+1)));   //Perfectly balanced
+
+  for (int k = 3000; k < 6000; ++k)           //Heights/sizes are right for later puts/erases
+    m.put(k, k);
+  for (int k = 0; k < 6000; k += 4)
+    m.erase(k);
+  std::vector<int> left;
+  for (const RankedMap::Entry& e : m)
+    left.push_back(e.first);
+  ASSERT_LE(height_of(m,left), 1.44*std::log2(left.size()+2));
+  for (int r = 0; r < (int)left.size(); r += 97)
+    ASSERT_EQ(r, m.rank(left[r]));
+}
+
+
+TEST(BSTMap, put_all_sorted_falls_back_to_put_all_on_unsorted_input) {
+  typedef std::vector<IntMap::Entry> Entries;
+  Entries unsorted   {{5,50},{1,10},{9,90},{3,30}};
+  Entries duplicated {{1,10},{3,30},{3,-30},{5,50}};   //Not strictly increasing
+  Entries descending {{9,90},{5,50},{1,10}};
+  for (const Entries* input : {&unsorted, &duplicated, &descending})
+    for (bool empty : {true, false}) {
+      IntMap m, expected;
+      if (!empty)
+        for (int k : {0, 3, 4, 10}) {
+          m.put(k, k);
+          expected.put(k, k);
+        }
+      ASSERT_EQ((int)input->size(), m.put_all_sorted(*input));
+      ASSERT_EQ((int)input->size(), expected.put_all(*input));
+      ASSERT_TRUE(m == expected);
+    }
+  IntMap m{{1,10},{3,30},{3,-30}};            //The initializer_list constructor falls back too
+  ASSERT_EQ(2, m.size());
+  ASSERT_EQ(-30, m[3]);
+}
+
+
+//select/rank/count_range on m against the sorted keys it should hold
+template<class Map>
+static void check_order_statistics(const Map& m, const std::vector<int>& keys) {
+  int n = keys.size();
+  ASSERT_EQ(n, m.size());
+  for (int k : {-1, n, n+1, -1000})          //Out of range: end(), not an error
+    ASSERT_TRUE(m.select(k) == m.end());
+  for (int j = 0; j < n; ++j) {
+    auto i = m.select(j);
+    ASSERT_EQ(keys[j], i->first);
+    ASSERT_EQ(j, m.rank(keys[j]));
+    ASSERT_EQ(j, m.rank(keys[j]-1));         //Absent keys (all keys are even)
+    if (j+1 < n)
+      ASSERT_EQ(keys[j+1], (++i)->first);    //select's Iterator streams on
+  }
+  ASSERT_EQ(0, m.rank(-1000));
+  ASSERT_EQ(n, m.rank(1000000));
+  for (int j = 0; j < n; j += 7)
+    for (int l = j; l < n; l += 13) {
+      ASSERT_EQ(l-j, m.count_range(keys[j],keys[l]));
+      ASSERT_EQ(l-j, m.count_range(keys[j]-1,keys[l]-1));
+      ASSERT_EQ(0,   m.count_range(keys[l],keys[j]));     //Empty (l == j) or inverted
+      ASSERT_EQ(0,   m.count_range(keys[l]+1,keys[j]-1));
+    }
+  ASSERT_EQ(n, m.count_range(-1000,1000000));
+  ASSERT_EQ(0, m.count_range(1000000,-1000));
+}
+
+
+template<bool balanced>
+static void check_ranked_erase() {
+  ics::BSTMap<int,int,lt_int,balanced,true> m;
+  std::set<int> model;
+  check_order_statistics(m, std::vector<int>());
+  for (int i = 0; i < 300; ++i) {
+    int k = 2*(i*139%300);
+    m.put(k, i);
+    model.insert(k);
+  }
+  check_order_statistics(m, std::vector<int>(model.begin(),model.end()));
+
+  for (auto i = m.begin(); i != m.end(); ++i)    //Iterator::erase every third key
+    if (i->first%3 == 0) {
+      model.erase(i->first);
+      i.erase();
+    }
+  check_order_statistics(m, std::vector<int>(model.begin(),model.end()));
+
+  for (int i = 0; i < 300; ++i) {
+    int k = 2*(i*71%300);
+    if (model.erase(k)) {
+      m.erase(k);
+      check_order_statistics(m, std::vector<int>(model.begin(),model.end()));
+    }
+  }
+  ASSERT_TRUE(m.empty());
+}
+
+
+TEST(BSTMap, order_statistics_unbalanced) {check_ranked_erase<false>();}
+TEST(BSTMap, order_statistics_balanced)   {check_ranked_erase<true>();}
+
+
+//A value that counts its copies, to see how much of the map an Iterator touches
+static int copies = 0;
+struct Counted {
+  Counted(int v = 0) : value(v) {}
+  Counted(const Counted& c) : value(c.value) {++copies;}
+  Counted& operator = (const Counted& c) {value = c.value; ++copies; return *this;}
+  bool operator == (const Counted& rhs) const {return value == rhs.value;}
+  bool operator != (const Counted& rhs) const {return value != rhs.value;}
+  int value;
+};
+
+
+TEST(BSTMap, iterator_is_lazy) {
+  ics::BSTMap<int,Counted,lt_int,true> m;
+  for (int i = 0; i < 100000; ++i)
+    m.put(i, Counted(i));
+  copies = 0;
+  int seen = 0;
+  for (const auto& e : m) {                 //Nothing is copied: begin() only descends left
+    ASSERT_EQ(seen, e.second.value);
+    if (++seen == 3)
+      break;
+  }
+  ASSERT_EQ(0, copies);
+  auto i = m.lower_bound(50000);
+  ASSERT_EQ(50000, i->first);
+  ASSERT_EQ(50001, (++i)->first);
+  ASSERT_EQ(0, copies);
+}
+
+
+TEST(BSTMap, iterator_erase_mid_traversal) {
+  for (bool balanced_tree : {false, true}) {
+    ics::BSTMap<int,int,lt_int,true>  avl;
+    IntMap                            plain;
+    for (int i = 0; i < 1000; ++i) {
+      avl.put(i*389%1000, i);
+      plain.put(i*389%1000, i);
+    }
+    std::vector<int> visited, left;
+    auto check = [&] (auto& m) {
+      visited.clear();
+      for (auto i = m.begin(); i != m.end(); ++i) {
+        int key = i->first;
+        visited.push_back(key);
+        if (key%2 == 1) {
+          ASSERT_EQ(key, i.erase().first);
+          ASSERT_THROW(i.erase(), ics::CannotEraseError);
+        }
+      }
+      left.clear();
+      for (const auto& e : m)
+        left.push_back(e.first);
+    };
+    if (balanced_tree)
+      check(avl);
+    else
+      check(plain);
+    ASSERT_EQ(1000u, visited.size());       //Every key visited once, in order
+    for (int k = 0; k < 1000; ++k)
+      ASSERT_EQ(k, visited[k]);
+    ASSERT_EQ(500u, left.size());
+    for (int k = 0; k < 500; ++k)
+      ASSERT_EQ(2*k, left[k]);
+  }
+}
+
+
+TEST(BSTMap, iterator_concurrent_modification) {
+  IntMap m;
+  for (int i = 0; i < 10; ++i)
+    m.put(2*i, i);
+  auto i = m.begin();
+  ++i;
+  std::string s = i.str();
+  ASSERT_EQ(0u, s.find(m.str()));
+  ASSERT_NE(std::string::npos, s.find("expected_mod_count=10,can_erase=1)"));
+  m.put(5, 5);
+  ASSERT_THROW(++i,      ics::ConcurrentModificationError);
+  ASSERT_THROW(i++,      ics::ConcurrentModificationError);
+  ASSERT_THROW(*i,       ics::ConcurrentModificationError);
+  ASSERT_THROW(i->first, ics::ConcurrentModificationError);
+  ASSERT_THROW(i.erase(),ics::ConcurrentModificationError);
+  auto j = m.begin();
+  m.erase(0);
+  ASSERT_THROW(++j, ics::ConcurrentModificationError);
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+#include <functional>
+#include "gtest/gtest.h"
+#include "btree_map.hpp"
+
+
+bool lt_int(const int& a, const int& b) {return a < b;}
+typedef ics::BTreeMap<int,int,lt_int> IntMap;
+
+
+TEST(BTreeMap, subscript_on_present_keys_while_iterating) {
+  //Whatever shape the tree has (full nodes anywhere), updating present keys must not
+  //  restructure it under the Iterator
+  for (int n = 1; n <= 300; ++n) {
+    IntMap m;
+    for (int i = 0; i < n; ++i)
+      m[i] = 0;
+    int visited = 0;
+    for (auto i = m.begin(); i != m.end(); ++i) {
+      m[i->first] += 1;
+      ++visited;
+    }
+    ASSERT_EQ(n, visited);
+    for (int i = 0; i < n; ++i)
+      ASSERT_EQ(1, m[i]);
+  }
+}
+
+
+TEST(BTreeMap, subscript_insert_while_iterating_throws) {
+  IntMap m;
+  for (int i = 0; i < 100; ++i)
+    m[2*i] = i;
+  auto i = m.begin();
+  m[1] = 0;
+  ASSERT_THROW(++i, ics::ConcurrentModificationError);
+}
+
+
+TEST(BTreeMap, range) {
+  IntMap m;
+  for (int i = 0; i < 100; ++i)
+    m.put(2*i, i);
+  std::vector<int> keys;
+  for (const IntMap::Entry& e : m.range(3,10))
+    keys.push_back(e.first);
+  ASSERT_EQ(std::vector<int>({4,6,8}), keys);
+  for (const IntMap::Entry& e : m.range(5,5))
+    FAIL() << e.first;
+  for (const IntMap::Entry& e : m.range(10,3))
+    FAIL() << e.first;
+  for (const IntMap::Entry& e : m.range(500,3))
+    FAIL() << e.first;
+}
+
+
+TEST(BTreeMap, functor_lt) {
+  ics::BTreeMap<int,int,ics::undefinedlt<int>,std::less<int>> functor;
+  ics::BTreeMap<int,int>                                    runtime(lt_int);
+  for (int i = 0; i < 5000; ++i) {
+    functor.put(i*7919%3000, i);
+    runtime.put(i*7919%3000, i);
+  }
+  ASSERT_EQ(runtime.size(), functor.size());
+  auto r = runtime.begin();
+  for (const auto& e : functor) {
+    ASSERT_EQ(r->first,  e.first);
+    ASSERT_EQ(r->second, e.second);
+    ++r;
+  }
+}
+
+
+//A value wide enough that an Entry fills half of 128 bytes, so nodes get the smallest
+//  min_degree (2: 1..3 entries per node) and erase borrows, merges and shrinks the root often
+struct Wide {
+  Wide(int v = 0) : value(v) {}
+  bool operator == (const Wide& rhs) const {return value == rhs.value;}
+  bool operator != (const Wide& rhs) const {return value != rhs.value;}
+  int  value;
+  char pad[60];
+};
+std::ostream& operator << (std::ostream& outs, const Wide& w) {return outs << w.value;}
+typedef ics::BTreeMap<int,Wide,lt_int> WideMap;
+
+
+//The deepest node's depth+1, read from str(), which indents each node 2 spaces per level
+static int height_of(const WideMap& m) {
+  std::string s = m.str();
+  int height = 0;
+  for (std::string::size_type line = s.find('\n'); line != std::string::npos; line = s.find('\n',line+1))
+    height = std::max(height, (int)(s.find('[',line)-line-1)/2+1);
+  return height;
+}
+
+
+static void check_contents(const WideMap& m, const std::set<int>& expected) {
+  ASSERT_EQ((int)expected.size(), m.size());
+  auto e = expected.begin();
+  for (const WideMap::Entry& entry : m) {
+    ASSERT_TRUE(e != expected.end());
+    ASSERT_EQ(*e, entry.first);
+    ASSERT_EQ(-*e, entry.second.value);
+    ASSERT_TRUE(m.has_key(*e));
+    ++e;
+  }
+  ASSERT_TRUE(e == expected.end());
+}
+
+
+TEST(BTreeMap, erase_in_every_order_with_min_degree_2) {
+  const int n = 400;
+  std::vector<int> ascending, descending, scattered;
+  for (int i = 0; i < n; ++i) {
+    ascending.push_back(i);
+    descending.push_back(n-1-i);
+    scattered.push_back(i*173%n);             //173 is prime to n, so every key once
+  }
+  for (const std::vector<int>* order : {&ascending, &descending, &scattered}) {
+    WideMap m;
+    std::set<int> expected;
+    for (int k : scattered) {
+      m.put(k, Wide(-k));
+      expected.insert(k);
+    }
+    ASSERT_NE(std::string::npos, m.str().find("max_keys=3"));
+    int height = height_of(m);
+    ASSERT_GE(height, 5);
+    for (int k : *order) {
+      ASSERT_EQ(-k, m.erase(k).value);
+      expected.erase(k);
+      ASSERT_FALSE(m.has_key(k));
+      ASSERT_THROW(m.erase(k), ics::KeyError);
+      check_contents(m, expected);
+      int now = height_of(m);
+      ASSERT_LE(now, height);                 //Only a root merge changes the height
+      height = now;
+    }
+    ASSERT_TRUE(m.empty());
+    ASSERT_EQ(0, height);
+  }
+}
@@ -0,0 +1,256 @@
+#include <climits>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include "gtest/gtest.h"
+#include "hash_map.hpp"
+
+
+int hash_int(const int& i) {return i;}
+typedef ics::HashMap<int,int,hash_int> IntMap;
+
+
+//Leaves m halfway through an incremental resize: just past a doubling, with one old bin
+//  migrated per operation
+static void fill_mid_resize(IntMap& m, int n) {
+  m.set_rehash_step(1);
+  for (int i = 0; i < n; ++i)
+    m.put(i, 0);
+}
+
+
+TEST(HashMap, update_present_keys_while_iterating_mid_resize) {
+  IntMap m;
+  fill_mid_resize(m, 1025);
+  std::set<int> seen;
+  for (auto i = m.begin(); i != m.end(); ++i) {
+    ASSERT_TRUE(seen.insert(i->first).second);
+    m[i->first] += 1;
+    m.put(i->first, m[i->first]+1);
+  }
+  ASSERT_EQ(1025u, seen.size());
+  for (int i = 0; i < 1025; ++i)
+    ASSERT_EQ(2, m[i]);
+}
+
+
+TEST(HashMap, insert_while_iterating_mid_resize_throws) {
+  IntMap m;
+  fill_mid_resize(m, 1025);
+  auto i = m.begin();
+  m.put(5000, 0);
+  ASSERT_THROW(++i, ics::ConcurrentModificationError);
+}
+
+
+TEST(HashMap, resize_completes_on_inserts) {
+  IntMap m;
+  fill_mid_resize(m, 5000);
+  ASSERT_EQ(5000, m.size());
+  for (int i = 0; i < 5000; ++i)
+    ASSERT_TRUE(m.has_key(i));
+}
+
+
+struct HashInt {int operator () (const int& a) const {return a;}};
+
+
+TEST(HashMap, functor_hash) {
+  ics::HashMap<int,int,ics::undefinedhash<int>,HashInt> m;
+  for (int i = 0; i < 5000; ++i)
+    m.put(i, i);
+  ASSERT_EQ(5000, m.size());
+  ASSERT_EQ(77, m[77]);
+  ics::HashMap<int,int,ics::undefinedhash<int>,HashInt> copy(m);
+  ASSERT_EQ(m, copy);
+}
+
+
+static int hash_calls = 0;
+int counted_hash(const int& i) {++hash_calls; return i;}
+int collide_hash(const int& i) {++hash_calls; return i%4;}   //Many keys per hash value
+
+
+TEST(HashMap, find_or_insert_returns_existing_or_new_entry) {
+  ics::HashMap<int,int,counted_hash> m;
+  hash_calls = 0;
+  int& added = m.try_emplace(1, 10);          //Absent: added, and its new value returned
+  ASSERT_EQ(1, hash_calls);
+  ASSERT_EQ(10, added);
+  ASSERT_EQ(1, m.size());
+  int& found = m.try_emplace(1, 20);          //Present: the same entry, value untouched
+  ASSERT_EQ(2, hash_calls);
+  ASSERT_EQ(&added, &found);
+  ASSERT_EQ(10, found);
+  ASSERT_EQ(1, m.size());
+  found = 30;
+  ASSERT_EQ(30, m[1]);
+  ASSERT_EQ(&added, &m[1]);
+
+  hash_calls = 0;
+  ASSERT_EQ(40, m.put(2, 40));                //Absent: returns the value put
+  ASSERT_EQ(40, m.put(2, 41));                //Present: returns the value replaced
+  ASSERT_EQ(0,  m[3]);                        //Absent: adds T()
+  m[3] += 5;
+  ASSERT_EQ(5,  m[3]);
+  ASSERT_EQ(6,  m.emplace(3, 6));             //Present: emplace replaces
+  ASSERT_EQ(6,  m.erase(3));
+  ASSERT_EQ(7,  hash_calls);                  //One hash per write or lookup
+  ASSERT_EQ(2,  m.size());
+
+  for (int i = 100; i < 10000; ++i)           //Entries are relinked, not copied, on growth
+    m.put(i, i);
+  ASSERT_EQ(&added, &m.try_emplace(1, 0));
+  ASSERT_EQ(30, added);
+}
+
+
+TEST(HashMap, find_or_insert_with_colliding_hashes) {
+  ics::HashMap<int,int,collide_hash> m;
+  for (int i = 0; i < 40; ++i)
+    ASSERT_EQ(i, m.try_emplace(i, i));        //Same hash as earlier keys, but a new key
+  ASSERT_EQ(40, m.size());
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_EQ(i, m.try_emplace(i, -1));
+    ASSERT_EQ(&m[i], &m.try_emplace(i, -1));
+  }
+  ASSERT_EQ(40, m.size());
+  ASSERT_EQ(8, m.erase(8));
+  ASSERT_FALSE(m.has_key(8));
+  ASSERT_TRUE(m.has_key(4) && m.has_key(12));
+  ASSERT_EQ(-1, m.try_emplace(8, -1));
+  ASSERT_EQ(40, m.size());
+}
+
+
+//Bins str() lists: bins, plus the old table's while a resize is still draining it
+static int bins_listed(const ics::HashMap<int,int,counted_hash>& m) {
+  std::string s = m.str();
+  int count = 0;
+  for (std::string::size_type i = s.find(" : ["); i != std::string::npos; i = s.find(" : [",i+1))
+    ++count;
+  return count;
+}
+
+
+static void check_contents(const ics::HashMap<int,int,counted_hash>& m, const std::map<int,int>& model) {
+  ASSERT_EQ((int)model.size(), m.size());
+  std::set<int> seen;
+  for (const auto& e : m) {
+    ASSERT_TRUE(seen.insert(e.first).second);  //Each key once, from the old or the new table
+    ASSERT_EQ(1u, model.count(e.first));
+    ASSERT_EQ(model.at(e.first), e.second);
+  }
+  ASSERT_EQ(model.size(), seen.size());
+}
+
+
+//Lookups, erases (by key and by Iterator) and iteration just after the table doubles from
+//  1024 to 2048 bins; the cached hashes mean moving nodes never calls the hash function
+static void check_mid_resize(int step) {
+  ics::HashMap<int,int,counted_hash> m;
+  m.set_rehash_step(step);
+  std::map<int,int> model;
+  for (int i = 0; i < 1025; ++i) {
+    m.put(i, -i);
+    model[i] = -i;
+  }
+  bool resizing = step == 1 || step == 64;
+  ASSERT_EQ(resizing ? 2048+1024 : 2048, bins_listed(m));
+
+  hash_calls = 0;
+  const ics::HashMap<int,int,counted_hash>& c = m;
+  for (int i = -10; i < 1035; ++i) {
+    ASSERT_EQ(i >= 0 && i < 1025, m.has_key(i));
+    if (i >= 0 && i < 1025)
+      ASSERT_EQ(-i, c[i]);
+  }
+  ASSERT_EQ(1045+1025, hash_calls);
+  ASSERT_EQ(resizing ? 2048+1024 : 2048, bins_listed(m));   //Lookups do not advance it
+  check_contents(m, model);
+
+  for (auto i = m.begin(); i != m.end(); ++i)
+    if (i->first%5 == 0) {
+      model.erase(i->first);
+      i.erase();
+    }
+  check_contents(m, model);
+
+  hash_calls = 0;
+  int erased = 0;
+  for (int k = 3; k < 1025; k += 6)
+    if (model.erase(k)) {
+      ASSERT_EQ(-k, m.erase(k));
+      ASSERT_THROW(m.erase(k), ics::KeyError);
+      ASSERT_FALSE(m.has_key(k));
+      ASSERT_EQ(model.count(k+1) == 1, m.has_key(k+1));
+      erased += 4;                            //Each call above hashes once
+    }
+  ASSERT_EQ(erased, hash_calls);
+  if (step == 1)                             //Each erase moved one more of the 1024 old bins
+    ASSERT_EQ(2048+1024, bins_listed(m));
+  check_contents(m, model);
+
+  hash_calls = 0;
+  for (int i = 2000; i < 3000; ++i) {        //Enough puts to finish the resize at any step
+    m.put(i, -i);
+    model[i] = -i;
+  }
+  ASSERT_EQ(1000, hash_calls);
+  ASSERT_EQ(2048, bins_listed(m));
+  check_contents(m, model);
+}
+
+
+TEST(HashMap, mid_resize_step_0) {check_mid_resize(0);}
+TEST(HashMap, mid_resize_step_1) {check_mid_resize(1);}
+TEST(HashMap, mid_resize_step_N) {
+  check_mid_resize(64);
+  check_mid_resize(4096);                    //More than the old table's bins: all at once
+}
+
+
+//Entries per bin, read from str(), which lists each bin as " i : [(key,value)...]"
+template<class Map>
+static std::vector<int> bin_sizes(const Map& m) {
+  std::string s = m.str();
+  std::vector<int> sizes;
+  for (std::string::size_type i = s.find(" : ["); i != std::string::npos; i = s.find(" : [",i+1)) {
+    std::string::size_type end = s.find(']',i);
+    sizes.push_back(std::count(s.begin()+i, s.begin()+end, '('));
+  }
+  return sizes;
+}
+
+
+int high_bits_hash(const int& i) {return i << 21;}       //Only bits 21..30 vary for keys < 1024
+int top_bit_hash  (const int& i) {return i == 1 ? INT_MIN : 0;}
+
+
+TEST(HashMap, hashes_differing_only_in_high_bits_spread) {
+  ics::HashMap<int,int,high_bits_hash> m(1024);           //Masking alone would put them all in bin 0
+  for (int i = 0; i < 1024; ++i)
+    m.put(i, i);
+  std::vector<int> sizes = bin_sizes(m);
+  ASSERT_EQ(1024u, sizes.size());
+  int occupied = 0, longest = 0;
+  for (int n : sizes) {
+    occupied += n > 0;
+    longest   = std::max(longest, n);
+  }
+  ASSERT_GT(occupied, 550);                  //About 1024*(1-1/e) = 647 for a uniform hash
+  ASSERT_LE(longest, 8);
+  for (int i = 0; i < 1024; ++i)
+    ASSERT_EQ(i, m[i]);
+
+  ics::HashMap<int,int,top_bit_hash> top(1024);           //Hashes 0 and INT_MIN: no abs(INT_MIN)
+  top.put(0, 0);
+  top.put(1, 1);
+  sizes = bin_sizes(top);
+  ASSERT_EQ(2, std::count(sizes.begin(), sizes.end(), 1));
+  ASSERT_EQ(1, top.erase(1));
+  ASSERT_FALSE(top.has_key(1));
+  ASSERT_TRUE(top.has_key(0));
+}
@@ -0,0 +1,51 @@
+#include <set>
+#include <functional>
+#include "gtest/gtest.h"
+#include "hash_set.hpp"
+
+
+int hash_int(const int& i) {return i;}
+typedef ics::HashSet<int,hash_int> IntSet;
+
+
+TEST(HashSet, insert_contains_erase) {
+  IntSet s;
+  ASSERT_EQ(1, s.insert(5));
+  ASSERT_EQ(0, s.insert(5));
+  ASSERT_TRUE(s.contains(5));
+  ASSERT_FALSE(s.contains(6));
+  ASSERT_EQ(1, s.erase(5));
+  ASSERT_EQ(0, s.erase(5));
+  ASSERT_FALSE(s.contains(5));
+  ASSERT_TRUE(s.empty());
+}
+
+
+TEST(HashSet, matches_std_set_across_resizes) {
+  IntSet s;
+  std::set<int> model;
+  unsigned int x = 1;
+  for (int i = 0; i < 200000; ++i) {
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    int e = (int)(x % 20000);
+    switch (x >> 30) {
+      case 0:
+      case 1:  ASSERT_EQ((int)model.insert(e).second, s.insert(e)); break;
+      case 2:  ASSERT_EQ((int)model.erase(e), s.erase(e));          break;
+      default: ASSERT_EQ(model.count(e) == 1, s.contains(e));      break;
+    }
+    ASSERT_EQ((int)model.size(), s.size());
+  }
+  for (int e : model)
+    ASSERT_TRUE(s.contains(e));
+}
+
+
+TEST(HashSet, functor_hash) {
+  ics::HashSet<int,ics::undefinedhash<int>,std::hash<int>> s;
+  for (int i = 0; i < 5000; ++i)
+    s.insert(i%100);
+  ASSERT_EQ(100, s.size());
+  ASSERT_TRUE(s.contains(5));
+  ASSERT_FALSE(s.contains(100));
+}
@@ -0,0 +1,699 @@
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "heap_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+typedef ics::HeapPriorityQueue<int,gt_int> IntPQ;
+
+
+static std::vector<int> some_ints(int n) {
+  std::vector<int> v;
+  unsigned int x = 1;
+  for (int i = 0; i < n; ++i) {
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    v.push_back((int)(x % 1000));
+  }
+  return v;
+}
+
+
+TEST(HeapPriorityQueue, functor_template_and_runtime_gt_agree) {
+  ics::HeapPriorityQueue<int,ics::undefinedgt<int>,std::greater<int>> functor;
+  IntPQ                                                             templated;
+  ics::HeapPriorityQueue<int>                                       runtime(gt_int);
+  for (int x : some_ints(1000)) {
+    functor.enqueue(x);
+    templated.enqueue(x);
+    runtime.enqueue(x);
+  }
+  ics::HeapPriorityQueue<int,ics::undefinedgt<int>,std::greater<int>> copy(functor);
+  while (!functor.empty()) {
+    int x = functor.dequeue();
+    ASSERT_EQ(x, templated.dequeue());
+    ASSERT_EQ(x, runtime.dequeue());
+    ASSERT_EQ(x, copy.dequeue());
+  }
+}
+
+
+TEST(HeapPriorityQueue, gt_neither_or_both_supplied) {
+  ASSERT_THROW(ics::HeapPriorityQueue<int> neither, ics::TemplateFunctionError);
+  typedef ics::HeapPriorityQueue<int,ics::undefinedgt<int>,std::greater<int>> FunctorPQ;
+  ASSERT_THROW(FunctorPQ both(gt_int), ics::TemplateFunctionError);
+}
+
+
+template<int arity>
+void check_arity() {
+  typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,arity> PQ;
+  std::vector<int> v = some_ints(5000);
+  std::vector<int> sorted(v);
+  std::sort(sorted.rbegin(), sorted.rend());
+
+  PQ enqueued;
+  for (int x : v)
+    enqueued.enqueue(x);
+  PQ heapified(v);
+  for (int x : sorted) {
+    ASSERT_EQ(x, enqueued.peek());
+    ASSERT_EQ(x, enqueued.dequeue());
+    ASSERT_EQ(x, heapified.dequeue());
+  }
+  ASSERT_TRUE(enqueued.empty());
+
+  PQ il({5,1,9,3,7});
+  ASSERT_EQ(9, il.dequeue());
+  ASSERT_EQ(7, il.dequeue());
+}
+
+TEST(HeapPriorityQueue, arity_2) {check_arity<2>();}
+TEST(HeapPriorityQueue, arity_3) {check_arity<3>();}
+TEST(HeapPriorityQueue, arity_4) {check_arity<4>();}
+TEST(HeapPriorityQueue, arity_8) {check_arity<8>();}
+
+
+TEST(HeapPriorityQueue, duplicates_and_small_sizes) {
+  std::vector<int> v = some_ints(5000);
+  for (int m : {1, 2, 3, 7, 100, 5000}) {
+    std::vector<int> s(v.begin(), v.begin()+m);
+    for (int& x : s)
+      x %= 50;                              //Many duplicates
+    IntPQ enqueued;
+    for (int x : s)
+      enqueued.enqueue(x);
+    IntPQ heapified(s);
+    std::sort(s.rbegin(), s.rend());
+    for (int x : s) {
+      ASSERT_EQ(x, enqueued.dequeue());
+      ASSERT_EQ(x, heapified.dequeue());
+    }
+    ASSERT_TRUE(enqueued.empty());
+  }
+}
+
+
+TEST(HeapPriorityQueue, dequeue_empty_throws) {
+  IntPQ pq;
+  ASSERT_THROW(pq.dequeue(), ics::EmptyError);
+  ASSERT_THROW(pq.peek(),    ics::EmptyError);
+}
+
+
+TEST(HeapPriorityQueue, interleaved_matches_std_heap) {
+  IntPQ pq;
+  std::vector<int> model;
+  std::vector<int> v = some_ints(20000);
+  for (int i = 0; i < 20000; ++i)
+    if (model.empty() || v[i]%3 != 0) {
+      pq.enqueue(v[i]);
+      model.push_back(v[i]);
+      std::push_heap(model.begin(), model.end());
+    } else {
+      std::pop_heap(model.begin(), model.end());
+      ASSERT_EQ(model.back(), pq.dequeue());
+      model.pop_back();
+    }
+  ASSERT_EQ((int)model.size(), pq.size());
+}
+
+
+template<int arity, bool addressable>
+void check_batch_operations() {
+  typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,arity,addressable> PQ;
+  std::vector<int> r = some_ints(20000);
+  int next = 0;
+  for (int trial = 0; trial < 200; ++trial) {
+    int n = r[next++]%300, k = r[next++]%(n+5);
+    PQ pq;
+    std::vector<int> sorted;
+    for (int i = 0; i < n; ++i) {
+      pq.enqueue(r[next]%50);
+      sorted.push_back(r[next++]%50);
+    }
+    std::sort(sorted.rbegin(), sorted.rend());
+    int taken = std::min(k,n);
+
+    std::vector<int> top = pq.top_k(k);
+    ASSERT_EQ(std::vector<int>(sorted.begin(), sorted.begin()+taken), top);
+    ASSERT_EQ(n, pq.size());
+
+    std::vector<int> batch;
+    ASSERT_EQ(taken, pq.dequeue_batch(k, std::back_inserter(batch)));
+    ASSERT_EQ(top, batch);
+    for (int i = taken; i < n; ++i)
+      ASSERT_EQ(sorted[i], pq.dequeue());
+
+    PQ a, b;
+    std::vector<int> all;
+    int na = r[next++]%200, nb = r[next++]%200;
+    for (int i = 0; i < na+nb; ++i) {
+      (i < na ? a : b).enqueue(r[next]%100);
+      all.push_back(r[next++]%100);
+    }
+    std::sort(all.rbegin(), all.rend());
+    PQ copied(a), moved(a), appended;
+    ASSERT_EQ(nb, copied.merge(b));
+    ASSERT_EQ(nb, moved.merge(std::move(b)));
+    ASSERT_TRUE(b.empty());
+    ASSERT_EQ((int)all.size(), appended.enqueue_all(all));
+    for (int x : all) {
+      ASSERT_EQ(x, copied.dequeue());
+      ASSERT_EQ(x, moved.dequeue());
+      ASSERT_EQ(x, appended.dequeue());
+    }
+  }
+}
+
+TEST(HeapPriorityQueue, batch_operations_binary)                {check_batch_operations<2,false>();}
+TEST(HeapPriorityQueue, batch_operations_ternary_addressable)   {check_batch_operations<3,true>();}
+TEST(HeapPriorityQueue, batch_operations_quaternary_addressable){check_batch_operations<4,true>();}
+
+
+TEST(HeapPriorityQueue, merge_with_itself) {
+  IntPQ pq({1,2,3});
+  ASSERT_EQ(3, pq.merge(pq));
+  ASSERT_EQ(6, pq.size());
+  ASSERT_EQ(3, pq.dequeue());
+  ASSERT_EQ(3, pq.dequeue());
+}
+
+
+TEST(HeapPriorityQueue, enqueue_all_from_itself_throws) {
+  IntPQ pq({1,2});
+  ASSERT_THROW(pq.enqueue_all(pq), ics::ConcurrentModificationError);
+}
+
+
+typedef std::pair<int,int> Arrival;                  //(priority, arrival order)
+bool gt_priority(const Arrival& a, const Arrival& b) {return a.first > b.first;}
+
+
+//The values in dequeue order for a stable queue: highest priority first, equal priorities in arrival order
+static std::vector<Arrival> in_order(std::vector<Arrival> values) {
+  std::stable_sort(values.begin(), values.end(), [] (const Arrival& a, const Arrival& b) {return a.first > b.first;});
+  return values;
+}
+
+template<class PQ>
+std::vector<Arrival> drain(PQ& pq) {
+  std::vector<Arrival> values;
+  while (!pq.empty())
+    values.push_back(pq.dequeue());
+  return values;
+}
+
+
+template<int arity, bool addressable>
+void check_stable() {
+  typedef ics::HeapPriorityQueue<Arrival,gt_priority,ics::undefinedfunctor,arity,addressable,true> PQ;
+  unsigned int x = 7*arity+addressable;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  int arrivals = 0;
+  for (int trial = 0; trial < 200; ++trial) {
+    PQ pq;
+    std::vector<Arrival> model;
+    int range = 1+next(10);
+    for (int ops = next(400); ops > 0; --ops) {
+      int op = next(10);
+      if (op < 6) {
+        Arrival a(next(range), arrivals++);
+        if (op == 5)
+          pq.emplace(a.first, a.second);
+        else
+          pq.enqueue(a);
+        model.push_back(a);
+      } else if (op == 6) {
+        std::vector<Arrival> batch;
+        for (int k = next(20); k > 0; --k) {
+          batch.push_back(Arrival(next(range), arrivals++));
+          model.push_back(batch.back());
+        }
+        pq.enqueue_all(batch);
+      } else if (!model.empty()) {
+        Arrival first = in_order(model)[0];
+        ASSERT_EQ(first, pq.peek());
+        ASSERT_EQ(first, pq.dequeue());
+        model.erase(std::find(model.begin(), model.end(), first));
+      }
+    }
+
+    std::vector<Arrival> iterated;
+    for (const Arrival& a : pq)
+      iterated.push_back(a);
+    ASSERT_EQ(in_order(model), iterated);
+    ASSERT_EQ(std::vector<Arrival>(iterated.begin(), iterated.begin()+std::min<std::size_t>(5,iterated.size())), pq.top_k(5));
+
+    for (auto i = pq.begin(); i != pq.end(); ++i)
+      if (next(4) == 0) {
+        Arrival erased = i.erase();
+        model.erase(std::find(model.begin(), model.end(), erased));
+      }
+
+    PQ copy(pq), assigned, other;
+    assigned = pq;
+    ASSERT_TRUE(copy == pq);
+    std::vector<Arrival> other_model;
+    for (int k = next(50); k > 0; --k) {
+      Arrival a(next(range), arrivals++);
+      other.enqueue(a);
+      other_model.push_back(a);
+    }
+    copy.merge(other);                       //other's values count as arriving after copy's
+    std::vector<Arrival> merged_model(model);
+    merged_model.insert(merged_model.end(), other_model.begin(), other_model.end());
+    ASSERT_EQ(in_order(merged_model), drain(copy));
+    ASSERT_EQ(in_order(model), drain(assigned));
+    PQ moved(std::move(pq));
+    ASSERT_EQ(in_order(model), drain(moved));
+  }
+}
+
+TEST(HeapPriorityQueue, stable_binary)                 {check_stable<2,false>();}
+TEST(HeapPriorityQueue, stable_quaternary)             {check_stable<4,false>();}
+TEST(HeapPriorityQueue, stable_binary_addressable)     {check_stable<2,true>();}
+TEST(HeapPriorityQueue, stable_ternary_addressable)    {check_stable<3,true>();}
+
+
+template<int arity>
+void check_stable_update() {
+  typedef ics::HeapPriorityQueue<Arrival,gt_priority,ics::undefinedfunctor,arity,true,true> PQ;
+  PQ pq;
+  int h0 = pq.enqueue(Arrival(1,0));
+  pq.enqueue(Arrival(1,1));
+  int h2 = pq.enqueue(Arrival(0,2));
+  pq.enqueue(Arrival(2,3));
+  pq.update(h2, Arrival(1,2));               //update keeps each value's place among equal priorities
+  pq.update(h0, Arrival(1,0));
+  ASSERT_EQ(std::vector<Arrival>({Arrival(2,3),Arrival(1,0),Arrival(1,1),Arrival(1,2)}), drain(pq));
+}
+
+TEST(HeapPriorityQueue, stable_update_binary)     {check_stable_update<2>();}
+TEST(HeapPriorityQueue, stable_update_quaternary) {check_stable_update<4>();}
+
+
+TEST(HeapPriorityQueue, stable_initializer_list_and_self_merge) {
+  typedef ics::HeapPriorityQueue<Arrival,gt_priority,ics::undefinedfunctor,2,false,true> PQ;
+  PQ pq({Arrival(1,0),Arrival(1,1),Arrival(2,2),Arrival(1,3)});
+  ASSERT_EQ(Arrival(2,2), pq.dequeue());
+  ASSERT_EQ(Arrival(1,0), pq.dequeue());
+  ASSERT_EQ(Arrival(1,1), pq.dequeue());
+
+  PQ twice({Arrival(0,0),Arrival(0,1)});
+  twice.merge(twice);
+  ASSERT_EQ(std::vector<Arrival>({Arrival(0,0),Arrival(0,1),Arrival(0,0),Arrival(0,1)}), drain(twice));
+}
+
+
+//The (up to) k values a bounded stable queue keeps, highest first
+static std::vector<Arrival> best(const std::vector<Arrival>& values, int k) {
+  std::vector<Arrival> kept = in_order(values);
+  if ((int)kept.size() > k)
+    kept.resize(k);
+  return kept;
+}
+
+static std::vector<int> priorities(const std::vector<Arrival>& values) {
+  std::vector<int> answer;
+  for (const Arrival& a : values)
+    answer.push_back(a.first);
+  return answer;
+}
+
+
+//A non-stable queue may keep any of several equal-priority values, so only priorities are compared
+template<int arity, bool stable>
+void check_bounded() {
+  typedef ics::HeapPriorityQueue<Arrival,gt_priority,ics::undefinedfunctor,arity,false,stable,true> PQ;
+  unsigned int x = 3*arity+stable;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  int arrivals = 0;
+  for (int trial = 0; trial < 300; ++trial) {
+    int k = 1+next(30), range = 1+next(trial%2 ? 5 : 1000);
+    PQ pq(k);
+    ASSERT_EQ(k, pq.capacity());
+    std::vector<Arrival> offered;
+    for (int ops = next(300); ops > 0; --ops) {
+      int op = next(10);
+      Arrival a(next(range), arrivals++);
+      if (op < 7) {
+        int kept = op == 6 ? pq.emplace(a.first, a.second) : pq.enqueue(a);
+        offered.push_back(a);
+        if (stable) {
+          std::vector<Arrival> b = best(offered, k);
+          ASSERT_EQ(std::find(b.begin(), b.end(), a) != b.end(), kept == 1);
+        }
+      } else if (op == 7) {
+        std::vector<Arrival> batch;
+        for (int j = 0; j < 5; ++j)
+          batch.push_back(Arrival(next(range), arrivals++));
+        offered.insert(offered.end(), batch.begin(), batch.end());
+        pq.enqueue_all(batch);
+      } else if (!offered.empty() && k > 0) {
+        std::vector<Arrival> b = best(offered, k);
+        if (stable)
+          ASSERT_EQ(b.back(), pq.peek());
+        else
+          ASSERT_EQ(b.back().first, pq.peek().first);
+        Arrival lowest = pq.dequeue();
+        offered = b;
+        auto i = std::find(offered.begin(), offered.end(), lowest);
+        if (i == offered.end())                //Non-stable: some equal-priority value was kept instead
+          for (i = offered.end()-1; i->first != lowest.first; --i)
+            ;
+        offered.erase(i);
+      }
+      ASSERT_EQ(std::min<int>(k, offered.size()), pq.size());
+    }
+
+    std::vector<Arrival> b = best(offered, k);
+    std::vector<Arrival> iterated;
+    for (const Arrival& a : pq)
+      iterated.push_back(a);
+    std::vector<Arrival> lowest_first(b.rbegin(), b.rend());
+    if (stable)
+      ASSERT_EQ(lowest_first, iterated);
+    else
+      ASSERT_EQ(priorities(lowest_first), priorities(iterated));
+
+    PQ copy(pq), assigned(3);
+    assigned = pq;
+    ASSERT_EQ(k, copy.capacity());
+    ASSERT_EQ(k, assigned.capacity());
+    std::vector<Arrival> drained = pq.drain_sorted();
+    ASSERT_TRUE(pq.empty());
+    if (stable)
+      ASSERT_EQ(b, drained);
+    else
+      ASSERT_EQ(priorities(b), priorities(drained));
+    ASSERT_EQ(drained, copy.drain_sorted());
+    ASSERT_EQ(drained, assigned.drain_sorted());
+  }
+}
+
+TEST(HeapPriorityQueue, bounded_binary)            {check_bounded<2,false>();}
+TEST(HeapPriorityQueue, bounded_binary_stable)     {check_bounded<2,true>();}
+TEST(HeapPriorityQueue, bounded_ternary)           {check_bounded<3,false>();}
+TEST(HeapPriorityQueue, bounded_quaternary_stable) {check_bounded<4,true>();}
+
+
+TEST(HeapPriorityQueue, bounded_capacity_changes_and_merge) {
+  typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,2,false,false,true> Bounded;
+  Bounded pq(3);
+  for (int x : {5,1,9,7,3,8})
+    pq.enqueue(x);
+  ASSERT_EQ(7, pq.peek());
+  std::ostringstream out;
+  out << pq;
+  ASSERT_EQ("priority_queue[7,8,9]:highest", out.str());
+
+  pq.merge(pq);
+  ASSERT_EQ(3, pq.size());
+  ASSERT_EQ(8, pq.peek());
+  pq.set_capacity(2);
+  ASSERT_EQ(2, pq.size());
+  ASSERT_EQ(9, pq.peek());
+  pq.set_capacity(5);
+  for (int x : {1,2,3})
+    pq.enqueue(x);
+  ASSERT_EQ(std::vector<int>({9,9,3,2,1}), pq.drain_sorted());
+
+
+
+  Bounded il({4,2,6});
+  ASSERT_EQ(3, il.capacity());
+  ASSERT_EQ(0, il.enqueue(1));
+  ASSERT_EQ(1, il.enqueue(5));
+  ASSERT_EQ(4, il.peek());
+
+  IntPQ unbounded({3,1,2});
+  ASSERT_EQ(std::vector<int>({3,2,1}), unbounded.drain_sorted());
+}
+
+
+//A bounded queue with no room would silently drop every value, so each way of getting one raises
+//  IcsError (default construction is a compile-time error)
+TEST(HeapPriorityQueue, bounded_requires_a_capacity) {
+  typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,2,false,false,true> Bounded;
+  ASSERT_THROW(Bounded(0), ics::IcsError);
+  ASSERT_THROW(Bounded(-3), ics::IcsError);
+  ASSERT_THROW(Bounded(std::initializer_list<int>()), ics::IcsError);
+  ASSERT_THROW(Bounded(std::vector<int>()), ics::IcsError);
+
+  Bounded pq(2);
+  ASSERT_THROW(pq.set_capacity(0), ics::IcsError);
+  ASSERT_EQ(2, pq.capacity());
+  pq.enqueue(1);
+  pq.enqueue(2);
+
+  Bounded taken(std::move(pq));
+  ASSERT_EQ(2, taken.size());
+  ASSERT_THROW(pq.enqueue(3), ics::IcsError);
+  ASSERT_THROW(pq.emplace(3), ics::IcsError);
+  ASSERT_TRUE(pq.empty());
+
+  Bounded assigned(5);
+  assigned = taken;
+  ASSERT_EQ(2, assigned.capacity());
+  ASSERT_EQ(1, assigned.enqueue(3));
+  ASSERT_EQ(std::vector<int>({3,2}), assigned.drain_sorted());
+}
+
+
+//Values are unique (by arrival), so the model maps each live handle to its value; every handle
+//  that has left the queue is kept too, and must stay stale after its slot is reused
+template<int arity>
+void check_handles() {
+  typedef ics::HeapPriorityQueue<Arrival,gt_priority,ics::undefinedfunctor,arity,true> PQ;
+  unsigned int x = 7*arity;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  auto pick = [&next] (const std::map<int,Arrival>& m) {auto i = m.begin(); std::advance(i, next(m.size())); return i->first;};
+  PQ pq;
+  std::map<int,Arrival> live;
+  std::vector<int> stale;
+  int arrivals = 0;
+  for (int ops = 0; ops < 20000; ++ops) {
+    int op = next(10);
+    if (op < 4 || live.empty()) {
+      Arrival a(next(100), arrivals++);
+      int h = op == 3 ? pq.emplace(a.first, a.second) : pq.enqueue(a);
+      ASSERT_EQ(0u, live.count(h));
+      live[h] = a;
+    } else if (op < 6) {
+      int h = pick(live);
+      live[h] = Arrival(next(100), arrivals++);
+      pq.update(h, live[h]);
+    } else if (op < 8) {
+      int h = pick(live);
+      ASSERT_EQ(live[h], pq.erase(h));
+      live.erase(h);
+      stale.push_back(h);
+    } else {
+      Arrival top = pq.dequeue();
+      auto i = std::find_if(live.begin(), live.end(), [&top] (const std::pair<const int,Arrival>& e) {return e.second == top;});
+      ASSERT_TRUE(i != live.end());
+      for (const auto& e : live)
+        ASSERT_FALSE(gt_priority(e.second, top));
+      stale.push_back(i->first);
+      live.erase(i);
+    }
+    ASSERT_EQ((int)live.size(), pq.size());
+    for (int k = 0; k < 3 && !stale.empty(); ++k) {
+      int h = stale[next(stale.size())];
+      ASSERT_EQ(live.count(h) == 1, pq.contains(h));    //Issued again only if the slot wrapped
+    }
+  }
+  for (const auto& e : live)
+    ASSERT_TRUE(pq.contains(e.first));
+}
+
+TEST(HeapPriorityQueue, handles_binary)     {check_handles<2>();}
+TEST(HeapPriorityQueue, handles_quaternary) {check_handles<4>();}
+
+
+//A freed slot is handed out again at once, but under a new handle
+TEST(HeapPriorityQueue, stale_handle_does_not_alias_reused_slot) {
+  typedef ics::HeapPriorityQueue<int,gt_int,ics::undefinedfunctor,2,true> PQ;
+  PQ pq;
+  int h1 = pq.enqueue(1);
+  int h2 = pq.enqueue(2);
+  ASSERT_TRUE(pq.contains(h1));
+  ASSERT_EQ(1, pq.erase(h1));
+  ASSERT_FALSE(pq.contains(h1));
+  ASSERT_THROW(pq.erase(h1), ics::KeyError);
+
+  int h3 = pq.enqueue(3);
+  ASSERT_NE(h1, h3);
+  ASSERT_FALSE(pq.contains(h1));
+  ASSERT_THROW(pq.update(h1, 10), ics::KeyError);
+  ASSERT_THROW(pq.erase(h1),      ics::KeyError);
+  ASSERT_EQ(3, pq.peek());
+  ASSERT_EQ(2, pq.size());
+
+  ASSERT_EQ(3, pq.dequeue());
+  int h4 = pq.enqueue(4);
+  ASSERT_FALSE(pq.contains(h3));
+  ASSERT_THROW(pq.update(h3, 0), ics::KeyError);
+  ASSERT_TRUE(pq.contains(h4));
+
+  pq.clear();
+  int h5 = pq.enqueue(5);
+  ASSERT_FALSE(pq.contains(h2));
+  ASSERT_FALSE(pq.contains(h4));
+  ASSERT_THROW(pq.erase(h2), ics::KeyError);
+  ASSERT_TRUE(pq.contains(h5));
+
+  for (int bad : {-1, -1000, 1 << 20, 1 << 30, h5+1})
+    if (bad != h5) {
+      ASSERT_FALSE(pq.contains(bad));
+      ASSERT_THROW(pq.update(bad, 0), ics::KeyError);
+      ASSERT_THROW(pq.erase(bad),     ics::KeyError);
+    }
+  ASSERT_EQ(1, pq.size());
+}
+
+
+//Addressable: handles of erased values are gone, the others still name their values
+template<class PQ>
+void check_handles_after_erase(PQ& pq, std::map<int,int>& handle_of, const std::vector<Arrival>& model,
+                               const std::vector<Arrival>& erased, std::true_type) {
+  for (const Arrival& e : erased)
+    ASSERT_FALSE(pq.contains(handle_of[e.second]));
+  for (const Arrival& a : model) {
+    ASSERT_TRUE(pq.contains(handle_of[a.second]));
+    pq.update(handle_of[a.second], a);
+  }
+}
+
+template<class PQ>
+void check_handles_after_erase(PQ&, std::map<int,int>&, const std::vector<Arrival>&, const std::vector<Arrival>&, std::false_type) {}
+
+
+//Equal priorities (few distinct ones) make non-stable queues break ties by index; every value
+//  must be visited exactly once, in priority order, whatever erase moves around
+template<int arity, bool addressable, bool stable>
+void check_iterator_erase() {
+  typedef ics::HeapPriorityQueue<Arrival,gt_priority,ics::undefinedfunctor,arity,addressable,stable> PQ;
+  unsigned int x = 11*arity+2*addressable+stable;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  auto by_arrival = [] (std::vector<Arrival> v) {std::sort(v.begin(), v.end(), [] (const Arrival& a, const Arrival& b) {return a.second < b.second;}); return v;};
+  int arrivals = 0;
+  for (int trial = 0; trial < 300; ++trial) {
+    PQ pq;
+    std::vector<Arrival> model;
+    std::map<int,int> handle_of;               //arrival -> handle
+    int range = 1+next(trial%3 ? 4 : 1000);
+    for (int n = next(trial%10 ? 200 : 3000); n > 0; --n) {
+      Arrival a(next(range), arrivals++);
+      handle_of[a.second] = pq.enqueue(a);
+      model.push_back(a);
+    }
+
+    for (int pass = 0; pass < 3; ++pass) {
+      int erase_odds = 1+next(4), stop = next(3) == 0 ? next(model.size()+1) : model.size();
+      std::vector<Arrival> visited, erased;
+      for (auto i = pq.begin(); i != pq.end() && (int)visited.size() < stop; ++i) {
+        visited.push_back(*i);
+        if (next(erase_odds) == 0) {
+          Arrival e = i.erase();
+          ASSERT_EQ(visited.back(), e);
+          erased.push_back(e);
+          ASSERT_THROW(*i, ics::IteratorPositionIllegal);
+          ASSERT_THROW(i.erase(), ics::CannotEraseError);
+        }
+      }
+      for (std::size_t j = 1; j < visited.size(); ++j)
+        ASSERT_FALSE(gt_priority(visited[j], visited[j-1]));
+      std::vector<Arrival> expected = in_order(model);
+      if (stable)
+        ASSERT_EQ(std::vector<Arrival>(expected.begin(), expected.begin()+visited.size()), visited);
+      else
+        ASSERT_EQ(priorities(std::vector<Arrival>(expected.begin(), expected.begin()+visited.size())), priorities(visited));
+      std::vector<Arrival> once = by_arrival(visited);
+      ASSERT_TRUE(std::adjacent_find(once.begin(), once.end()) == once.end());
+      if (visited.size() == model.size())
+        ASSERT_EQ(by_arrival(model), once);
+
+      for (const Arrival& e : erased)
+        model.erase(std::find(model.begin(), model.end(), e));
+      check_handles_after_erase(pq, handle_of, model, erased, std::integral_constant<bool,addressable>());
+      ASSERT_EQ((int)model.size(), pq.size());
+      std::vector<Arrival> all;
+      for (const Arrival& a : pq)
+        all.push_back(a);
+      ASSERT_EQ(by_arrival(model), by_arrival(all));
+    }
+    std::vector<Arrival> drained = drain(pq);
+    if (stable)
+      ASSERT_EQ(in_order(model), drained);
+    else
+      ASSERT_EQ(priorities(in_order(model)), priorities(drained));
+  }
+}
+
+TEST(HeapPriorityQueue, iterator_erase_binary)                   {check_iterator_erase<2,false,false>();}
+TEST(HeapPriorityQueue, iterator_erase_ternary_addressable)      {check_iterator_erase<3,true,false>();}
+TEST(HeapPriorityQueue, iterator_erase_quaternary_stable)        {check_iterator_erase<4,false,true>();}
+TEST(HeapPriorityQueue, iterator_erase_binary_addressable_stable){check_iterator_erase<2,true,true>();}
+
+
+static long long comparisons = 0;
+bool counted_gt(const int& a, const int& b) {++comparisons; return a > b;}
+
+//Erasing every other value in one pass is O(N log N): the old erase re-heaped the whole frontier
+TEST(HeapPriorityQueue, iterator_erase_pass_is_n_log_n) {
+  long long counts[2];
+  for (int k = 0; k < 2; ++k) {
+    ics::HeapPriorityQueue<int,counted_gt> pq;
+    for (int v : some_ints(k == 0 ? 4000 : 16000))
+      pq.enqueue(v);
+    comparisons = 0;
+    bool erase = false;
+    for (auto i = pq.begin(); i != pq.end(); ++i, erase = !erase)
+      if (erase)
+        i.erase();
+    counts[k] = comparisons;
+  }
+  ASSERT_LT(counts[1], 6*counts[0]);       //4x the values: about 4.7x for N log N, 16x if quadratic
+}
+
+
+TEST(HeapPriorityQueue, unordered_iterator) {
+  IntPQ pq;
+  ASSERT_TRUE(pq.unordered_begin() == pq.unordered_end());
+  ASSERT_THROW(*pq.unordered_begin(), ics::IteratorPositionIllegal);
+
+  std::vector<int> v = some_ints(500), seen;
+  for (int x : v)
+    pq.enqueue(x);
+  for (int j = 0; j < 100; ++j)
+    pq.dequeue();
+  for (auto i = pq.unordered_begin(); i != pq.unordered_end(); i++)
+    seen.push_back(*i);
+  std::vector<int> left = pq.top_k(pq.size());
+  std::sort(seen.begin(), seen.end());
+  std::sort(left.begin(), left.end());
+  ASSERT_EQ(left, seen);
+
+  auto i = pq.unordered_begin();
+  ASSERT_EQ(&*i, i.operator->());
+  auto end = pq.unordered_end();
+  ++end;                                    //Stays at the end
+  ASSERT_TRUE(end == pq.unordered_end());
+  ASSERT_THROW(*end, ics::IteratorPositionIllegal);
+
+  pq.enqueue(1);
+  ASSERT_THROW(++i, ics::ConcurrentModificationError);
+  ASSERT_THROW(*i,  ics::ConcurrentModificationError);
+  ASSERT_THROW((void)(i == pq.unordered_end()), ics::ConcurrentModificationError);
+
+  ics::HeapPriorityQueue<int,gt_int> other;
+  ASSERT_THROW((void)(pq.unordered_begin() == other.unordered_begin()), ics::ComparingDifferentIteratorsError);
+}
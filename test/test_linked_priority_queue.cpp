@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "linked_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+typedef ics::LinkedPriorityQueue<int,gt_int> IntPQ;
+
+
+TEST(LinkedPriorityQueue, move_assignment_between_different_heights) {
+  IntPQ tall, flat;
+  for (int i = 0; i < 10000; ++i)
+    tall.enqueue(i);
+  flat.enqueue(1);
+
+  flat = std::move(tall);
+  ASSERT_EQ(10000, flat.size());
+  ASSERT_EQ(1, tall.size());
+  ASSERT_EQ(1, tall.dequeue());
+  for (int i = 0; i < 10000; ++i)
+    tall.enqueue(i);
+
+  tall = std::move(flat);
+  for (int i = 9999; i >= 0; --i)
+    ASSERT_EQ(i, tall.dequeue());
+  for (int i = 9999; i >= 0; --i)
+    ASSERT_EQ(i, flat.dequeue());
+}
+
+
+TEST(LinkedPriorityQueue, functor_and_runtime_gt_agree) {
+  ics::LinkedPriorityQueue<int,ics::undefinedgt<int>,std::greater<int>> functor;
+  ics::LinkedPriorityQueue<int>                                       runtime(gt_int);
+  for (int i = 0; i < 300; ++i) {
+    functor.enqueue(i*7919%300);
+    runtime.enqueue(i*7919%300);
+  }
+  ics::LinkedPriorityQueue<int,ics::undefinedgt<int>,std::greater<int>> copy(functor);
+  ASSERT_EQ(300, copy.size());
+  while (!functor.empty()) {
+    int x = functor.dequeue();
+    ASSERT_EQ(x, runtime.dequeue());
+    ASSERT_EQ(x, copy.dequeue());
+  }
+  ASSERT_TRUE(copy.empty());
+}
+
+
+TEST(LinkedPriorityQueue, initializer_list_constructor_sets_gt) {
+  IntPQ q({3,1,2});
+  ASSERT_EQ(3, q.dequeue());
+  ASSERT_EQ(2, q.dequeue());
+  ASSERT_EQ(1, q.dequeue());
+}
+
+
+typedef std::pair<int,int> Arrival;                  //(priority, arrival order)
+bool gt_priority(const Arrival& a, const Arrival& b) {return a.first > b.first;}
+typedef ics::LinkedPriorityQueue<Arrival,gt_priority> ArrivalPQ;
+
+
+//The values in dequeue order: highest priority first, equal priorities in arrival order
+static std::vector<Arrival> in_order(std::vector<Arrival> values) {
+  std::stable_sort(values.begin(), values.end(), [] (const Arrival& a, const Arrival& b) {return a.first > b.first;});
+  return values;
+}
+
+static std::vector<Arrival> drain(ArrivalPQ& pq) {
+  std::vector<Arrival> values;
+  while (!pq.empty())
+    values.push_back(pq.dequeue());
+  return values;
+}
+
+
+TEST(LinkedPriorityQueue, stable_order_through_index_changes) {
+  unsigned int x = 11;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  int arrivals = 0;
+  for (int trial = 0; trial < 300; ++trial) {
+    ArrivalPQ pq;
+    std::vector<Arrival> model;
+    int range = 1+next(40);
+    for (int ops = next(500); ops > 0; --ops) {
+      int op = next(10);
+      if (op < 6) {
+        Arrival a(next(range), arrivals++);
+        if (op == 5)
+          pq.emplace(a.first, a.second);
+        else
+          pq.enqueue(a);
+        model.push_back(a);
+      } else if (!model.empty()) {
+        Arrival first = in_order(model)[0];
+        ASSERT_EQ(first, pq.peek());
+        ASSERT_EQ(first, pq.dequeue());
+        model.erase(std::find(model.begin(), model.end(), first));
+      }
+      ASSERT_EQ((int)model.size(), pq.size());
+    }
+
+    std::vector<Arrival> iterated;
+    for (const Arrival& a : pq)
+      iterated.push_back(a);
+    ASSERT_EQ(in_order(model), iterated);
+
+    std::vector<Arrival> kept;
+    for (auto i = pq.begin(); i != pq.end(); i++)
+      if (next(3) == 0) {
+        Arrival erased = i.erase();
+        model.erase(std::find(model.begin(), model.end(), erased));
+      } else
+        kept.push_back(*i);
+    ASSERT_EQ(in_order(model), kept);
+
+    for (int i = 0; i < 50; ++i) {           //The index must still be consistent after erasures
+      Arrival a(next(range), arrivals++);
+      pq.enqueue(a);
+      model.push_back(a);
+    }
+    ArrivalPQ copy(pq), assigned;
+    ASSERT_TRUE(pq == copy);
+    assigned = pq;
+    ASSERT_TRUE(pq == assigned);
+    ASSERT_EQ(in_order(model), drain(copy));
+    ASSERT_EQ(in_order(model), drain(assigned));
+    ASSERT_EQ(in_order(model), drain(pq));
+  }
+}
+
+
+TEST(LinkedPriorityQueue, print_and_concurrent_modification) {
+  IntPQ pq({1,3,2});
+  std::ostringstream out;
+  out << pq;
+  ASSERT_EQ("priority_queue[1,2,3]:highest", out.str());
+  auto i = pq.begin();
+  pq.enqueue(4);
+  ASSERT_THROW(++i, ics::ConcurrentModificationError);
+}
+
+
+TEST(LinkedPriorityQueue, large_load) {
+  IntPQ pq;
+  for (int i = 0; i < 200000; ++i)
+    pq.enqueue(i%1000);
+  for (int i = 0; i < 200; ++i)
+    ASSERT_EQ(999, pq.dequeue());
+  ASSERT_EQ(199800, pq.size());
+  pq.clear();
+  ASSERT_TRUE(pq.empty());
+}
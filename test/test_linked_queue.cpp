@@ -0,0 +1,118 @@
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "linked_queue.hpp"
+
+
+typedef ics::LinkedQueue<int> IntQueue;
+
+
+static std::vector<int> values_in(const IntQueue& q) {
+  std::vector<int> values;
+  for (int v : q)
+    values.push_back(v);
+  return values;
+}
+
+
+TEST(LinkedQueue, moved_from_queue_is_empty_and_usable) {
+  IntQueue q{1,2,3};
+  auto i = q.begin();
+  IntQueue moved(std::move(q));
+  ASSERT_EQ(std::vector<int>({1,2,3}), values_in(moved));
+  ASSERT_TRUE(q.empty());
+  ASSERT_EQ(0, q.size());
+  ASSERT_TRUE(q.begin() == q.end());
+  ASSERT_THROW(q.peek(),    ics::EmptyError);
+  ASSERT_THROW(q.dequeue(), ics::EmptyError);
+  ASSERT_THROW(++i,         ics::ConcurrentModificationError);
+  q.enqueue(4);
+  q.enqueue(5);
+  ASSERT_EQ(std::vector<int>({4,5}), values_in(q));
+
+  IntQueue assigned{7,8,9,10};                //Its own list is freed (ASan checks for leaks)
+  assigned = std::move(q);
+  ASSERT_EQ(std::vector<int>({4,5}), values_in(assigned));
+  ASSERT_TRUE(q.empty());
+  q.enqueue(6);
+  ASSERT_EQ(6, q.dequeue());
+  ASSERT_TRUE(q.empty());
+  q = std::move(moved);
+  ASSERT_EQ(std::vector<int>({1,2,3}), values_in(q));
+  ASSERT_EQ(1, q.dequeue());
+  q.enqueue(4);
+  ASSERT_EQ(std::vector<int>({2,3,4}), values_in(q));
+}
+
+
+TEST(LinkedQueue, self_move_assignment_keeps_values) {
+  IntQueue q{1,2,3};
+  IntQueue& same = q;                         //Hides the self-move from -Wself-move
+  q = std::move(same);
+  ASSERT_EQ(std::vector<int>({1,2,3}), values_in(q));
+  q.enqueue(4);
+  ASSERT_EQ(1, q.dequeue());
+  ASSERT_EQ(std::vector<int>({2,3,4}), values_in(q));
+
+  IntQueue empty;
+  IntQueue& same_empty = empty;
+  empty = std::move(same_empty);
+  ASSERT_TRUE(empty.empty());
+}
+
+
+//Counts how its values are made, to check emplace builds in place and nothing is copied
+struct Counted {
+  static int constructed, copied, moved;
+  Counted(int a, const std::string& b) : value(std::to_string(a)+b) {++constructed;}
+  Counted(const Counted& c) : value(c.value)            {++copied;}
+  Counted(Counted&& c)      : value(std::move(c.value)) {++moved;}
+  Counted& operator = (const Counted& c) {value = c.value; ++copied; return *this;}
+  Counted& operator = (Counted&& c)      {value = std::move(c.value); ++moved; return *this;}
+  bool operator == (const Counted& rhs) const {return value == rhs.value;}
+  std::string value;
+};
+int Counted::constructed = 0, Counted::copied = 0, Counted::moved = 0;
+
+
+TEST(LinkedQueue, emplace_constructs_in_place) {
+  ics::LinkedQueue<Counted> q;
+  ASSERT_EQ(1, q.emplace(1, "a"));
+  ASSERT_EQ(1, q.emplace(2, "b"));
+  ASSERT_EQ(2, Counted::constructed);
+  ASSERT_EQ(0, Counted::copied);
+  ASSERT_EQ(0, Counted::moved);
+
+  q.enqueue(Counted(3, "c"));                 //Moved into its node, not copied
+  ASSERT_EQ(0, Counted::copied);
+  ASSERT_EQ(1, Counted::moved);
+  Counted d(4, "d");
+  q.enqueue(d);
+  ASSERT_EQ(1, Counted::copied);
+
+  ics::LinkedQueue<Counted> moved(std::move(q));   //Relinks nodes: no values touched
+  ASSERT_EQ(1, Counted::copied);
+  ASSERT_EQ(1, Counted::moved);
+  ASSERT_EQ("1a", moved.dequeue().value);
+  ASSERT_EQ("2b", moved.peek().value);
+  ASSERT_EQ(1, Counted::copied);
+}
+
+
+TEST(LinkedQueue, emplace_move_only) {
+  ics::LinkedQueue<std::unique_ptr<int>> q;
+  q.emplace(new int(1));
+  q.enqueue(std::unique_ptr<int>(new int(2)));
+  q.emplace();                                //A null unique_ptr
+  ics::LinkedQueue<std::unique_ptr<int>> moved(std::move(q));
+  ASSERT_TRUE(q.empty());
+  ASSERT_EQ(1, *moved.dequeue());
+  ASSERT_EQ(2, *moved.peek());
+  q = std::move(moved);
+  ASSERT_TRUE(moved.empty());
+  ASSERT_EQ(2, *q.dequeue());
+  ASSERT_EQ(nullptr, q.dequeue());
+  ASSERT_TRUE(q.empty());
+}
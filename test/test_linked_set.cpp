@@ -0,0 +1,135 @@
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+#include "linked_set.hpp"
+
+
+typedef ics::LinkedSet<int> IntSet;
+
+
+static std::vector<int> values_in(const IntSet& s) {
+  std::vector<int> values;
+  for (int v : s)
+    values.push_back(v);
+  return values;
+}
+
+
+TEST(LinkedSet, moved_from_set_is_empty_and_usable) {
+  IntSet s{1,2,3};
+  IntSet moved(std::move(s));
+  ASSERT_EQ(std::vector<int>({1,2,3}), values_in(moved));
+  ASSERT_TRUE(s.empty());
+  ASSERT_EQ(0, s.size());
+  ASSERT_FALSE(s.contains(1));
+  ASSERT_TRUE(s.begin() == s.end());
+  ASSERT_EQ(0, s.erase(1));
+  ASSERT_EQ(1, s.insert(4));
+  ASSERT_EQ(0, s.insert(4));
+  ASSERT_EQ(1, s.insert(5));
+  ASSERT_EQ(std::vector<int>({4,5}), values_in(s));
+
+  IntSet assigned{7,8,9,10};                  //Its own list is freed (ASan checks for leaks)
+  assigned = std::move(s);
+  ASSERT_EQ(std::vector<int>({4,5}), values_in(assigned));
+  ASSERT_TRUE(s.empty());
+  ASSERT_EQ(1, s.insert(6));
+  ASSERT_EQ(1, s.erase(6));
+  ASSERT_TRUE(s.empty());
+  s = std::move(moved);
+  ASSERT_EQ(std::vector<int>({1,2,3}), values_in(s));
+  ASSERT_EQ(1, s.erase(3));                   //The last node: insert must still append after 2
+  ASSERT_EQ(1, s.insert(4));
+  ASSERT_EQ(std::vector<int>({1,2,4}), values_in(s));
+  ASSERT_TRUE(moved.empty());
+  ASSERT_TRUE(moved == IntSet());
+}
+
+
+TEST(LinkedSet, self_move_assignment_keeps_values) {
+  IntSet s{1,2,3};
+  IntSet& same = s;                           //Hides the self-move from -Wself-move
+  s = std::move(same);
+  ASSERT_EQ(std::vector<int>({1,2,3}), values_in(s));
+  ASSERT_EQ(1, s.insert(4));
+  ASSERT_EQ(1, s.erase(1));
+  ASSERT_EQ(std::vector<int>({2,3,4}), values_in(s));
+
+  IntSet empty;
+  IntSet& same_empty = empty;
+  empty = std::move(same_empty);
+  ASSERT_TRUE(empty.empty());
+  ASSERT_EQ(1, empty.insert(1));
+}
+
+
+//Counts how its values are made, to check emplace builds in place and nothing is copied
+struct Counted {
+  static int constructed, copied, moved;
+  Counted() {}
+  Counted(int a, const std::string& b) : value(std::to_string(a)+b) {++constructed;}
+  Counted(const Counted& c) : value(c.value)            {++copied;}
+  Counted(Counted&& c)      : value(std::move(c.value)) {++moved;}
+  Counted& operator = (const Counted& c) {value = c.value; ++copied; return *this;}
+  Counted& operator = (Counted&& c)      {value = std::move(c.value); ++moved; return *this;}
+  bool operator == (const Counted& rhs) const {return value == rhs.value;}
+  std::string value;
+};
+int Counted::constructed = 0, Counted::copied = 0, Counted::moved = 0;
+
+
+TEST(LinkedSet, emplace_constructs_in_place) {
+  ics::LinkedSet<Counted> s;
+  ASSERT_EQ(1, s.emplace(1, "a"));
+  ASSERT_EQ(1, s.emplace(2, "b"));
+  ASSERT_EQ(0, s.emplace(1, "a"));            //Already contained: built, compared, deleted
+  ASSERT_EQ(2, s.size());
+  ASSERT_EQ(3, Counted::constructed);
+  ASSERT_EQ(0, Counted::copied);
+  ASSERT_EQ(0, Counted::moved);
+
+  ASSERT_EQ(1, s.insert(Counted(3, "c")));    //Moved into its node, not copied
+  ASSERT_EQ(0, Counted::copied);
+  ASSERT_EQ(1, Counted::moved);
+  ASSERT_EQ(0, s.insert(Counted(3, "c")));    //Not moved when already contained
+  ASSERT_EQ(1, Counted::moved);
+  Counted d(4, "d");
+  ASSERT_EQ(1, s.insert(d));
+  ASSERT_EQ(1, Counted::copied);
+
+  ics::LinkedSet<Counted> moved(std::move(s));     //Relinks nodes: no values touched
+  ASSERT_EQ(1, Counted::copied);
+  ASSERT_EQ(1, Counted::moved);
+  ASSERT_EQ(4, moved.size());
+  ASSERT_TRUE(moved.contains(Counted(2, "b")));
+  ASSERT_TRUE(s.empty());
+}
+
+
+//Move-only, compared by the value it owns
+struct Owned {
+  Owned() {}
+  explicit Owned(int v) : p(new int(v)) {}
+  bool operator == (const Owned& rhs) const {return p == nullptr ? rhs.p == nullptr : rhs.p != nullptr && *p == *rhs.p;}
+  std::unique_ptr<int> p;
+};
+
+
+TEST(LinkedSet, emplace_move_only) {
+  ics::LinkedSet<Owned> s;
+  ASSERT_EQ(1, s.emplace(1));
+  ASSERT_EQ(1, s.insert(Owned(2)));
+  ASSERT_EQ(0, s.emplace(2));
+  ASSERT_EQ(0, s.insert(Owned(1)));
+  ics::LinkedSet<Owned> moved(std::move(s));
+  ASSERT_TRUE(s.empty());
+  ASSERT_EQ(2, moved.size());
+  ASSERT_TRUE(moved.contains(Owned(1)));
+  ASSERT_EQ(1, moved.erase(Owned(1)));
+  s = std::move(moved);
+  ASSERT_TRUE(moved.empty());
+  ASSERT_EQ(1, s.size());
+  ASSERT_EQ(2, *s.begin()->p);
+}
@@ -0,0 +1,43 @@
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "gtest/gtest.h"
+#include "node_pool.hpp"
+
+
+struct Node {
+  Node* next;
+  int   value[6];
+  static void* operator new    (std::size_t)  {return ics::NodePool<sizeof(Node)>::allocate();}
+  static void  operator delete (void* p)      {ics::NodePool<sizeof(Node)>::deallocate(p);}
+};
+
+
+TEST(NodePool, blocks_freed_on_another_thread_are_reused) {
+  //Producer (this thread) allocates, a consumer thread frees: the pool must keep handing
+  //  out the same blocks instead of carving new slabs every round
+  const int live = 100000;
+  std::vector<Node*> nodes(live);
+  std::unordered_set<Node*> distinct;
+  for (int round = 0; round < 30; ++round) {
+    for (Node*& n : nodes) {
+      n = new Node();
+      distinct.insert(n);
+    }
+    std::thread consumer([&nodes] {
+      for (Node* n : nodes)
+        delete n;
+    });
+    consumer.join();
+  }
+  ASSERT_LT(distinct.size(), 2u*live);
+}
+
+
+TEST(NodePool, blocks_freed_on_this_thread_are_reused) {
+  Node* n = new Node();
+  delete n;
+  Node* m = new Node();
+  ASSERT_EQ(n, m);
+  delete m;
+}
@@ -0,0 +1,193 @@
+#include <map>
+#include <string>
+#include <functional>
+#include "gtest/gtest.h"
+#include "open_hash_map.hpp"
+
+
+int hash_int(const int& i) {return i;}
+typedef ics::OpenHashMap<int,int,hash_int> IntMap;
+
+
+TEST(OpenHashMap, subscript_inserts_past_load_threshold) {
+  //Every insertion here goes through operator[], so the table rehashes under it repeatedly
+  IntMap m;
+  for (int i = 0; i < 1000; ++i)
+    m[i] = i*i;
+  ASSERT_EQ(1000, m.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i*i, m[i]);
+}
+
+
+TEST(OpenHashMap, subscript_reference_survives_growth) {
+  IntMap m;
+  for (int i = 0; i < 1000; ++i)
+    m[i] += 1;
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(1, m[i]);
+}
+
+
+static bool has_bins(const IntMap& m, int bins) {
+  return m.str().find("(bins=" + std::to_string(bins) + ",") != std::string::npos;
+}
+
+
+TEST(OpenHashMap, copy_constructor_applies_load_threshold) {
+  IntMap m;
+  for (int i = 0; i < 100; ++i)
+    m.put(i, i);
+  ASSERT_TRUE(has_bins(m, 128));
+
+  IntMap same(m);
+  ASSERT_EQ(m, same);
+  ASSERT_TRUE(has_bins(same, 128));
+
+  IntMap sparser(m, 0.5);                 //100 entries need 256 bins at load 0.5
+  ASSERT_EQ(m, sparser);
+  ASSERT_TRUE(has_bins(sparser, 256));
+  for (int i = 100; i < 1000; ++i)
+    sparser[i] = i;
+  ASSERT_EQ(1000, sparser.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i, sparser[i]);
+}
+
+
+TEST(OpenHashMap, functor_hash) {
+  ics::OpenHashMap<std::string,int,ics::undefinedhash<std::string>,std::hash<std::string>> m;
+  for (int i = 0; i < 5000; ++i)
+    m.put(std::to_string(i), i);
+  ASSERT_EQ(5000, m.size());
+  ASSERT_EQ(77, m["77"]);
+}
+
+
+static int hash_calls = 0;
+int counted_hash(const int& i) {++hash_calls; return i;}
+typedef ics::OpenHashMap<int,int,counted_hash> CountedMap;
+
+
+TEST(OpenHashMap, hashes_each_key_once) {
+  CountedMap m;
+  hash_calls = 0;
+  for (int i = 0; i < 100000; ++i)
+    m.put(i, i);                          //Grows many times: re-placing keys reuses their hashes
+  ASSERT_EQ(100000, hash_calls);
+  for (int i = 100000; i < 200000; ++i)
+    m[i] = i;
+  for (int i = 200000; i < 300000; ++i)
+    m.emplace(i, i);
+  ASSERT_EQ(300000, hash_calls);
+
+  hash_calls = 0;
+  CountedMap copy(m), sparser(m, 0.5), assigned;
+  assigned = m;
+  ASSERT_TRUE(copy == m);
+  ASSERT_TRUE(sparser == m);
+  ASSERT_TRUE(assigned == m);
+  ASSERT_EQ(0, hash_calls);
+
+  hash_calls = 0;
+  m.put(5, 6);                            //Present: one probe, no slot claimed
+  ASSERT_EQ(6, m[5]);
+  ASSERT_TRUE(m.has_key(7));
+  ASSERT_EQ(3, hash_calls);
+}
+
+
+static int count_of(const IntMap& m, const std::string& field) {
+  std::string s = m.str();
+  std::size_t at = s.rfind(field + "=");
+  return std::stoi(s.substr(at + field.size() + 1));
+}
+
+
+TEST(OpenHashMap, erase) {
+  IntMap m;
+  for (int i = 0; i < 100; ++i)
+    m.put(i, -i);
+  ASSERT_EQ(-42, m.erase(42));
+  ASSERT_FALSE(m.has_key(42));
+  ASSERT_EQ(99, m.size());
+  ASSERT_THROW(m.erase(42),  ics::KeyError);
+  ASSERT_THROW(m.erase(500), ics::KeyError);
+  for (int i = 0; i < 100; ++i)
+    if (i != 42)
+      ASSERT_EQ(-i, m[i]);
+  const IntMap& c = m;
+  ASSERT_THROW(c[42], ics::KeyError);
+}
+
+
+TEST(OpenHashMap, tombstones_are_reused) {
+  IntMap m;
+  for (int i = 0; i < 100; ++i)
+    m.put(i, i);
+  int bins = count_of(m, "bins");
+  for (int i = 0; i < 50; ++i)
+    m.erase(i);
+  ASSERT_EQ(50, count_of(m, "deleted"));
+
+  for (int i = 0; i < 50; ++i)            //Same keys, same probe sequences: each lands on its tombstone
+    m.put(i, 2*i);
+  ASSERT_EQ(0, count_of(m, "deleted"));
+  ASSERT_EQ(bins, count_of(m, "bins"));
+  ASSERT_EQ(100, m.size());
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(i < 50 ? 2*i : i, m[i]);
+
+  //Churn far more keys than fit: tombstones are squeezed out instead of growing the table
+  for (int i = 100; i < 100000; ++i) {
+    m.put(i, i);
+    m.erase(i-100);
+  }
+  ASSERT_EQ(100, m.size());
+  ASSERT_EQ(bins, count_of(m, "bins"));
+  for (int i = 99900; i < 100000; ++i)
+    ASSERT_EQ(i, m[i]);
+}
+
+
+TEST(OpenHashMap, grows_past_load_threshold) {
+  IntMap m(0.5);
+  for (int i = 0; i < 5000; ++i) {
+    m.put(i*7919, i);
+    ASSERT_LE(count_of(m, "used") + count_of(m, "deleted"), count_of(m, "bins")/2);
+  }
+  ASSERT_EQ(5000, m.size());
+  ASSERT_TRUE(has_bins(m, 16384));
+  for (int i = 0; i < 5000; ++i)
+    ASSERT_EQ(i, m[i*7919]);
+}
+
+
+TEST(OpenHashMap, iteration_after_erase) {
+  IntMap m;
+  std::map<int,int> model;
+  for (int i = 0; i < 1000; ++i) {
+    m.put(i, i*3);
+    model[i] = i*3;
+  }
+  for (int i = 0; i < 1000; i += 3) {
+    m.erase(i);
+    model.erase(i);
+  }
+  std::map<int,int> seen;
+  for (const auto& e : m)
+    ASSERT_TRUE(seen.insert(std::make_pair(e.first, e.second)).second);
+  ASSERT_EQ(model, seen);
+
+  //Erase through the Iterator, then iterate what is left
+  for (auto i = m.begin(); i != m.end(); ++i)
+    if (i->first % 2 == 0) {
+      model.erase(i->first);
+      i.erase();
+    }
+  seen.clear();
+  for (const auto& e : m)
+    seen[e.first] = e.second;
+  ASSERT_EQ(model, seen);
+  ASSERT_EQ((int)model.size(), m.size());
+}
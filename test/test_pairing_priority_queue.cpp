@@ -0,0 +1,115 @@
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "pairing_priority_queue.hpp"
+
+
+bool gt_int(const int& a, const int& b) {return a > b;}
+typedef ics::PairingPriorityQueue<int,gt_int> IntPQ;
+
+
+static std::vector<int> drain(IntPQ& pq) {
+  std::vector<int> values;
+  while (!pq.empty())
+    values.push_back(pq.dequeue());
+  return values;
+}
+
+
+TEST(PairingPriorityQueue, matches_multiset) {
+  unsigned int x = 7;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  for (int trial = 0; trial < 300; ++trial) {
+    IntPQ pq;
+    std::multiset<int> model;
+    for (int ops = next(400); ops > 0; --ops) {
+      int op = next(10);
+      if (op < 6) {
+        int v = next(100);
+        if (op == 5)
+          pq.emplace(v);
+        else
+          pq.enqueue(v);
+        model.insert(v);
+      } else if (!model.empty()) {
+        ASSERT_EQ(*model.rbegin(), pq.peek());
+        ASSERT_EQ(*model.rbegin(), pq.dequeue());
+        model.erase(std::prev(model.end()));
+      }
+      ASSERT_EQ((int)model.size(), pq.size());
+    }
+
+    std::vector<int> iterated;
+    for (int v : pq)
+      iterated.push_back(v);
+    ASSERT_EQ(std::vector<int>(model.rbegin(), model.rend()), iterated);
+
+    std::vector<int> kept;
+    for (auto i = pq.begin(); i != pq.end(); ++i)
+      if (next(3) == 0)
+        i.erase();
+      else
+        kept.push_back(*i);
+    ASSERT_EQ((int)kept.size(), pq.size());
+    IntPQ copy(pq);
+    ASSERT_EQ(pq, copy);
+    ASSERT_EQ(kept, drain(copy));
+    ASSERT_EQ(kept, drain(pq));
+  }
+}
+
+
+TEST(PairingPriorityQueue, merge) {
+  IntPQ a({3,1,4,1,5}), b({9,2,6});
+  IntPQ copied(a);
+  ASSERT_EQ(3, copied.merge(b));
+  ASSERT_EQ(3, b.size());
+  ASSERT_EQ(3, a.merge(std::move(b)));
+  ASSERT_TRUE(b.empty());
+  ASSERT_EQ(copied, a);
+  ASSERT_EQ(std::vector<int>({9,6,5,4,3,2,1,1}), drain(a));
+
+  IntPQ self({1,2});
+  self.merge(self);
+  ASSERT_EQ(4, self.size());
+  self.merge(std::move(self));
+  ASSERT_EQ(8, self.size());
+}
+
+
+TEST(PairingPriorityQueue, move_and_assignment) {
+  IntPQ pq({1,2,3});
+  IntPQ moved(std::move(pq));
+  ASSERT_TRUE(pq.empty());
+  ASSERT_EQ(3, moved.size());
+  pq = moved;
+  ASSERT_EQ(moved, pq);
+  IntPQ assigned;
+  assigned = std::move(moved);
+  ASSERT_EQ(std::vector<int>({3,2,1}), drain(assigned));
+}
+
+
+TEST(PairingPriorityQueue, print_and_concurrent_modification) {
+  IntPQ pq({1,2,3});
+  std::ostringstream out;
+  out << pq;
+  ASSERT_EQ("priority_queue[1,2,3]:highest", out.str());
+  auto i = pq.begin();
+  pq.enqueue(4);
+  ASSERT_THROW(++i, ics::ConcurrentModificationError);
+}
+
+
+TEST(PairingPriorityQueue, deep_trees_are_copied_and_freed_iteratively) {
+  IntPQ big;
+  for (int i = 0; i < 1000000; ++i)
+    big.enqueue(i);
+  big.dequeue();
+  IntPQ copy(big);
+  ASSERT_EQ(big.size(), copy.size());
+  copy.clear();
+  ASSERT_TRUE(copy.empty());
+}
@@ -0,0 +1,86 @@
+#include <set>
+#include <sstream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "radix_priority_queue.hpp"
+
+
+unsigned long long key_int(const int& a) {return (unsigned long long)a;}
+struct KeyInt {unsigned long long operator () (const int& a) const {return (unsigned long long)a;}};
+typedef ics::RadixPriorityQueue<int,key_int> IntPQ;
+
+
+static std::vector<int> drain(IntPQ& pq) {
+  std::vector<int> values;
+  while (!pq.empty())
+    values.push_back(pq.dequeue());
+  return values;
+}
+
+
+TEST(RadixPriorityQueue, matches_multiset_for_monotone_keys) {
+  unsigned int x = 7;
+  auto next = [&x] (int bound) {x ^= x << 13; x ^= x >> 17; x ^= x << 5; return (int)(x % bound);};
+  for (int trial = 0; trial < 300; ++trial) {
+    IntPQ pq;
+    std::multiset<int> model;
+    int last = 0;
+    for (int ops = next(400); ops > 0; --ops) {
+      int op = next(10);
+      if (op < 6) {
+        int v = last + next(op == 0 ? 5 : 1000);
+        if (op == 5)
+          pq.emplace(v);
+        else
+          pq.enqueue(v);
+        model.insert(v);
+      } else if (op == 6 && last > 0)
+        ASSERT_THROW(pq.enqueue(last-1), ics::KeyError);
+      else if (!model.empty()) {
+        ASSERT_EQ(*model.begin(), pq.peek());
+        last = pq.dequeue();
+        ASSERT_EQ(*model.begin(), last);
+        model.erase(model.begin());
+      }
+      ASSERT_EQ((int)model.size(), pq.size());
+    }
+
+    std::vector<int> iterated;
+    for (int v : pq)
+      iterated.push_back(v);
+    ASSERT_EQ(std::vector<int>(model.begin(), model.end()), iterated);
+
+    std::vector<int> kept;
+    for (auto i = pq.begin(); i != pq.end(); ++i)
+      if (next(3) == 0)
+        i.erase();
+      else
+        kept.push_back(*i);
+    ASSERT_EQ((int)kept.size(), pq.size());
+    IntPQ copy(pq);
+    ASSERT_EQ(pq, copy);
+    ASSERT_EQ(kept, drain(copy));
+
+    IntPQ moved(std::move(pq));
+    ASSERT_TRUE(pq.empty());
+    pq = moved;
+    IntPQ assigned;
+    assigned = std::move(moved);
+    ASSERT_EQ(kept, drain(assigned));
+    ASSERT_EQ(kept, drain(pq));
+  }
+}
+
+
+TEST(RadixPriorityQueue, functor_and_runtime_key) {
+  ics::RadixPriorityQueue<int,ics::undefinedkey<int>,KeyInt> functor({5,1,3});
+  std::ostringstream out;
+  out << functor;
+  ASSERT_EQ("priority_queue[5,3,1]:highest", out.str());
+
+  ics::RadixPriorityQueue<int> runtime(key_int);
+  runtime.enqueue(2000000000);
+  runtime.enqueue(0);
+  ASSERT_EQ(0, runtime.dequeue());
+  ASSERT_EQ(2000000000, runtime.dequeue());
+}